@@ -0,0 +1,56 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+// Runs the measured operation the given number of times.
+typedef void (^KWBenchmarkBlock)(NSUInteger iterations);
+
+@interface KWBenchmarkResult : NSObject
+
+@property (nonatomic, readonly) NSString *name;
+@property (nonatomic, readonly) NSUInteger iterationsPerSample;
+@property (nonatomic, readonly) NSUInteger sampleCount;
+
+// Nanoseconds per operation.
+@property (nonatomic, readonly) double median;
+@property (nonatomic, readonly) double p95;
+
+- (NSDictionary *)dictionaryRepresentation;
+
+@end
+
+@interface KWBenchmark : NSObject
+
+#pragma mark - Initializing
+
++ (instancetype)benchmarkWithName:(NSString *)aName block:(KWBenchmarkBlock)aBlock;
+
+#pragma mark - Properties
+
+@property (nonatomic, readonly) NSString *name;
+
+// Samples are grown by calibration until one takes at least this long.
+@property (nonatomic, assign) NSTimeInterval minimumSampleDuration;
+@property (nonatomic, assign) NSUInteger warmupSampleCount;
+@property (nonatomic, assign) NSUInteger sampleCount;
+
+#pragma mark - Running
+
+- (KWBenchmarkResult *)run;
+
+@end
+
+#pragma mark - Comparing Against Baselines
+
+// Compares results with a baseline of the form
+// {"threshold": 0.25, "benchmarks": {"name": {"median": ns, "p95": ns}}}
+// and returns a description of every benchmark whose median is slower than
+// the baseline by more than the threshold. Benchmarks missing from the
+// baseline are reported too, so that an incomplete baseline fails the run.
+NSArray *KWBenchmarkRegressions(NSArray *results, NSDictionary *baseline, double defaultThreshold);
+
+NSDictionary *KWBenchmarkBaselineWithResults(NSArray *results, double threshold);
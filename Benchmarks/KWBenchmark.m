@@ -0,0 +1,156 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KWBenchmark.h"
+#import <time.h>
+
+static uint64_t KWBenchmarkNanoseconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * NSEC_PER_SEC + (uint64_t)now.tv_nsec;
+}
+
+static double KWBenchmarkNanosecondsSince(uint64_t start) {
+    return (double)(KWBenchmarkNanoseconds() - start);
+}
+
+static int KWBenchmarkCompareSamples(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+@interface KWBenchmarkResult()
+
+@property (nonatomic, readwrite) NSString *name;
+@property (nonatomic, readwrite) NSUInteger iterationsPerSample;
+@property (nonatomic, readwrite) NSUInteger sampleCount;
+@property (nonatomic, readwrite) double median;
+@property (nonatomic, readwrite) double p95;
+
+@end
+
+@implementation KWBenchmarkResult
+
+- (NSDictionary *)dictionaryRepresentation {
+    return @{ @"median": @(self.median), @"p95": @(self.p95) };
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"%-44@ median %10.1f ns  p95 %10.1f ns  (%lu x %lu)",
+            self.name, self.median, self.p95, (unsigned long)self.sampleCount, (unsigned long)self.iterationsPerSample];
+}
+
+@end
+
+@interface KWBenchmark()
+
+@property (nonatomic, readwrite) NSString *name;
+@property (nonatomic, copy) KWBenchmarkBlock block;
+
+@end
+
+@implementation KWBenchmark
+
+#pragma mark - Initializing
+
+- (id)initWithName:(NSString *)aName block:(KWBenchmarkBlock)aBlock {
+    self = [super init];
+    if (self) {
+        _name = [aName copy];
+        _block = [aBlock copy];
+        _minimumSampleDuration = 0.01;
+        _warmupSampleCount = 3;
+        _sampleCount = 25;
+    }
+    return self;
+}
+
++ (instancetype)benchmarkWithName:(NSString *)aName block:(KWBenchmarkBlock)aBlock {
+    return [[self alloc] initWithName:aName block:aBlock];
+}
+
+#pragma mark - Running
+
+- (double)nanosecondsForIterations:(NSUInteger)iterations {
+    @autoreleasepool {
+        uint64_t start = KWBenchmarkNanoseconds();
+        self.block(iterations);
+        return KWBenchmarkNanosecondsSince(start);
+    }
+}
+
+- (NSUInteger)calibratedIterations {
+    NSUInteger iterations = 1;
+    double minimumNanoseconds = self.minimumSampleDuration * NSEC_PER_SEC;
+
+    while ([self nanosecondsForIterations:iterations] < minimumNanoseconds && iterations < (NSUIntegerMax >> 1))
+        iterations <<= 1;
+
+    return iterations;
+}
+
+- (KWBenchmarkResult *)run {
+    NSUInteger iterations = [self calibratedIterations];
+
+    for (NSUInteger i = 0; i < self.warmupSampleCount; ++i)
+        [self nanosecondsForIterations:iterations];
+
+    NSUInteger sampleCount = MAX(self.sampleCount, (NSUInteger)1);
+    double *samples = malloc(sampleCount * sizeof(double));
+
+    for (NSUInteger i = 0; i < sampleCount; ++i)
+        samples[i] = [self nanosecondsForIterations:iterations] / iterations;
+
+    qsort(samples, sampleCount, sizeof(double), KWBenchmarkCompareSamples);
+
+    KWBenchmarkResult *result = [[KWBenchmarkResult alloc] init];
+    result.name = self.name;
+    result.iterationsPerSample = iterations;
+    result.sampleCount = sampleCount;
+    result.median = samples[sampleCount / 2];
+    result.p95 = samples[MIN(sampleCount - 1, (NSUInteger)ceil(sampleCount * 0.95) - 1)];
+    free(samples);
+    return result;
+}
+
+@end
+
+#pragma mark - Comparing Against Baselines
+
+NSArray *KWBenchmarkRegressions(NSArray *results, NSDictionary *baseline, double defaultThreshold) {
+    NSNumber *thresholdNumber = baseline[@"threshold"];
+    double threshold = thresholdNumber != nil ? [thresholdNumber doubleValue] : defaultThreshold;
+    NSDictionary *benchmarks = baseline[@"benchmarks"];
+    NSMutableArray *regressions = [NSMutableArray array];
+
+    for (KWBenchmarkResult *result in results) {
+        double baselineMedian = [benchmarks[result.name][@"median"] doubleValue];
+
+        // A benchmark without a baseline could regress unnoticed.
+        if (baselineMedian <= 0.0) {
+            [regressions addObject:[NSString stringWithFormat:@"%@: no baseline median; record one with --write-baseline", result.name]];
+            continue;
+        }
+
+        double change = result.median / baselineMedian - 1.0;
+        if (change > threshold) {
+            [regressions addObject:[NSString stringWithFormat:@"%@: median %.1f ns is %.0f%% slower than baseline %.1f ns (threshold %.0f%%)",
+                                    result.name, result.median, change * 100.0, baselineMedian, threshold * 100.0]];
+        }
+    }
+
+    return regressions;
+}
+
+NSDictionary *KWBenchmarkBaselineWithResults(NSArray *results, double threshold) {
+    NSMutableDictionary *benchmarks = [NSMutableDictionary dictionary];
+
+    for (KWBenchmarkResult *result in results)
+        benchmarks[result.name] = [result dictionaryRepresentation];
+
+    return @{ @"threshold": @(threshold), @"benchmarks": benchmarks };
+}
@@ -0,0 +1,44 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+// The shape of a synthetic spec: a describe block with nested contexts,
+// each of which declares lets and examples. Every example installs stubs
+// and checks expectations. generate_spec.rb writes the same shape as
+// SPEC_BEGIN/SPEC_END source.
+typedef struct KWSpecShape {
+    NSUInteger contexts;      // child contexts per context
+    NSUInteger depth;         // levels of nested contexts
+    NSUInteger lets;          // lets per context
+    NSUInteger examples;      // examples per context
+    NSUInteger stubs;         // stubs per example
+    NSUInteger expectations;  // expectations per example
+} KWSpecShape;
+
+NSUInteger KWSpecShapeContextCount(KWSpecShape shape);
+NSUInteger KWSpecShapeExampleCount(KWSpecShape shape);
+
+@interface KWScaleMeasurement : NSObject
+
+@property (nonatomic, readonly) NSUInteger exampleCount;
+
+// Time spent in +[KWSpec testInvocations] building the suite.
+@property (nonatomic, readonly) NSTimeInterval buildDuration;
+
+// Growth of the memory footprint of the process while building.
+@property (nonatomic, readonly) uint64_t buildFootprint;
+
+// Time spent running all examples.
+@property (nonatomic, readonly) NSTimeInterval runDuration;
+
+// Time spent releasing the suite and its test cases.
+@property (nonatomic, readonly) NSTimeInterval teardownDuration;
+
+@end
+
+// Builds a spec of the given shape, runs every example and tears it down.
+KWScaleMeasurement *KWMeasureSpecOfShape(KWSpecShape shape);
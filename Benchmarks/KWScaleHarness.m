@@ -0,0 +1,168 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KWScaleHarness.h"
+#import <Kiwi/Kiwi.h>
+#import <objc/runtime.h>
+
+#if defined(__APPLE__)
+#import <mach/mach.h>
+#else
+#import <unistd.h>
+#endif
+
+NSUInteger KWSpecShapeContextCount(KWSpecShape shape) {
+    NSUInteger count = 1;
+    NSUInteger levelCount = 1;
+
+    for (NSUInteger level = 0; level < shape.depth; ++level) {
+        levelCount *= shape.contexts;
+        count += levelCount;
+    }
+
+    return count;
+}
+
+NSUInteger KWSpecShapeExampleCount(KWSpecShape shape) {
+    return KWSpecShapeContextCount(shape) * shape.examples;
+}
+
+static uint64_t KWProcessFootprint(void) {
+#if defined(__APPLE__)
+    task_vm_info_data_t info;
+    mach_msg_type_number_t count = TASK_VM_INFO_COUNT;
+
+    if (task_info(mach_task_self(), TASK_VM_INFO, (task_info_t)&info, &count) != KERN_SUCCESS)
+        return 0;
+
+    return info.phys_footprint;
+#else
+    // Elsewhere the resident set size stands in for the footprint.
+    unsigned long long size = 0;
+    unsigned long long resident = 0;
+    FILE *statm = fopen("/proc/self/statm", "r");
+
+    if (statm == NULL)
+        return 0;
+
+    if (fscanf(statm, "%llu %llu", &size, &resident) != 2)
+        resident = 0;
+
+    fclose(statm);
+    return (uint64_t)resident * (uint64_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+// Lets write their values through a pointer before every example, so each
+// needs storage that lives as long as the spec. Values are written through
+// an autoreleasing reference and are not owned by the slot.
+typedef struct KWLetSlots {
+    void **values;
+    NSUInteger next;
+} KWLetSlots;
+
+static void KWBuildContextOfShape(KWSpecShape shape, NSUInteger level, KWLetSlots *slots) {
+    // Every let in a context needs a name of its own, which the let() macro
+    // cannot give inside a loop.
+    for (NSUInteger i = 0; i < shape.lets; ++i) {
+        __autoreleasing id *objectRef = (__autoreleasing id *)(void *)&slots->values[slots->next++];
+        letWithCallSite(nil, objectRef, [NSString stringWithFormat:@"value%lu", (unsigned long)i], ^{ return @(i); });
+    }
+
+    for (NSUInteger i = 0; i < shape.examples; ++i) {
+        it([NSString stringWithFormat:@"does thing %lu", (unsigned long)i], ^{
+            for (NSUInteger j = 0; j < shape.stubs; ++j) {
+                NSObject *object = [[NSObject alloc] init];
+                [object stub:@selector(description) andReturn:@"stubbed"];
+            }
+
+            for (NSUInteger j = 0; j < shape.expectations; ++j)
+                [[theValue(j) should] equal:theValue(j)];
+        });
+    }
+
+    if (level == shape.depth)
+        return;
+
+    for (NSUInteger i = 0; i < shape.contexts; ++i) {
+        context([NSString stringWithFormat:@"context %lu", (unsigned long)i], ^{
+            KWBuildContextOfShape(shape, level + 1, slots);
+        });
+    }
+}
+
+// The spec class is built once and measured once, so the let slots it
+// returns can be freed as soon as the measurement is over.
+static Class KWSpecClassOfShape(KWSpecShape shape, void ***letValues) {
+    static NSUInteger specCount = 0;
+    NSString *name = [NSString stringWithFormat:@"KWScaleSpec%lu", (unsigned long)++specCount];
+    Class specClass = objc_allocateClassPair([KWSpec class], [name UTF8String], 0);
+    void **values = calloc(MAX(KWSpecShapeContextCount(shape) * shape.lets, 1), sizeof(void *));
+
+    IMP buildExampleGroups = imp_implementationWithBlock(^(id specClass) {
+        KWLetSlots slots = { values, 0 };
+
+        describe(@"Scale", ^{
+            KWBuildContextOfShape(shape, 0, &slots);
+        });
+    });
+    class_addMethod(object_getClass(specClass), @selector(buildExampleGroups), buildExampleGroups, "v@:");
+    objc_registerClassPair(specClass);
+    *letValues = values;
+    return specClass;
+}
+
+@interface KWScaleMeasurement()
+
+@property (nonatomic, readwrite) NSUInteger exampleCount;
+@property (nonatomic, readwrite) NSTimeInterval buildDuration;
+@property (nonatomic, readwrite) uint64_t buildFootprint;
+@property (nonatomic, readwrite) NSTimeInterval runDuration;
+@property (nonatomic, readwrite) NSTimeInterval teardownDuration;
+
+@end
+
+@implementation KWScaleMeasurement
+
+@end
+
+KWScaleMeasurement *KWMeasureSpecOfShape(KWSpecShape shape) {
+    KWScaleMeasurement *measurement = [[KWScaleMeasurement alloc] init];
+    void **letValues = NULL;
+    Class specClass = KWSpecClassOfShape(shape, &letValues);
+    CFAbsoluteTime start;
+
+    @autoreleasepool {
+        NSMutableArray *testCases = [NSMutableArray array];
+
+        @autoreleasepool {
+            uint64_t footprint = KWProcessFootprint();
+            start = CFAbsoluteTimeGetCurrent();
+            NSArray *invocations = [specClass testInvocations];
+            measurement.buildDuration = CFAbsoluteTimeGetCurrent() - start;
+            measurement.buildFootprint = KWProcessFootprint() - footprint;
+            measurement.exampleCount = [invocations count];
+
+            for (NSInvocation *invocation in invocations)
+                [testCases addObject:[specClass testCaseWithInvocation:invocation]];
+        }
+
+        start = CFAbsoluteTimeGetCurrent();
+
+        for (XCTestCase *testCase in testCases) {
+            @autoreleasepool {
+                [testCase.invocation invokeWithTarget:testCase];
+            }
+        }
+
+        measurement.runDuration = CFAbsoluteTimeGetCurrent() - start;
+        start = CFAbsoluteTimeGetCurrent();
+    }
+
+    measurement.teardownDuration = CFAbsoluteTimeGetCurrent() - start;
+    free(letValues);
+    return measurement;
+}
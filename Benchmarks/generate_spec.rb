@@ -0,0 +1,68 @@
+#!/usr/bin/ruby
+#
+# Writes a synthetic SPEC_BEGIN/SPEC_END spec of a configurable shape, for
+# trying suite building and running at scale in a real test target. The
+# shape matches KWSpecShape in KWScaleHarness.h.
+#
+#   ruby Benchmarks/generate_spec.rb --contexts 10 --depth 2 --examples 9 > ScaleSpec.m
+
+require 'optparse'
+
+options = {
+  name: 'GeneratedScaleSpec',
+  contexts: 10,
+  depth: 2,
+  lets: 2,
+  examples: 9,
+  stubs: 1,
+  expectations: 1,
+}
+
+OptionParser.new do |parser|
+  parser.banner = 'usage: generate_spec.rb [options]'
+  parser.on('--name NAME', 'spec class name') { |v| options[:name] = v }
+  %i[contexts depth lets examples stubs expectations].each do |key|
+    parser.on("--#{key} N", Integer, "#{key} (default #{options[key]})") { |v| options[key] = v }
+  end
+end.parse!
+
+def write_context(out, options, level, indent)
+  pad = '    ' * indent
+
+  options[:lets].times do |i|
+    out.puts "#{pad}let(value#{i}, ^{ return @#{i}; });"
+  end
+
+  options[:examples].times do |i|
+    out.puts "#{pad}it(@\"does thing #{i}\", ^{"
+    options[:stubs].times do
+      out.puts "#{pad}    [[NSObject new] stub:@selector(description) andReturn:@\"stubbed\"];"
+    end
+    options[:expectations].times do |j|
+      out.puts "#{pad}    [[theValue(#{j}) should] equal:theValue(#{j})];"
+    end
+    out.puts "#{pad}});"
+  end
+
+  return if level == options[:depth]
+
+  options[:contexts].times do |i|
+    out.puts "#{pad}context(@\"context #{i}\", ^{"
+    write_context(out, options, level + 1, indent + 1)
+    out.puts "#{pad}});"
+  end
+end
+
+contexts = (0..options[:depth]).sum { |level| options[:contexts]**level }
+out = $stdout
+out.puts "// Generated by generate_spec.rb: #{contexts * options[:examples]} examples in #{contexts} contexts."
+out.puts
+out.puts '#import <Kiwi/Kiwi.h>'
+out.puts
+out.puts "SPEC_BEGIN(#{options[:name]})"
+out.puts
+out.puts 'describe(@"Scale", ^{'
+write_context(out, options, 0, 1)
+out.puts '});'
+out.puts
+out.puts 'SPEC_END'
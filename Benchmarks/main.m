@@ -0,0 +1,300 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+// Microbenchmarks for the mocking and matching engine, run outside of
+// XCTest. Usage:
+//
+//   KiwiBenchmarks [--baseline <path>] [--write-baseline <path>]
+//                  [--threshold <fraction>] [--filter <substring>]
+//
+// Exits with status 1 when a benchmark is slower than its baseline by more
+// than the threshold, or has no baseline. Exits with status 2 when the
+// baseline has no benchmarks at all; record one with --write-baseline.
+//
+//   KiwiBenchmarks --scale [--sizes 1000,10000,100000] [--contexts n]
+//                  [--depth n] [--lets n] [--stubs n] [--expectations n]
+//
+// Builds, runs and tears down synthetic specs of growing size and reports
+// how each cost grows with the number of examples.
+//
+
+#import <Kiwi/Kiwi.h>
+#import "KWBenchmark.h"
+#import "KWIntercept.h"
+#import "KWProbePoller.h"
+#import "KWScaleHarness.h"
+#import "NSInvocation+KiwiAdditions.h"
+
+static const double KWBenchmarkDefaultThreshold = 0.25;
+
+@interface KWBenchmarkSubject : NSObject
+
+- (NSUInteger)valueAtIndex:(NSUInteger)anIndex;
+- (BOOL)containsRange:(NSRange)aRange;
+
+@end
+
+@implementation KWBenchmarkSubject
+
+- (NSUInteger)valueAtIndex:(NSUInteger)anIndex {
+    return anIndex;
+}
+
+- (BOOL)containsRange:(NSRange)aRange {
+    return NO;
+}
+
+@end
+
+// Satisfied by the first sample, so polling measures a single round trip
+// through the poller.
+@interface KWBenchmarkProbe : NSObject<KWProbe>
+
+@property (nonatomic, assign) BOOL sampled;
+
+@end
+
+@implementation KWBenchmarkProbe
+
+- (BOOL)isSatisfied {
+    return self.sampled;
+}
+
+- (void)sample {
+    self.sampled = YES;
+}
+
+@end
+
+static KWBenchmark *KWMockDispatchBenchmark(NSUInteger stubCount) {
+    KWBenchmarkSubject *mock = [KWMock mockForClass:[KWBenchmarkSubject class]];
+
+    for (NSUInteger i = 0; i < stubCount; ++i)
+        [(id)mock stub:@selector(valueAtIndex:) andReturn:theValue(i) withArguments:theValue(i)];
+
+    // The last stub is the one found last.
+    NSUInteger index = stubCount - 1;
+    NSString *name = [NSString stringWithFormat:@"mock dispatch, %lu stub%@", (unsigned long)stubCount, stubCount == 1 ? @"" : @"s"];
+    return [KWBenchmark benchmarkWithName:name block:^(NSUInteger iterations) {
+        for (NSUInteger i = 0; i < iterations; ++i)
+            [mock valueAtIndex:index];
+    }];
+}
+
+static NSArray *KWBenchmarks(void) {
+    NSMutableArray *benchmarks = [NSMutableArray array];
+    KWBenchmarkSubject *subject = [[KWBenchmarkSubject alloc] init];
+    KWMatcherFactory *matcherFactory = [[KWMatcherFactory alloc] init];
+    [matcherFactory registerMatcherClassesWithNamespacePrefix:@"KW"];
+
+    for (NSNumber *stubCount in @[@1, @10, @100])
+        [benchmarks addObject:KWMockDispatchBenchmark([stubCount unsignedIntegerValue])];
+
+    {
+        NSUInteger index = 42;
+        NSInvocation *invocation = [NSInvocation invocationWithTarget:subject selector:@selector(valueAtIndex:) messageArguments:&index];
+        KWMessagePattern *messagePattern = [KWMessagePattern messagePatternWithSelector:@selector(valueAtIndex:) argumentFilters:@[theValue(index)]];
+        [benchmarks addObject:[KWBenchmark benchmarkWithName:@"message pattern match, scalar argument" block:^(NSUInteger iterations) {
+            for (NSUInteger i = 0; i < iterations; ++i)
+                [messagePattern matchesInvocation:invocation];
+        }]];
+    }
+
+    {
+        NSRange range = NSMakeRange(1, 2);
+        NSInvocation *invocation = [NSInvocation invocationWithTarget:subject selector:@selector(containsRange:) messageArguments:&range];
+        KWMessagePattern *messagePattern = [KWMessagePattern messagePatternWithSelector:@selector(containsRange:) argumentFilters:@[theValue(range)]];
+        [benchmarks addObject:[KWBenchmark benchmarkWithName:@"message pattern match, struct argument" block:^(NSUInteger iterations) {
+            for (NSUInteger i = 0; i < iterations; ++i)
+                [messagePattern matchesInvocation:invocation];
+        }]];
+    }
+
+    {
+        NSMethodSignature *signature = [matcherFactory methodSignatureForMatcherSelector:@selector(equal:)];
+        NSInvocation *invocation = [NSInvocation invocationWithMethodSignature:signature];
+        [invocation setSelector:@selector(equal:)];
+        [benchmarks addObject:[KWBenchmark benchmarkWithName:@"matcher factory lookup" block:^(NSUInteger iterations) {
+            for (NSUInteger i = 0; i < iterations; ++i)
+                [matcherFactory matcherFromInvocation:invocation subject:@42];
+        }]];
+    }
+
+    {
+        // Verifiers report to and are tracked by an example, as they are
+        // when -should is sent in a spec.
+        KWExample *example = [[KWExample alloc] initWithExampleNode:nil];
+        [benchmarks addObject:[KWBenchmark benchmarkWithName:@"should equal:" block:^(NSUInteger iterations) {
+            for (NSUInteger i = 0; i < iterations; ++i) {
+                KWMatchVerifier *verifier = [[KWMatchVerifier alloc] initForShouldWithCallSite:nil matcherFactory:matcherFactory reporter:example];
+                [example addVerifier:verifier];
+                example.unresolvedVerifier = verifier;
+                verifier.subject = @42;
+                [(id)verifier equal:@42];
+            }
+        }]];
+    }
+
+    [benchmarks addObject:[KWBenchmark benchmarkWithName:@"intercept setup and teardown" block:^(NSUInteger iterations) {
+        for (NSUInteger i = 0; i < iterations; ++i) {
+            KWBenchmarkSubject *stubbedSubject = [[KWBenchmarkSubject alloc] init];
+            [stubbedSubject stub:@selector(valueAtIndex:) andReturn:theValue(7)];
+            [stubbedSubject valueAtIndex:0];
+            KWClearStubsAndSpies();
+        }
+    }]];
+
+    [benchmarks addObject:[KWBenchmark benchmarkWithName:@"probe poller latency" block:^(NSUInteger iterations) {
+        for (NSUInteger i = 0; i < iterations; ++i) {
+            KWProbePoller *poller = [[KWProbePoller alloc] initWithTimeout:1.0 delay:0.0 shouldWait:NO];
+            [poller check:[[KWBenchmarkProbe alloc] init]];
+        }
+    }]];
+
+    return benchmarks;
+}
+
+static void KWBenchmarkUsage(void) {
+    fprintf(stderr, "usage: KiwiBenchmarks [--baseline <path>] [--write-baseline <path>] [--threshold <fraction>] [--filter <substring>]\n"
+                    "       KiwiBenchmarks --scale [--sizes <n,n,...>] [--contexts <n>] [--depth <n>] [--lets <n>] [--stubs <n>] [--expectations <n>]\n");
+}
+
+// Growth exponent of y between two sizes: 1 is linear, 2 is quadratic.
+static double KWGrowthExponent(double y1, double y2, double n1, double n2) {
+    if (y1 <= 0.0 || y2 <= 0.0 || n1 == n2)
+        return 0.0;
+
+    return log(y2 / y1) / log(n2 / n1);
+}
+
+static void KWRunScale(KWSpecShape shape, NSArray *sizes) {
+    printf("%10s %12s %8s %12s %8s %14s %8s %12s %8s\n",
+           "examples", "build (s)", "growth", "memory (MB)", "growth", "per example", "growth", "teardown (s)", "growth");
+
+    KWScaleMeasurement *previous = nil;
+
+    for (NSNumber *size in sizes) {
+        // Contexts are fixed by the shape; examples per context make up the size.
+        shape.examples = MAX((NSUInteger)1, [size unsignedIntegerValue] / KWSpecShapeContextCount(shape));
+        KWScaleMeasurement *measurement = KWMeasureSpecOfShape(shape);
+        double n = measurement.exampleCount;
+        double m = previous.exampleCount;
+
+        printf("%10lu %12.3f %8.2f %12.1f %8.2f %11.1f us %8.2f %12.3f %8.2f\n",
+               (unsigned long)measurement.exampleCount,
+               measurement.buildDuration, KWGrowthExponent(previous.buildDuration, measurement.buildDuration, m, n),
+               measurement.buildFootprint / 1048576.0, KWGrowthExponent(previous.buildFootprint, measurement.buildFootprint, m, n),
+               measurement.runDuration / n * 1e6, KWGrowthExponent(previous.runDuration, measurement.runDuration, m, n),
+               measurement.teardownDuration, KWGrowthExponent(previous.teardownDuration, measurement.teardownDuration, m, n));
+        fflush(stdout);
+        previous = measurement;
+    }
+}
+
+int main(int argc, const char *argv[]) {
+    @autoreleasepool {
+        NSString *baselinePath = nil;
+        NSString *writeBaselinePath = nil;
+        NSString *filter = nil;
+        double threshold = KWBenchmarkDefaultThreshold;
+        BOOL thresholdGiven = NO;
+        BOOL scale = NO;
+        NSArray *sizes = @[@1000, @10000, @100000];
+        KWSpecShape shape = { .contexts = 10, .depth = 2, .lets = 2, .examples = 1, .stubs = 1, .expectations = 1 };
+
+        for (int i = 1; i < argc; ++i) {
+            NSString *argument = @(argv[i]);
+            NSString *value = i + 1 < argc ? @(argv[i + 1]) : nil;
+
+            if ([argument isEqualToString:@"--scale"]) {
+                scale = YES;
+                continue;
+            }
+
+            if (value != nil && [argument isEqualToString:@"--baseline"]) {
+                baselinePath = value;
+            } else if (value != nil && [argument isEqualToString:@"--write-baseline"]) {
+                writeBaselinePath = value;
+            } else if (value != nil && [argument isEqualToString:@"--threshold"]) {
+                threshold = [value doubleValue];
+                thresholdGiven = YES;
+            } else if (value != nil && [argument isEqualToString:@"--filter"]) {
+                filter = value;
+            } else if (value != nil && [argument isEqualToString:@"--sizes"]) {
+                sizes = [[value componentsSeparatedByString:@","] valueForKey:@"integerValue"];
+            } else if (value != nil && [argument isEqualToString:@"--contexts"]) {
+                shape.contexts = (NSUInteger)[value integerValue];
+            } else if (value != nil && [argument isEqualToString:@"--depth"]) {
+                shape.depth = (NSUInteger)[value integerValue];
+            } else if (value != nil && [argument isEqualToString:@"--lets"]) {
+                shape.lets = (NSUInteger)[value integerValue];
+            } else if (value != nil && [argument isEqualToString:@"--stubs"]) {
+                shape.stubs = (NSUInteger)[value integerValue];
+            } else if (value != nil && [argument isEqualToString:@"--expectations"]) {
+                shape.expectations = (NSUInteger)[value integerValue];
+            } else {
+                KWBenchmarkUsage();
+                return 2;
+            }
+
+            ++i;
+        }
+
+        if (scale) {
+            KWRunScale(shape, sizes);
+            return 0;
+        }
+
+        NSMutableArray *results = [NSMutableArray array];
+
+        for (KWBenchmark *benchmark in KWBenchmarks()) {
+            if (filter != nil && [benchmark.name rangeOfString:filter].location == NSNotFound)
+                continue;
+
+            KWBenchmarkResult *result = [benchmark run];
+            [results addObject:result];
+            printf("%s\n", [[result description] UTF8String]);
+        }
+
+        if (writeBaselinePath != nil) {
+            NSData *data = [NSJSONSerialization dataWithJSONObject:KWBenchmarkBaselineWithResults(results, threshold) options:NSJSONWritingPrettyPrinted error:nil];
+            if (![data writeToFile:writeBaselinePath atomically:YES]) {
+                fprintf(stderr, "could not write baseline to %s\n", [writeBaselinePath UTF8String]);
+                return 2;
+            }
+        }
+
+        if (baselinePath == nil)
+            return 0;
+
+        NSData *data = [NSData dataWithContentsOfFile:baselinePath];
+        NSDictionary *baseline = data != nil ? [NSJSONSerialization JSONObjectWithData:data options:0 error:nil] : nil;
+
+        if (![baseline isKindOfClass:[NSDictionary class]]) {
+            fprintf(stderr, "could not read baseline from %s\n", [baselinePath UTF8String]);
+            return 2;
+        }
+
+        NSDictionary *baselineBenchmarks = baseline[@"benchmarks"];
+
+        if (![baselineBenchmarks isKindOfClass:[NSDictionary class]] || [baselineBenchmarks count] == 0) {
+            fprintf(stderr, "baseline %s has no benchmarks; record one with make benchmark-baseline\n", [baselinePath UTF8String]);
+            return 2;
+        }
+
+        if (thresholdGiven) {
+            NSMutableDictionary *overridden = [baseline mutableCopy];
+            overridden[@"threshold"] = @(threshold);
+            baseline = overridden;
+        }
+
+        NSArray *regressions = KWBenchmarkRegressions(results, baseline, threshold);
+
+        for (NSString *regression in regressions)
+            fprintf(stderr, "regression: %s\n", [regression UTF8String]);
+
+        return [regressions count] > 0 ? 1 : 0;
+    }
+}
@@ -9,6 +9,9 @@
 #import <XCTest/XCTestSuite.h>
 #import <objc/runtime.h>
 #import "KWSuiteConfigurationBase.h"
+#import "KWCounters.h"
+#import "KWFailedExamples.h"
+#import "KWResultReporter.h"
 
 @interface _KWAllTestsSuite : XCTestSuite
 @end
@@ -22,6 +25,15 @@
 
 - (void)tearDown {
     [[KWSuiteConfigurationBase defaultConfiguration] tearDown];
+    KWWriteFailedExamples();
+    [[KWResultReporter sharedReporter] finishReporting];
+
+    if (KWCountersShouldLog()) {
+        uint64_t counters[KWCounterCount];
+        KWCountersRead(counters);
+        NSLog(@"Kiwi run counters: %@", KWCountersDescription(counters));
+    }
+
     [super tearDown];
 }
 
@@ -6,6 +6,8 @@
 
 #import "KiwiConfiguration.h"
 
+@class KWMatcherResolution;
+
 @interface KWCallSite : NSObject
 
 #pragma mark - Initializing
@@ -18,9 +20,24 @@
 
 @property (nonatomic, readonly, copy) NSString *filename;
 @property (nonatomic, readonly) NSUInteger lineNumber;
+@property (nonatomic, readonly, getter=isInterned) BOOL interned;
+
+#pragma mark - Caching Matcher Resolutions
+
+// The matcher a match verifier last resolved for the expectation at this call
+// site. Only interned call sites keep one.
+@property (atomic, strong) KWMatcherResolution *matcherResolution;
 
 #pragma mark - Identifying and Comparing
 
 - (BOOL)isEqualToCallSite:(KWCallSite *)aCallSite;
 
 @end
+
+#pragma mark - Interning Call Sites
+
+// Returns the one call site for a source location, which is never
+// deallocated. Interned call sites are equal only if they are identical.
+// KW_THIS_CALLSITE keeps the result in a static variable, so an expectation
+// that runs many times looks its call site up once.
+KWCallSite *KWInternedCallSite(const char *filename, NSUInteger lineNumber);
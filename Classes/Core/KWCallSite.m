@@ -5,6 +5,15 @@
 //
 
 #import "KWCallSite.h"
+#import <pthread.h>
+
+@interface KWCallSite() {
+    NSUInteger _hash;
+}
+
+@property (nonatomic, readwrite, getter=isInterned) BOOL interned;
+
+@end
 
 @implementation KWCallSite
 
@@ -15,6 +24,7 @@
     if (self) {
         _filename = [aFilename copy];
         _lineNumber = aLineNumber;
+        _hash = [_filename hash] ^ (aLineNumber * 2654435761u);
     }
 
     return self;
@@ -27,7 +37,7 @@
 #pragma mark - Identifying and Comparing
 
 - (NSUInteger)hash {
-    return [[NSString stringWithFormat:@"%@%u", self.filename, (unsigned)self.lineNumber] hash];
+    return _hash;
 }
 
 - (BOOL)isEqual:(id)anObject {
@@ -38,7 +48,39 @@
 }
 
 - (BOOL)isEqualToCallSite:(KWCallSite *)aCallSite {
-    return [self.filename isEqualToString:aCallSite.filename] && (self.lineNumber == aCallSite.lineNumber);
+    if (self == aCallSite)
+        return YES;
+
+    if (self.interned && aCallSite.interned)
+        return NO;
+
+    return (self.lineNumber == aCallSite.lineNumber) && [self.filename isEqualToString:aCallSite.filename];
 }
 
 @end
+
+#pragma mark - Interning Call Sites
+
+static pthread_mutex_t KWInternedCallSitesLock = PTHREAD_MUTEX_INITIALIZER;
+static NSMutableSet *KWInternedCallSites = nil;
+
+KWCallSite *KWInternedCallSite(const char *filename, NSUInteger lineNumber) {
+    KWCallSite *callSite = [KWCallSite callSiteWithFilename:@(filename) lineNumber:lineNumber];
+    pthread_mutex_lock(&KWInternedCallSitesLock);
+
+    if (KWInternedCallSites == nil)
+        KWInternedCallSites = [[NSMutableSet alloc] init];
+
+    // Several files can use the same source location through a header, so
+    // the set is keyed by contents rather than by the address of __FILE__.
+    KWCallSite *internedCallSite = [KWInternedCallSites member:callSite];
+
+    if (internedCallSite == nil) {
+        callSite.interned = YES;
+        [KWInternedCallSites addObject:callSite];
+        internedCallSite = callSite;
+    }
+
+    pthread_mutex_unlock(&KWInternedCallSitesLock);
+    return internedCallSite;
+}
@@ -0,0 +1,13 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KWFileReporter.h"
+
+// Writes one line per example, in the format of the lines Kiwi logs, and
+// failures in the "file:line: error: message" format Xcode recognizes.
+@interface KWConsoleReporter : KWFileReporter
+
+@end
@@ -0,0 +1,28 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KWConsoleReporter.h"
+#import "KWCallSite.h"
+#import "KWExampleResult.h"
+#import "KWFailure.h"
+
+@implementation KWConsoleReporter
+
+#pragma mark - Reporting Results
+
+- (void)reportFailure:(KWFailure *)failure {
+    if (failure.callSite != nil)
+        [self writeString:[NSString stringWithFormat:@"%@:%lu: ", failure.callSite.filename, (unsigned long)failure.callSite.lineNumber]];
+
+    [self writeString:[NSString stringWithFormat:@"error: %@\n", failure.message]];
+}
+
+- (void)reportResult:(KWExampleResult *)aResult {
+    static NSString * const labels[] = { @"PASSED", @"FAILED", @"PENDING" };
+    [self writeString:[NSString stringWithFormat:@"+ '%@' [%@] (%.3f s)\n", aResult.exampleDescription, labels[aResult.status], aResult.duration]];
+}
+
+@end
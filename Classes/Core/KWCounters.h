@@ -0,0 +1,50 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KiwiConfiguration.h"
+
+// Counters of work done by the mocking and matching engine, used to tell
+// the time spent in Kiwi apart from the time spent in the code under test.
+typedef NS_ENUM(NSUInteger, KWCounter) {
+    KWCounterMockInvocations,
+    KWCounterInterceptedInvocations,
+    KWCounterMessagePatternMatchAttempts,
+    KWCounterMessagePatternMatches,
+    KWCounterArgumentFiltersEvaluated,
+    KWCounterStubsInstalled,
+    KWCounterSpiesInstalled,
+    KWCounterInterceptClassesCreated,
+    KWCounterMatchersAllocated,
+    KWCounterVerifiersAllocated,
+    KWCounterProbePolls,
+    KWCounterRunLoopSpins,
+    KWCounterValueBoxings,
+    KWCounterCount
+};
+
+#pragma mark - Counting
+
+// Every thread counts into counters of its own, so counting never waits for
+// other threads. Counts are summed over all threads when they are read.
+void KWCounterIncrement(KWCounter counter);
+
+#pragma mark - Reading Counters
+
+// Writes the current totals into values, which must hold KWCounterCount
+// entries.
+void KWCountersRead(uint64_t *values);
+
+NSString *KWCounterName(KWCounter counter);
+
+// Returns the counts in values as numbers keyed by counter name.
+NSDictionary *KWCountersDictionary(const uint64_t *values);
+
+// Returns the counts in values as "name=count" pairs in counter order.
+NSString *KWCountersDescription(const uint64_t *values);
+
+// Returns YES when the KW_COUNTERS environment variable asks for counters
+// to be logged after every example and at the end of the run.
+BOOL KWCountersShouldLog(void);
@@ -0,0 +1,119 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KWCounters.h"
+#import <stdatomic.h>
+
+typedef struct KWThreadCounters {
+    _Atomic(uint64_t) values[KWCounterCount];
+    struct KWThreadCounters *next;
+} KWThreadCounters;
+
+// Counters of threads that have exited stay on the list, so their counts
+// are still part of the totals.
+static _Atomic(KWThreadCounters *) KWThreadCountersList = NULL;
+static __thread KWThreadCounters *KWCurrentThreadCounters = NULL;
+
+static KWThreadCounters *KWThreadCountersCreate(void) {
+    KWThreadCounters *counters = calloc(1, sizeof(KWThreadCounters));
+
+    if (counters == NULL)
+        [NSException raise:NSMallocException format:@"could not allocate counters"];
+
+    KWThreadCounters *head = atomic_load_explicit(&KWThreadCountersList, memory_order_relaxed);
+    do {
+        counters->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&KWThreadCountersList, &head, counters, memory_order_release, memory_order_relaxed));
+
+    KWCurrentThreadCounters = counters;
+    return counters;
+}
+
+#pragma mark - Counting
+
+void KWCounterIncrement(KWCounter counter) {
+    KWThreadCounters *counters = KWCurrentThreadCounters;
+
+    if (counters == NULL)
+        counters = KWThreadCountersCreate();
+
+    // Only the owning thread writes its counters, so the increment does not
+    // need to be a locked read-modify-write.
+    uint64_t value = atomic_load_explicit(&counters->values[counter], memory_order_relaxed);
+    atomic_store_explicit(&counters->values[counter], value + 1, memory_order_relaxed);
+}
+
+#pragma mark - Reading Counters
+
+void KWCountersRead(uint64_t *values) {
+    memset(values, 0, KWCounterCount * sizeof(uint64_t));
+
+    for (KWThreadCounters *counters = atomic_load_explicit(&KWThreadCountersList, memory_order_acquire); counters != NULL; counters = counters->next) {
+        for (NSUInteger i = 0; i < KWCounterCount; ++i)
+            values[i] += atomic_load_explicit(&counters->values[i], memory_order_relaxed);
+    }
+}
+
+NSString *KWCounterName(KWCounter counter) {
+    switch (counter) {
+        case KWCounterMockInvocations:
+            return @"mockInvocations";
+        case KWCounterInterceptedInvocations:
+            return @"interceptedInvocations";
+        case KWCounterMessagePatternMatchAttempts:
+            return @"messagePatternMatchAttempts";
+        case KWCounterMessagePatternMatches:
+            return @"messagePatternMatches";
+        case KWCounterArgumentFiltersEvaluated:
+            return @"argumentFiltersEvaluated";
+        case KWCounterStubsInstalled:
+            return @"stubsInstalled";
+        case KWCounterSpiesInstalled:
+            return @"spiesInstalled";
+        case KWCounterInterceptClassesCreated:
+            return @"interceptClassesCreated";
+        case KWCounterMatchersAllocated:
+            return @"matchersAllocated";
+        case KWCounterVerifiersAllocated:
+            return @"verifiersAllocated";
+        case KWCounterProbePolls:
+            return @"probePolls";
+        case KWCounterRunLoopSpins:
+            return @"runLoopSpins";
+        case KWCounterValueBoxings:
+            return @"valueBoxings";
+        default:
+            return nil;
+    }
+}
+
+NSDictionary *KWCountersDictionary(const uint64_t *values) {
+    NSMutableDictionary *dictionary = [NSMutableDictionary dictionaryWithCapacity:KWCounterCount];
+
+    for (NSUInteger i = 0; i < KWCounterCount; ++i)
+        dictionary[KWCounterName(i)] = @(values[i]);
+
+    return dictionary;
+}
+
+NSString *KWCountersDescription(const uint64_t *values) {
+    NSMutableArray *pairs = [NSMutableArray arrayWithCapacity:KWCounterCount];
+
+    for (NSUInteger i = 0; i < KWCounterCount; ++i)
+        [pairs addObject:[NSString stringWithFormat:@"%@=%llu", KWCounterName(i), values[i]]];
+
+    return [pairs componentsJoinedByString:@" "];
+}
+
+BOOL KWCountersShouldLog(void) {
+    static BOOL shouldLog = NO;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSString *value = [[[NSProcessInfo processInfo] environment] objectForKey:@"KW_COUNTERS"];
+        shouldLog = [value length] > 0 && ![value isEqualToString:@"0"];
+    });
+    return shouldLog;
+}
@@ -36,13 +36,23 @@
 - (id)addMatchVerifierWithExpectationType:(KWExpectationType)anExpectationType callSite:(KWCallSite *)aCallSite;
 - (id)addAsyncVerifierWithExpectationType:(KWExpectationType)anExpectationType callSite:(KWCallSite *)aCallSite timeout:(NSTimeInterval)timeout shouldWait:(BOOL)shouldWait;
 
+// Verifiers that have evaluated their expectation and have nothing left to
+// do at the end of the example remove themselves, so that long loops of
+// expectations do not keep every matcher and subject alive.
+- (void)removeVerifier:(id<KWVerifying>)aVerifier;
+
+// The number of verifiers still waiting for the end of the example.
+@property (nonatomic, readonly) NSUInteger verifierCount;
+
 #pragma mark - Report failure
 
 - (void)reportFailure:(KWFailure *)failure;
 
 #pragma mark - Running
 
-- (void)runWithDelegate:(XCTestCase<KWExampleDelegate> *)delegate;
+// The delegate is usually the KWSpec test case running the example, but
+// any object can run examples and collect their failures.
+- (void)runWithDelegate:(id<KWExampleDelegate>)delegate;
 
 #pragma mark - Anonymous It Node Descriptions
 
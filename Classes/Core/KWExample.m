@@ -7,11 +7,15 @@
 #import "KWExample.h"
 #import "KWExampleSuiteBuilder.h"
 #import "KWContextNode.h"
+#import "KWCounters.h"
 #import "KWMatcherFactory.h"
 #import "KWExistVerifier.h"
 #import "KWMatchVerifier.h"
 #import "KWAsyncVerifier.h"
 #import "KWFailure.h"
+#import "KWFailedExamples.h"
+#import "KWExampleResult.h"
+#import "KWResultReporter.h"
 #import "KWContextNode.h"
 #import "KWBeforeEachNode.h"
 #import "KWBeforeAllNode.h"
@@ -30,12 +34,14 @@
 
 @interface KWExample ()
 
-@property (nonatomic, readonly) NSMutableArray *verifiers;
+@property (nonatomic, readonly) NSMutableOrderedSet *verifiers;
+@property (nonatomic, strong) id<KWVerifying> firstVerifier;
 @property (nonatomic, readonly) KWMatcherFactory *matcherFactory;
-@property (nonatomic, weak) XCTestCase<KWExampleDelegate> *delegate;
+@property (nonatomic, weak) id<KWExampleDelegate> delegate;
 @property (nonatomic, assign) BOOL didNotFinish;
 @property (nonatomic, strong) id<KWExampleNode> exampleNode;
 @property (nonatomic, assign) BOOL passed;
+@property (nonatomic, strong) NSMutableArray *failures;
 
 - (void)reportResultForExampleNodeWithLabel:(NSString *)label;
 
@@ -50,7 +56,7 @@
     if (self) {
         _exampleNode = node;
         _matcherFactory = [[KWMatcherFactory alloc] init];
-        _verifiers = [[NSMutableArray alloc] init];
+        _verifiers = [[NSMutableOrderedSet alloc] init];
         _lastInContexts = [[NSMutableArray alloc] init];
         _passed = YES;
     }
@@ -88,12 +94,32 @@
 #pragma mark - Adding Verifiers
 
 - (id)addVerifier:(id<KWVerifying>)aVerifier {
-  if (![self.verifiers containsObject:aVerifier])
+  if (![self.verifiers containsObject:aVerifier]) {
     [self.verifiers addObject:aVerifier];
+    KWCounterIncrement(KWCounterVerifiersAllocated);
+  }
+
+  // Anonymous it nodes are described by their first verifier, which may
+  // already have been removed by the time the description is needed.
+  if (self.firstVerifier == nil)
+    self.firstVerifier = aVerifier;
   
   return aVerifier;
 }
 
+- (void)removeVerifier:(id<KWVerifying>)aVerifier {
+    // Verifiers usually resolve right after they are added, so the one to
+    // remove is almost always the last.
+    if ([self.verifiers lastObject] == aVerifier)
+        [self.verifiers removeObjectAtIndex:[self.verifiers count] - 1];
+    else
+        [self.verifiers removeObject:aVerifier];
+}
+
+- (NSUInteger)verifierCount {
+    return [self.verifiers count];
+}
+
 - (id)addExistVerifierWithExpectationType:(KWExpectationType)anExpectationType callSite:(KWCallSite *)aCallSite {
   id verifier = [KWExistVerifier existVerifierWithExpectationType:anExpectationType callSite:aCallSite reporter:self];
   [self addVerifier:verifier];
@@ -121,20 +147,32 @@
 
 - (void)clearVerifiers {
     [self.verifiers removeAllObjects];
+    self.firstVerifier = nil;
 }
 
 #pragma mark - Running examples
 
-- (void)runWithDelegate:(XCTestCase<KWExampleDelegate> *)delegate {
+- (void)runWithDelegate:(id<KWExampleDelegate>)delegate {
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
     self.delegate = delegate;
+    self.failures = [NSMutableArray array];
     [self.matcherFactory registerMatcherClassesWithNamespacePrefix:@"KW"];
     [[KWExampleSuiteBuilder sharedExampleSuiteBuilder] setCurrentExample:self];
     [self.exampleNode acceptExampleNodeVisitor:self];
     [self clearVerifiers];
+
+    if (!self.passed)
+        KWRecordFailedExample([self specNameForDelegate:delegate], self.selectorName);
+
+    [self reportResultWithDuration:CFAbsoluteTimeGetCurrent() - start];
 }
 
 #pragma mark - Reporting failure
 
+- (NSString *)specNameForDelegate:(id<KWExampleDelegate>)delegate {
+    return [delegate respondsToSelector:@selector(specNameForExample:)] ? [delegate specNameForExample:self] : NSStringFromClass([delegate class]);
+}
+
 - (NSString *)descriptionForExampleContext {
     NSMutableArray *parts = [NSMutableArray array];
     
@@ -165,11 +203,37 @@
 
 - (void)reportFailure:(KWFailure *)failure {
     self.passed = NO;
-    [self.delegate example:self didFailWithFailure:[self outputReadyFailureWithFailure:failure]];
+    KWFailure *outputReadyFailure = [self outputReadyFailureWithFailure:failure];
+    [self.failures addObject:outputReadyFailure];
+    [self.delegate example:self didFailWithFailure:outputReadyFailure];
 }
 
 - (void)reportResultForExampleNodeWithLabel:(NSString *)label {
-    NSLog(@"+ '%@ %@' [%@]", [self descriptionForExampleContext], [self.exampleNode description], label);
+    if ([KWResultReporter sharedReporter].logsResults)
+        NSLog(@"+ '%@ %@' [%@]", [self descriptionForExampleContext], [self.exampleNode description], label);
+}
+
+- (void)reportResultWithDuration:(NSTimeInterval)duration {
+    KWResultReporter *reporter = [KWResultReporter sharedReporter];
+
+    if (!reporter.hasReporters)
+        return;
+
+    KWExampleResultStatus status = KWExampleResultStatusPassed;
+
+    if ([self.exampleNode isKindOfClass:[KWPendingNode class]])
+        status = KWExampleResultStatusPending;
+    else if (!self.passed)
+        status = KWExampleResultStatusFailed;
+
+    NSString *specName = [self specNameForDelegate:self.delegate];
+    NSString *description = [NSString stringWithFormat:@"%@ %@", [self descriptionForExampleContext], [self.exampleNode description] ?: @""];
+    [reporter reportResult:[[KWExampleResult alloc] initWithSpecName:specName
+                                                        selectorName:self.selectorName
+                                                         description:description
+                                                              status:status
+                                                            duration:duration
+                                                            failures:self.failures]];
 }
 
 #pragma mark - Full description with context
@@ -270,6 +334,11 @@
         return;
     
     aNode.example = self;
+
+    // Stubs and spies created by the example, including its beforeEach and
+    // afterEach blocks, belong to a generation of its own.
+    NSUInteger interceptGeneration = KWNewInterceptGeneration();
+    KWSetCurrentInterceptGeneration(interceptGeneration);
     
     [aNode.context performExample:self withBlock:^{
         
@@ -303,9 +372,16 @@
             [self reportResultForExampleNodeWithLabel:@"PASSED"];
         }
         
-        // Always clear stubs and spies at the end of it blocks
-        KWClearStubsAndSpies();
+        // Always clear stubs and spies at the end of it blocks, leaving
+        // those of enclosing beforeAll blocks in place. Those created outside
+        // examples, such as in -setUp, are cleared as well.
+        KWClearStubsAndSpiesOfGeneration(interceptGeneration);
+        KWClearStubsAndSpiesOfGeneration(0);
     }];
+
+    KWClearStubsAndSpiesOfGeneration(interceptGeneration);
+    KWClearStubsAndSpiesOfGeneration(0);
+    KWSetCurrentInterceptGeneration(0);
 }
 
 - (void)visitPendingNode:(KWPendingNode *)aNode {
@@ -317,7 +393,7 @@
 
 - (NSString *)generateDescriptionForAnonymousItNode {
     // anonymous specify blocks should only have one verifier, but use the first in any case
-    return [(self.verifiers)[0] descriptionForAnonymousItNode];
+    return [self.firstVerifier descriptionForAnonymousItNode];
 }
 
 @end
@@ -15,4 +15,10 @@
 
 - (void)example:(KWExample *)example didFailWithFailure:(KWFailure *)failure;
 
+@optional
+
+// The name the results of example are reported under. Defaults to the name
+// of the delegate's class.
+- (NSString *)specNameForExample:(KWExample *)example;
+
 @end
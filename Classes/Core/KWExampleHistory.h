@@ -0,0 +1,29 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KiwiConfiguration.h"
+
+// The durations and results of examples in earlier runs, keyed by spec
+// class name and example selector name. The history is an append-only text
+// file with one line per example run, so several processes can record into
+// it at once; the latest line for an example wins.
+@interface KWExampleHistory : NSObject
+
+#pragma mark - Initializing
+
+- (id)initWithPath:(NSString *)aPath;
+
+#pragma mark - Querying History
+
+// Returns a negative duration for examples without history.
+- (NSTimeInterval)durationOfExample:(NSString *)aSelectorName inSpecClass:(Class)aClass;
+- (BOOL)exampleFailedLastRun:(NSString *)aSelectorName inSpecClass:(Class)aClass;
+
+#pragma mark - Recording Runs
+
+- (void)recordExample:(NSString *)aSelectorName inSpecClass:(Class)aClass duration:(NSTimeInterval)aDuration passed:(BOOL)passed;
+
+@end
@@ -0,0 +1,109 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KWExampleHistory.h"
+#import <fcntl.h>
+#import <unistd.h>
+
+// Histories are rewritten with one line per example once they have grown
+// past this many lines per example.
+static const NSUInteger KWExampleHistoryCompactionFactor = 4;
+
+@interface KWExampleHistory()
+
+@property (nonatomic, copy) NSString *path;
+@property (nonatomic, strong) NSMutableDictionary *durations;
+@property (nonatomic, strong) NSMutableSet *failedExamples;
+@property (nonatomic, assign) int fileDescriptor;
+
+@end
+
+@implementation KWExampleHistory
+
+#pragma mark - Initializing
+
+- (id)initWithPath:(NSString *)aPath {
+    self = [super init];
+    if (self) {
+        _path = [aPath copy];
+        _durations = [[NSMutableDictionary alloc] init];
+        _failedExamples = [[NSMutableSet alloc] init];
+        [self load];
+        _fileDescriptor = open([_path fileSystemRepresentation], O_WRONLY | O_APPEND | O_CREAT, 0644);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    if (_fileDescriptor >= 0)
+        close(_fileDescriptor);
+}
+
+static NSString *KWExampleHistoryKey(NSString *aSelectorName, Class aClass) {
+    return [NSString stringWithFormat:@"%@/%@", NSStringFromClass(aClass), aSelectorName];
+}
+
+// Lines are "<seconds> <PASS|FAIL> <class>/<selector>".
+- (void)load {
+    NSString *contents = [NSString stringWithContentsOfFile:self.path encoding:NSUTF8StringEncoding error:NULL];
+    NSUInteger lineCount = 0;
+
+    for (NSString *line in [contents componentsSeparatedByString:@"\n"]) {
+        NSArray *fields = [line componentsSeparatedByString:@" "];
+
+        if ([fields count] != 3)
+            continue;
+
+        NSString *key = fields[2];
+        self.durations[key] = @([fields[0] doubleValue]);
+
+        if ([fields[1] isEqualToString:@"FAIL"])
+            [self.failedExamples addObject:key];
+        else
+            [self.failedExamples removeObject:key];
+
+        ++lineCount;
+    }
+
+    if (lineCount > KWExampleHistoryCompactionFactor * [self.durations count])
+        [self compact];
+}
+
+- (void)compact {
+    NSMutableString *contents = [NSMutableString string];
+
+    for (NSString *key in self.durations) {
+        [contents appendFormat:@"%.6f %@ %@\n", [self.durations[key] doubleValue],
+                               [self.failedExamples containsObject:key] ? @"FAIL" : @"PASS", key];
+    }
+
+    [contents writeToFile:self.path atomically:YES encoding:NSUTF8StringEncoding error:NULL];
+}
+
+#pragma mark - Querying History
+
+- (NSTimeInterval)durationOfExample:(NSString *)aSelectorName inSpecClass:(Class)aClass {
+    NSNumber *duration = self.durations[KWExampleHistoryKey(aSelectorName, aClass)];
+    return duration != nil ? [duration doubleValue] : -1.0;
+}
+
+- (BOOL)exampleFailedLastRun:(NSString *)aSelectorName inSpecClass:(Class)aClass {
+    return [self.failedExamples containsObject:KWExampleHistoryKey(aSelectorName, aClass)];
+}
+
+#pragma mark - Recording Runs
+
+- (void)recordExample:(NSString *)aSelectorName inSpecClass:(Class)aClass duration:(NSTimeInterval)aDuration passed:(BOOL)passed {
+    if (self.fileDescriptor < 0)
+        return;
+
+    // One write per line keeps lines from different processes whole.
+    NSString *line = [NSString stringWithFormat:@"%.6f %@ %@\n", aDuration, passed ? @"PASS" : @"FAIL", KWExampleHistoryKey(aSelectorName, aClass)];
+    NSData *data = [line dataUsingEncoding:NSUTF8StringEncoding];
+    write(self.fileDescriptor, data.bytes, data.length);
+}
+
+@end
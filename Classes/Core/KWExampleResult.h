@@ -0,0 +1,39 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KiwiConfiguration.h"
+
+@class KWFailure;
+
+typedef NS_ENUM(NSUInteger, KWExampleResultStatus) {
+    KWExampleResultStatusPassed,
+    KWExampleResultStatusFailed,
+    KWExampleResultStatusPending
+};
+
+// The outcome of one example, as handed to reporters. Results are reported
+// on a background queue, so they copy everything they need from the example.
+@interface KWExampleResult : NSObject
+
+#pragma mark - Initializing
+
+- (id)initWithSpecName:(NSString *)aSpecName
+          selectorName:(NSString *)aSelectorName
+           description:(NSString *)aDescription
+                status:(KWExampleResultStatus)aStatus
+              duration:(NSTimeInterval)aDuration
+              failures:(NSArray *)failures;
+
+#pragma mark - Properties
+
+@property (nonatomic, readonly) NSString *specName;
+@property (nonatomic, readonly) NSString *selectorName;
+@property (nonatomic, readonly) NSString *exampleDescription;
+@property (nonatomic, readonly) KWExampleResultStatus status;
+@property (nonatomic, readonly) NSTimeInterval duration;
+@property (nonatomic, readonly) NSArray *failures;
+
+@end
@@ -0,0 +1,47 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KWExampleResult.h"
+#import "KWFailure.h"
+
+@interface KWExampleResult()
+
+// Failures only hold their call sites weakly.
+@property (nonatomic, readonly) NSArray *callSites;
+
+@end
+
+@implementation KWExampleResult
+
+#pragma mark - Initializing
+
+- (id)initWithSpecName:(NSString *)aSpecName
+          selectorName:(NSString *)aSelectorName
+           description:(NSString *)aDescription
+                status:(KWExampleResultStatus)aStatus
+              duration:(NSTimeInterval)aDuration
+              failures:(NSArray *)failures {
+    self = [super init];
+    if (self) {
+        _specName = [aSpecName copy];
+        _selectorName = [aSelectorName copy];
+        _exampleDescription = [aDescription copy];
+        _status = aStatus;
+        _duration = aDuration;
+        _failures = [failures copy] ?: @[];
+        NSMutableArray *callSites = [NSMutableArray arrayWithCapacity:[_failures count]];
+
+        for (KWFailure *failure in _failures) {
+            if (failure.callSite != nil)
+                [callSites addObject:failure.callSite];
+        }
+
+        _callSites = callSites;
+    }
+    return self;
+}
+
+@end
@@ -25,9 +25,15 @@
 @property (nonatomic, strong) KWExample *currentExample;
 @property (nonatomic, strong) KWCallSite *focusedCallSite;
 
+// When set, only examples with these keys, as made by KWFailedExampleKey(),
+// are built. Set from the failed examples of the last run when
+// KW_RERUN_FAILED is set.
+@property (nonatomic, strong) NSSet *rerunExampleKeys;
+
 //spec file name:line number of callsite
 - (void)focusWithURI:(NSString *)nodeUrl;
 - (KWExampleSuite *)buildExampleSuite:(void (^)(void))buildingBlock;
+- (KWExampleSuite *)buildExampleSuiteForSpecName:(NSString *)aSpecName block:(void (^)(void))buildingBlock;
 
 - (void)pushContextNodeWithCallSite:(KWCallSite *)aCallSite description:(NSString *)aDescription;
 - (void)popContextNode;
@@ -15,6 +15,7 @@
 #import "KWContextNode.h"
 #import "KWExample.h"
 #import "KWExampleSuite.h"
+#import "KWFailedExamples.h"
 #import "KWItNode.h"
 #import "KWPendingNode.h"
 #import "KWRegisterMatchersNode.h"
@@ -27,6 +28,7 @@ static NSString * const KWExampleSuiteBuilderException = @"KWExampleSuiteBuilder
 #pragma mark - Building Example Groups
 
 @property (nonatomic, strong) KWExampleSuite *currentExampleSuite;
+@property (nonatomic, copy) NSString *currentSpecName;
 @property (nonatomic, readonly) NSMutableArray *contextNodeStack;
 
 @property (nonatomic, strong) NSMutableSet *suites;
@@ -48,6 +50,13 @@ static NSString * const KWExampleSuiteBuilderException = @"KWExampleSuiteBuilder
         _contextNodeStack = [[NSMutableArray alloc] init];
         _suites = [[NSMutableSet alloc] init];
         [self focusWithURI:[[[NSProcessInfo processInfo] environment] objectForKey:@"KW_SPEC"]];
+
+        if (KWShouldRerunFailedExamples()) {
+            _rerunExampleKeys = KWFailedExamplesOfLastRun();
+
+            if (_rerunExampleKeys == nil)
+                NSLog(@"KW_RERUN_FAILED is set, but no failed examples were recorded in %@; running all examples", KWFailedExamplesPath());
+        }
     }
     return self;
 }
@@ -93,6 +102,11 @@ static NSString * const KWExampleSuiteBuilderException = @"KWExampleSuiteBuilder
 }
 
 - (KWExampleSuite *)buildExampleSuite:(void (^)(void))buildingBlock
+{
+    return [self buildExampleSuiteForSpecName:nil block:buildingBlock];
+}
+
+- (KWExampleSuite *)buildExampleSuiteForSpecName:(NSString *)aSpecName block:(void (^)(void))buildingBlock
 {
     KWContextNode *rootNode = [KWContextNode contextNodeWithCallSite:nil parentContext:nil description:nil];
 
@@ -100,9 +114,11 @@ static NSString * const KWExampleSuiteBuilderException = @"KWExampleSuiteBuilder
     
     [self.suites addObject:self.currentExampleSuite];
 
+    self.currentSpecName = aSpecName;
     [self.contextNodeStack addObject:rootNode];
     buildingBlock();
     [self.contextNodeStack removeAllObjects];
+    self.currentSpecName = nil;
     
     return self.currentExampleSuite;
 }
@@ -199,12 +215,23 @@ static NSString * const KWExampleSuiteBuilderException = @"KWExampleSuiteBuilder
         return;
 
     KWItNode* itNode = [KWItNode itNodeWithCallSite:aCallSite description:aDescription context:contextNode block:block];
-    [contextNode addItNode:itNode];
-    
     KWExample *example = [[KWExample alloc] initWithExampleNode:itNode];
+
+    if (self.rerunExampleKeys != nil && ![self shouldRerunExample:example])
+        return;
+
+    [contextNode addItNode:itNode];
     [self.currentExampleSuite addExample:example];
 }
 
+// Examples take unique selector names in the order they are built, so the
+// names of examples that are left out are still taken to keep the names of
+// the others the same as in the run that recorded them.
+- (BOOL)shouldRerunExample:(KWExample *)example {
+    example.suite = self.currentExampleSuite;
+    return [self.rerunExampleKeys containsObject:KWFailedExampleKey(self.currentSpecName, example.selectorName)];
+}
+
 - (BOOL)shouldAddItNodeWithCallSite:(KWCallSite *)aCallSite toContextNode:(KWContextNode *)contextNode {
     if (contextNode.isFocused)
         return YES;
@@ -222,8 +249,12 @@ static NSString * const KWExampleSuiteBuilderException = @"KWExampleSuiteBuilder
 
     KWContextNode *contextNode = [self.contextNodeStack lastObject];
     KWPendingNode *pendingNode = [KWPendingNode pendingNodeWithCallSite:aCallSite context:contextNode description:aDescription];
-    [contextNode addPendingNode:pendingNode];
     KWExample *example = [[KWExample alloc] initWithExampleNode:pendingNode];
+
+    if (self.rerunExampleKeys != nil && ![self shouldRerunExample:example])
+        return;
+
+    [contextNode addPendingNode:pendingNode];
     [self.currentExampleSuite addExample:example];
 }
 
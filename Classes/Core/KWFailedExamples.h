@@ -0,0 +1,33 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KiwiConfiguration.h"
+
+// The examples that failed in a run are written to a file when the run ends,
+// one "<spec>/<selector>" key per line. With KW_RERUN_FAILED=1 set, the next
+// run only builds those examples and the contexts around them.
+//
+// The file is named by KW_FAILED_EXAMPLES_PATH, or lives in the temporary
+// directory under a name derived from the process name.
+
+#pragma mark - Rerunning Failed Examples
+
+BOOL KWShouldRerunFailedExamples(void);
+NSString *KWFailedExamplesPath(void);
+
+// Returns the keys written by the last run, or nil if it recorded none, in
+// which case every example is run.
+NSSet *KWFailedExamplesOfLastRun(void);
+
+// Selector names are only unique within a spec.
+NSString *KWFailedExampleKey(NSString *specName, NSString *selectorName);
+
+#pragma mark - Recording Failed Examples
+
+void KWRecordFailedExample(NSString *specName, NSString *selectorName);
+
+// Replaces the file with the examples recorded so far in this run.
+void KWWriteFailedExamples(void);
@@ -0,0 +1,69 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KWFailedExamples.h"
+#import <pthread.h>
+
+static pthread_mutex_t KWFailedExamplesLock = PTHREAD_MUTEX_INITIALIZER;
+static NSMutableOrderedSet *KWFailedExamplesOfThisRun = nil;
+
+#pragma mark - Rerunning Failed Examples
+
+BOOL KWShouldRerunFailedExamples(void) {
+    NSString *value = [[[NSProcessInfo processInfo] environment] objectForKey:@"KW_RERUN_FAILED"];
+    return [value length] > 0 && ![value isEqualToString:@"0"];
+}
+
+NSString *KWFailedExamplesPath(void) {
+    NSString *path = [[[NSProcessInfo processInfo] environment] objectForKey:@"KW_FAILED_EXAMPLES_PATH"];
+
+    if ([path length] > 0)
+        return path;
+
+    NSString *filename = [NSString stringWithFormat:@"KiwiFailedExamples-%@", [[NSProcessInfo processInfo] processName]];
+    return [NSTemporaryDirectory() stringByAppendingPathComponent:filename];
+}
+
+NSSet *KWFailedExamplesOfLastRun(void) {
+    NSString *contents = [NSString stringWithContentsOfFile:KWFailedExamplesPath() encoding:NSUTF8StringEncoding error:NULL];
+    NSMutableSet *keys = [NSMutableSet set];
+
+    for (NSString *line in [contents componentsSeparatedByString:@"\n"]) {
+        if ([line length] > 0)
+            [keys addObject:line];
+    }
+
+    return [keys count] > 0 ? keys : nil;
+}
+
+NSString *KWFailedExampleKey(NSString *specName, NSString *selectorName) {
+    return [NSString stringWithFormat:@"%@/%@", specName ?: @"", selectorName];
+}
+
+#pragma mark - Recording Failed Examples
+
+void KWRecordFailedExample(NSString *specName, NSString *selectorName) {
+    pthread_mutex_lock(&KWFailedExamplesLock);
+
+    if (KWFailedExamplesOfThisRun == nil)
+        KWFailedExamplesOfThisRun = [[NSMutableOrderedSet alloc] init];
+
+    [KWFailedExamplesOfThisRun addObject:KWFailedExampleKey(specName, selectorName)];
+    pthread_mutex_unlock(&KWFailedExamplesLock);
+}
+
+void KWWriteFailedExamples(void) {
+    NSMutableString *contents = [NSMutableString string];
+
+    pthread_mutex_lock(&KWFailedExamplesLock);
+
+    for (NSString *key in KWFailedExamplesOfThisRun)
+        [contents appendFormat:@"%@\n", key];
+
+    pthread_mutex_unlock(&KWFailedExamplesLock);
+
+    [contents writeToFile:KWFailedExamplesPath() atomically:YES encoding:NSUTF8StringEncoding error:NULL];
+}
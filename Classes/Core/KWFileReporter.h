@@ -0,0 +1,29 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KiwiConfiguration.h"
+#import "KWResultReporting.h"
+
+// Base class of reporters that write text to a file. Output is buffered and
+// written out in large chunks.
+@interface KWFileReporter : NSObject<KWResultReporting>
+
+#pragma mark - Initializing
+
+- (id)initWithPath:(NSString *)aPath;
+- (id)initWithFileDescriptor:(int)aFileDescriptor;
+
+#pragma mark - Writing Output
+
+@property (nonatomic, readonly) NSString *path;
+
+- (void)writeString:(NSString *)aString;
+- (void)flushOutput;
+
+// Discards what was written to the file so far.
+- (void)truncateOutput;
+
+@end
@@ -0,0 +1,102 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KWFileReporter.h"
+#import <fcntl.h>
+#import <unistd.h>
+
+static const NSUInteger KWFileReporterBufferSize = 64 * 1024;
+
+@interface KWFileReporter()
+
+@property (nonatomic, readonly) NSMutableData *buffer;
+@property (nonatomic, readonly) int fileDescriptor;
+@property (nonatomic, readonly) BOOL ownsFileDescriptor;
+
+@end
+
+@implementation KWFileReporter
+
+#pragma mark - Initializing
+
+- (id)initWithPath:(NSString *)aPath {
+    int fileDescriptor = open([aPath fileSystemRepresentation], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if (fileDescriptor < 0)
+        [NSException raise:@"KWFileReporterException" format:@"could not open %@: %s", aPath, strerror(errno)];
+
+    self = [self initWithFileDescriptor:fileDescriptor];
+    if (self) {
+        _path = [aPath copy];
+        _ownsFileDescriptor = YES;
+    }
+    return self;
+}
+
+- (id)initWithFileDescriptor:(int)aFileDescriptor {
+    self = [super init];
+    if (self) {
+        _fileDescriptor = aFileDescriptor;
+        _buffer = [[NSMutableData alloc] initWithCapacity:KWFileReporterBufferSize];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [self flushOutput];
+
+    if (_ownsFileDescriptor)
+        close(_fileDescriptor);
+}
+
+#pragma mark - Writing Output
+
+- (void)writeString:(NSString *)aString {
+    [self.buffer appendData:[aString dataUsingEncoding:NSUTF8StringEncoding]];
+
+    if ([self.buffer length] >= KWFileReporterBufferSize)
+        [self flushOutput];
+}
+
+- (void)flushOutput {
+    const char *bytes = [self.buffer bytes];
+    NSUInteger length = [self.buffer length];
+
+    while (length > 0) {
+        ssize_t written = write(self.fileDescriptor, bytes, length);
+
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            break;
+
+        bytes += written;
+        length -= (NSUInteger)written;
+    }
+
+    [self.buffer setLength:0];
+}
+
+- (void)truncateOutput {
+    [self.buffer setLength:0];
+
+    if (self.ownsFileDescriptor) {
+        ftruncate(self.fileDescriptor, 0);
+        lseek(self.fileDescriptor, 0, SEEK_SET);
+    }
+}
+
+#pragma mark - Reporting Results
+
+- (void)reportFailure:(KWFailure *)failure {}
+
+- (void)reportResult:(KWExampleResult *)aResult {}
+
+- (void)finishReporting {
+    [self flushOutput];
+}
+
+@end
@@ -6,11 +6,27 @@
 
 #import "KiwiConfiguration.h"
 
+// Limits of the descriptions returned by +formatObject:. Lengths are counted
+// in characters.
+extern const NSUInteger KWFormatterDefaultMaximumLength;
+extern const NSUInteger KWFormatterDefaultMaximumDepth;
+
 @interface KWFormatter : NSObject
 
 #pragma mark - Getting Descriptions
 
+// Descriptions stop growing at the default maximum length and depth, and
+// show what was left out with "..." markers. Collections that contain
+// themselves are shown as "(<cycle>)". If KW_FULL_DESCRIPTIONS_DIR is set,
+// the full description of an object whose description was cut short is
+// written to a file in that directory, and the description names the file.
 + (NSString *)formatObject:(id)anObject;
++ (NSString *)formatObject:(id)anObject maximumLength:(NSUInteger)maximumLength maximumDepth:(NSUInteger)maximumDepth;
 + (NSString *)formatObjectIncludingClass:(id)anObject;
 
+#pragma mark - Writing Full Descriptions
+
+// Streams the description of anObject to a file without a length limit.
++ (BOOL)writeFullDescriptionOfObject:(id)anObject toFileAtPath:(NSString *)aPath;
+
 @end
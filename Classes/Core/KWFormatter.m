@@ -5,6 +5,208 @@
 //
 
 #import "KWFormatter.h"
+#import <stdatomic.h>
+
+const NSUInteger KWFormatterDefaultMaximumLength = 8192;
+const NSUInteger KWFormatterDefaultMaximumDepth = 16;
+
+// Full descriptions written on request are not limited in length, but
+// still in depth, so that very deep nesting cannot exhaust the stack.
+static const NSUInteger KWFormatterFullDescriptionMaximumDepth = 256;
+
+// Dictionaries this small with no collections in them keep the format of
+// -[NSDictionary description].
+static const NSUInteger KWFormatterMaximumPlainDictionaryCount = 64;
+
+static const NSUInteger KWFormatterFileBufferLength = 64 * 1024;
+
+static _Atomic(NSUInteger) KWFormatterFullDescriptionCount = 0;
+
+#pragma mark - Writing Descriptions
+
+// Builds a description piece by piece, and stops taking input once the
+// description has reached its maximum length. Elision markers are always
+// written, so a description can exceed the maximum by a marker per level.
+@interface KWFormatterWriter : NSObject
+
+- (id)initWithMaximumLength:(NSUInteger)maximumLength maximumDepth:(NSUInteger)maximumDepth fileHandle:(NSFileHandle *)aFileHandle;
+
+@property (nonatomic, readonly) NSMutableString *output;
+@property (nonatomic, readonly) NSFileHandle *fileHandle;
+@property (nonatomic, readonly) NSUInteger maximumLength;
+@property (nonatomic, readonly) NSUInteger maximumDepth;
+@property (nonatomic, readonly) NSUInteger length;
+@property (nonatomic, readonly) BOOL elided;
+@property (nonatomic, readonly) NSHashTable *openCollections;
+
+@end
+
+@implementation KWFormatterWriter
+
+- (id)initWithMaximumLength:(NSUInteger)maximumLength maximumDepth:(NSUInteger)maximumDepth fileHandle:(NSFileHandle *)aFileHandle {
+    self = [super init];
+    if (self) {
+        _output = [[NSMutableString alloc] init];
+        _fileHandle = aFileHandle;
+        _maximumLength = maximumLength;
+        _maximumDepth = maximumDepth;
+        _openCollections = [[NSHashTable alloc] initWithOptions:NSPointerFunctionsOpaqueMemory | NSPointerFunctionsObjectPointerPersonality capacity:0];
+    }
+    return self;
+}
+
+- (BOOL)hasRoom {
+    return self.length < self.maximumLength;
+}
+
+- (void)appendMarker:(NSString *)aMarker {
+    [self.output appendString:aMarker];
+    _length += [aMarker length];
+    [self flushIfNeeded];
+}
+
+- (void)appendString:(NSString *)aString {
+    if (![self hasRoom]) {
+        _elided = YES;
+        return;
+    }
+
+    NSUInteger room = self.maximumLength - self.length;
+
+    if ([aString length] <= room) {
+        [self appendMarker:aString];
+        return;
+    }
+
+    // Never cut a composed character in two.
+    NSUInteger end = room > 0 ? [aString rangeOfComposedCharacterSequenceAtIndex:room].location : 0;
+    [self appendMarker:[aString substringToIndex:end]];
+    [self appendMarker:[NSString stringWithFormat:@"... (%lu more characters)", (unsigned long)([aString length] - end)]];
+    _elided = YES;
+}
+
+- (void)flushIfNeeded {
+    if (self.fileHandle != nil && [self.output length] >= KWFormatterFileBufferLength)
+        [self flush];
+}
+
+- (void)flush {
+    [self.fileHandle writeData:[self.output dataUsingEncoding:NSUTF8StringEncoding]];
+    [self.output setString:@""];
+}
+
+#pragma mark - Writing Objects
+
+static BOOL KWFormatterIsCollection(id anObject) {
+    return [anObject isKindOfClass:[NSDictionary class]] || ([anObject conformsToProtocol:@protocol(NSFastEnumeration)] && ![anObject isKindOfClass:[NSString class]]);
+}
+
+- (void)writeObject:(id)anObject depth:(NSUInteger)depth {
+    if ([anObject isKindOfClass:[NSString class]]) {
+        [self appendString:@"\""];
+        [self appendString:anObject];
+        [self appendString:@"\""];
+    } else if ([anObject isKindOfClass:[NSDictionary class]]) {
+        [self writeDictionary:anObject depth:depth];
+    } else if ([anObject conformsToProtocol:@protocol(NSFastEnumeration)]) {
+        [self writeCollection:anObject depth:depth];
+    } else {
+        [self appendString:[anObject description] ?: @"(null)"];
+    }
+}
+
+- (BOOL)beginCollection:(id)aCollection depth:(NSUInteger)depth open:(NSString *)open close:(NSString *)close {
+    if ([self.openCollections containsObject:aCollection]) {
+        [self appendMarker:[NSString stringWithFormat:@"%@<cycle>%@", open, close]];
+        _elided = YES;
+        return NO;
+    }
+
+    if (depth >= self.maximumDepth) {
+        NSString *count = [aCollection respondsToSelector:@selector(count)] ? [NSString stringWithFormat:@" %lu items", (unsigned long)[aCollection count]] : @"";
+        [self appendMarker:[NSString stringWithFormat:@"%@...%@%@", open, count, close]];
+        _elided = YES;
+        return NO;
+    }
+
+    [self.openCollections addObject:aCollection];
+    [self appendMarker:open];
+    return YES;
+}
+
+- (void)endCollection:(id)aCollection close:(NSString *)close {
+    [self.openCollections removeObject:aCollection];
+    [self appendMarker:close];
+}
+
+- (void)appendElisionOfCollection:(id)aCollection afterIndex:(NSUInteger)index separator:(NSString *)separator {
+    NSString *remaining = [aCollection respondsToSelector:@selector(count)] ? [NSString stringWithFormat:@" %lu more", (unsigned long)([aCollection count] - index)] : @"";
+    [self appendMarker:[NSString stringWithFormat:@"%@...%@", separator, remaining]];
+    _elided = YES;
+}
+
+- (void)writeCollection:(id<NSFastEnumeration>)aCollection depth:(NSUInteger)depth {
+    if (![self beginCollection:aCollection depth:depth open:@"(" close:@")"])
+        return;
+
+    NSUInteger index = 0;
+
+    for (id object in aCollection) {
+        if (![self hasRoom]) {
+            [self appendElisionOfCollection:aCollection afterIndex:index separator:index == 0 ? @"" : @", "];
+            break;
+        }
+
+        if (index > 0)
+            [self appendString:@", "];
+
+        [self writeObject:object depth:depth + 1];
+        ++index;
+    }
+
+    [self endCollection:aCollection close:@")"];
+}
+
+- (void)writeDictionary:(NSDictionary *)aDictionary depth:(NSUInteger)depth {
+    if ([aDictionary count] <= KWFormatterMaximumPlainDictionaryCount) {
+        BOOL plain = YES;
+
+        for (id key in aDictionary) {
+            if (KWFormatterIsCollection(key) || KWFormatterIsCollection(aDictionary[key])) {
+                plain = NO;
+                break;
+            }
+        }
+
+        if (plain) {
+            [self appendString:[aDictionary description]];
+            return;
+        }
+    }
+
+    if (![self beginCollection:aDictionary depth:depth open:@"{" close:@"}"])
+        return;
+
+    NSUInteger index = 0;
+
+    for (id key in aDictionary) {
+        if (![self hasRoom]) {
+            [self appendElisionOfCollection:aDictionary afterIndex:index separator:@"\n    "];
+            break;
+        }
+
+        [self appendString:@"\n    "];
+        [self writeObject:key depth:depth + 1];
+        [self appendString:@" = "];
+        [self writeObject:aDictionary[key] depth:depth + 1];
+        [self appendString:@";"];
+        ++index;
+    }
+
+    [self endCollection:aDictionary close:@"\n}"];
+}
+
+@end
 
 @implementation KWFormatter
 
@@ -12,48 +214,58 @@
 #pragma mark - Getting Descriptions
 
 + (NSString *)formatObject:(id)anObject {
-    if ([anObject isKindOfClass:[NSString class]])
-        return [NSString stringWithFormat:@"\"%@\"", anObject];
+    KWFormatterWriter *writer = [[KWFormatterWriter alloc] initWithMaximumLength:KWFormatterDefaultMaximumLength maximumDepth:KWFormatterDefaultMaximumDepth fileHandle:nil];
+    [writer writeObject:anObject depth:0];
+
+    if (writer.elided) {
+        NSString *path = [self writeFullDescriptionOfObjectIfRequested:anObject];
 
-    else if ([anObject isKindOfClass:[NSDictionary class]])
-        return [anObject description]; // NSDictionary conforms to NSFastEnumeration
+        if (path != nil)
+            [writer appendMarker:[NSString stringWithFormat:@" (full description in %@)", path]];
+    }
 
-    else if ([anObject conformsToProtocol:@protocol(NSFastEnumeration)])
-        return [self formattedCollection:anObject];
+    return writer.output;
+}
 
-    return [anObject description];
++ (NSString *)formatObject:(id)anObject maximumLength:(NSUInteger)maximumLength maximumDepth:(NSUInteger)maximumDepth {
+    KWFormatterWriter *writer = [[KWFormatterWriter alloc] initWithMaximumLength:maximumLength maximumDepth:maximumDepth fileHandle:nil];
+    [writer writeObject:anObject depth:0];
+    return writer.output;
 }
 
 + (NSString *)formatObjectIncludingClass:(id)anObject {
     NSString *classString = [[anObject class] description];
-    
+
     if ([anObject isKindOfClass:[NSString class]])
         classString = @"NSString";
-    
+
     return [NSString stringWithFormat:@"(%@) %@", classString, [self formatObject:anObject]];
 }
 
+#pragma mark - Writing Full Descriptions
 
-#pragma mark - Internal Methods
-
-+ (NSString *)formattedCollection:(id<NSFastEnumeration>)collection {
++ (BOOL)writeFullDescriptionOfObject:(id)anObject toFileAtPath:(NSString *)aPath {
+    if (![[NSFileManager defaultManager] createFileAtPath:aPath contents:nil attributes:nil])
+        return NO;
 
-    NSMutableString *description = [[NSMutableString alloc] initWithString:@"("];
-    NSUInteger index = 0;
-    
-    for (id object in collection) {
-        if (index == 0)
-            [description appendFormat:@"%@", [self formatObject:object]];
-        else
-            [description appendFormat:@", %@", [self formatObject:object]];
-        
-        ++index;
-    }
-    
-    [description appendString:@")"];
-    return description;
+    NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingAtPath:aPath];
+    KWFormatterWriter *writer = [[KWFormatterWriter alloc] initWithMaximumLength:NSUIntegerMax maximumDepth:KWFormatterFullDescriptionMaximumDepth fileHandle:fileHandle];
+    [writer writeObject:anObject depth:0];
+    [writer flush];
+    [fileHandle closeFile];
+    return YES;
 }
 
++ (NSString *)writeFullDescriptionOfObjectIfRequested:(id)anObject {
+    NSString *directory = [[[NSProcessInfo processInfo] environment] objectForKey:@"KW_FULL_DESCRIPTIONS_DIR"];
 
+    if ([directory length] == 0)
+        return nil;
+
+    NSUInteger number = atomic_fetch_add_explicit(&KWFormatterFullDescriptionCount, 1, memory_order_relaxed) + 1;
+    NSString *filename = [NSString stringWithFormat:@"kiwi-description-%d-%lu.txt", [[NSProcessInfo processInfo] processIdentifier], (unsigned long)number];
+    NSString *path = [directory stringByAppendingPathComponent:filename];
+    return [self writeFullDescriptionOfObject:anObject toFileAtPath:path] ? path : nil;
+}
 
 @end
@@ -0,0 +1,58 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KiwiConfiguration.h"
+
+// Number of word-sized message arguments copied into each journal entry.
+#define KW_INVOCATION_JOURNAL_INLINE_ARGUMENTS 4
+
+// A journal entry does not retain anything. Arguments that fit into a word
+// are copied as raw bits; larger arguments are recorded as 0.
+typedef struct KWInvocationJournalEntry {
+    SEL selector;
+    uint64_t sequenceNumber;
+    uint64_t timestamp;
+    NSUInteger argumentCount;
+    uintptr_t arguments[KW_INVOCATION_JOURNAL_INLINE_ARGUMENTS];
+} KWInvocationJournalEntry;
+
+#pragma mark - Getting Sequence Numbers
+
+// Sequence numbers are shared by all journals, so entries recorded by
+// different objects can be ordered against each other. Sequence number 0 is
+// never assigned.
+uint64_t KWInvocationJournalLatestSequenceNumber(void);
+
+@interface KWInvocationJournal : NSObject
+
+#pragma mark - Watching Messages
+
+// A journal only records messages while it is watched. Watchers count the
+// entries after the sequence number returned when they begin watching, and
+// entries that no remaining watcher can count are dropped when one ends.
+- (uint64_t)beginWatching;
+- (void)endWatchingAfterSequenceNumber:(uint64_t)aSequenceNumber;
+
+#pragma mark - Recording Messages
+
+- (void)recordSelector:(SEL)aSelector arguments:(const uintptr_t *)arguments count:(NSUInteger)count;
+- (void)recordInvocation:(NSInvocation *)anInvocation;
+
+#pragma mark - Querying Entries
+
+@property (nonatomic, readonly) NSUInteger count;
+
+- (KWInvocationJournalEntry)entryAtIndex:(NSUInteger)anIndex;
+
+// Counts entries for aSelector with sequence numbers in the range
+// (firstSequenceNumber, lastSequenceNumber].
+- (NSUInteger)countOfEntriesWithSelector:(SEL)aSelector afterSequenceNumber:(uint64_t)firstSequenceNumber upToSequenceNumber:(uint64_t)lastSequenceNumber;
+
+#pragma mark - Clearing Entries
+
+- (void)removeAllEntries;
+
+@end
@@ -0,0 +1,248 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KWInvocationJournal.h"
+#import "KWObjCUtilities.h"
+#import <mach/mach_time.h>
+#import <pthread.h>
+#import <stdatomic.h>
+
+static const NSUInteger KWInvocationJournalInitialCapacity = 16;
+
+static _Atomic(uint64_t) KWInvocationJournalSequenceNumber = 0;
+
+#pragma mark - Getting Sequence Numbers
+
+uint64_t KWInvocationJournalLatestSequenceNumber(void) {
+    return atomic_load_explicit(&KWInvocationJournalSequenceNumber, memory_order_acquire);
+}
+
+@interface KWInvocationJournal() {
+    // Stubbed objects may be called from several threads at once. Appends
+    // only hold the lock for as long as it takes to copy one entry.
+    pthread_mutex_t _lock;
+    KWInvocationJournalEntry *_entries;
+    NSUInteger _count;
+    NSUInteger _capacity;
+    // Watchers are only added and removed with the lock held; the count is
+    // read without it so unwatched messages are dropped before locking.
+    uint64_t *_watchedSequenceNumbers;
+    _Atomic(NSUInteger) _watcherCount;
+    NSUInteger _watcherCapacity;
+}
+
+@end
+
+@implementation KWInvocationJournal
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        pthread_mutex_init(&_lock, NULL);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    pthread_mutex_destroy(&_lock);
+    free(_entries);
+    free(_watchedSequenceNumbers);
+}
+
+#pragma mark - Watching Messages
+
+- (uint64_t)beginWatching {
+    pthread_mutex_lock(&_lock);
+    NSUInteger watcherCount = atomic_load_explicit(&_watcherCount, memory_order_relaxed);
+
+    if (watcherCount == _watcherCapacity) {
+        NSUInteger capacity = _watcherCapacity == 0 ? 4 : _watcherCapacity * 2;
+        uint64_t *sequenceNumbers = realloc(_watchedSequenceNumbers, capacity * sizeof(uint64_t));
+
+        if (sequenceNumbers == NULL) {
+            pthread_mutex_unlock(&_lock);
+            [NSException raise:NSMallocException format:@"could not grow invocation journal to %lu watchers", (unsigned long)capacity];
+        }
+
+        _watchedSequenceNumbers = sequenceNumbers;
+        _watcherCapacity = capacity;
+    }
+
+    uint64_t sequenceNumber = KWInvocationJournalLatestSequenceNumber();
+    _watchedSequenceNumbers[watcherCount] = sequenceNumber;
+    atomic_store_explicit(&_watcherCount, watcherCount + 1, memory_order_release);
+    pthread_mutex_unlock(&_lock);
+    return sequenceNumber;
+}
+
+// Must be called with the lock held.
+- (void)dropEntriesUpToSequenceNumber:(uint64_t)aSequenceNumber {
+    // Entries are appended with the lock held, so they are in sequence order.
+    NSUInteger dropCount = 0;
+    while (dropCount < _count && _entries[dropCount].sequenceNumber <= aSequenceNumber)
+        ++dropCount;
+
+    if (dropCount == 0)
+        return;
+
+    memmove(_entries, _entries + dropCount, (_count - dropCount) * sizeof(KWInvocationJournalEntry));
+    _count -= dropCount;
+}
+
+- (void)endWatchingAfterSequenceNumber:(uint64_t)aSequenceNumber {
+    pthread_mutex_lock(&_lock);
+    NSUInteger watcherCount = atomic_load_explicit(&_watcherCount, memory_order_relaxed);
+
+    for (NSUInteger i = 0; i < watcherCount; ++i) {
+        if (_watchedSequenceNumbers[i] == aSequenceNumber) {
+            _watchedSequenceNumbers[i] = _watchedSequenceNumbers[--watcherCount];
+            atomic_store_explicit(&_watcherCount, watcherCount, memory_order_release);
+            break;
+        }
+    }
+
+    if (watcherCount == 0) {
+        // Nothing can count the entries any more, so give the buffer back
+        // rather than holding on to the largest burst seen so far.
+        free(_entries);
+        _entries = NULL;
+        _count = 0;
+        _capacity = 0;
+    } else {
+        uint64_t oldestSequenceNumber = _watchedSequenceNumbers[0];
+        for (NSUInteger i = 1; i < watcherCount; ++i)
+            oldestSequenceNumber = MIN(oldestSequenceNumber, _watchedSequenceNumbers[i]);
+
+        [self dropEntriesUpToSequenceNumber:oldestSequenceNumber];
+    }
+
+    pthread_mutex_unlock(&_lock);
+}
+
+#pragma mark - Recording Messages
+
+// Must be called with the lock held.
+- (KWInvocationJournalEntry *)appendEntryWithSelector:(SEL)aSelector {
+    // Entries are only dropped once no watcher can count them, so a pending
+    // expectation never misses calls because the buffer filled up.
+    if (_count == _capacity) {
+        NSUInteger capacity = _capacity == 0 ? KWInvocationJournalInitialCapacity : _capacity * 2;
+        KWInvocationJournalEntry *entries = realloc(_entries, capacity * sizeof(KWInvocationJournalEntry));
+
+        if (entries == NULL) {
+            pthread_mutex_unlock(&_lock);
+            [NSException raise:NSMallocException format:@"could not grow invocation journal to %lu entries", (unsigned long)capacity];
+        }
+
+        _entries = entries;
+        _capacity = capacity;
+    }
+
+    KWInvocationJournalEntry *entry = &_entries[_count++];
+    entry->selector = aSelector;
+    entry->sequenceNumber = atomic_fetch_add_explicit(&KWInvocationJournalSequenceNumber, 1, memory_order_acq_rel) + 1;
+    entry->timestamp = mach_absolute_time();
+    entry->argumentCount = 0;
+    return entry;
+}
+
+- (void)recordSelector:(SEL)aSelector arguments:(const uintptr_t *)arguments count:(NSUInteger)count {
+    if (atomic_load_explicit(&_watcherCount, memory_order_acquire) == 0)
+        return;
+
+    pthread_mutex_lock(&_lock);
+
+    // The last watcher may have ended since the check above.
+    if (atomic_load_explicit(&_watcherCount, memory_order_relaxed) == 0) {
+        pthread_mutex_unlock(&_lock);
+        return;
+    }
+
+    KWInvocationJournalEntry *entry = [self appendEntryWithSelector:aSelector];
+    entry->argumentCount = count;
+
+    for (NSUInteger i = 0; i < KW_INVOCATION_JOURNAL_INLINE_ARGUMENTS; ++i)
+        entry->arguments[i] = i < count ? arguments[i] : 0;
+
+    pthread_mutex_unlock(&_lock);
+}
+
+- (void)recordInvocation:(NSInvocation *)anInvocation {
+    if (atomic_load_explicit(&_watcherCount, memory_order_acquire) == 0)
+        return;
+
+    NSMethodSignature *signature = [anInvocation methodSignature];
+    NSUInteger count = [signature numberOfArguments] - 2;
+    uintptr_t arguments[KW_INVOCATION_JOURNAL_INLINE_ARGUMENTS] = { 0 };
+
+    for (NSUInteger i = 0; i < KW_INVOCATION_JOURNAL_INLINE_ARGUMENTS && i < count; ++i) {
+        if (KWObjCTypeDescriptorForObjCType([signature getArgumentTypeAtIndex:i + 2])->size <= sizeof(uintptr_t))
+            [anInvocation getArgument:&arguments[i] atIndex:i + 2];
+    }
+
+    [self recordSelector:[anInvocation selector] arguments:arguments count:count];
+}
+
+#pragma mark - Querying Entries
+
+- (NSUInteger)count {
+    pthread_mutex_lock(&_lock);
+    NSUInteger count = _count;
+    pthread_mutex_unlock(&_lock);
+    return count;
+}
+
+- (KWInvocationJournalEntry)entryAtIndex:(NSUInteger)anIndex {
+    pthread_mutex_lock(&_lock);
+
+    if (anIndex >= _count) {
+        NSUInteger count = _count;
+        pthread_mutex_unlock(&_lock);
+        [NSException raise:NSRangeException format:@"index %lu beyond journal count %lu", (unsigned long)anIndex, (unsigned long)count];
+    }
+
+    KWInvocationJournalEntry entry = _entries[anIndex];
+    pthread_mutex_unlock(&_lock);
+    return entry;
+}
+
+- (NSUInteger)countOfEntriesWithSelector:(SEL)aSelector afterSequenceNumber:(uint64_t)firstSequenceNumber upToSequenceNumber:(uint64_t)lastSequenceNumber {
+    NSUInteger count = 0;
+    pthread_mutex_lock(&_lock);
+
+    for (NSUInteger i = 0; i < _count; ++i) {
+        const KWInvocationJournalEntry *entry = &_entries[i];
+
+        if (entry->selector == aSelector && entry->sequenceNumber > firstSequenceNumber && entry->sequenceNumber <= lastSequenceNumber)
+            ++count;
+    }
+
+    pthread_mutex_unlock(&_lock);
+    return count;
+}
+
+#pragma mark - Clearing Entries
+
+- (void)removeAllEntries {
+    pthread_mutex_lock(&_lock);
+    _count = 0;
+    pthread_mutex_unlock(&_lock);
+}
+
+#pragma mark - Debugging
+
+- (NSString *)description {
+    NSMutableString *description = [NSMutableString stringWithFormat:@"<%@: %p>", NSStringFromClass([self class]), (__bridge void *)self];
+    pthread_mutex_lock(&_lock);
+
+    for (NSUInteger i = 0; i < _count; ++i)
+        [description appendFormat:@"\n  %llu -%@", _entries[i].sequenceNumber, NSStringFromSelector(_entries[i].selector)];
+
+    pthread_mutex_unlock(&_lock);
+    return description;
+}
+
+@end
@@ -0,0 +1,13 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KWFileReporter.h"
+
+// Writes one JSON object per example and line, with the keys "spec",
+// "example", "description", "status", "duration" and "failures".
+@interface KWJSONLinesReporter : KWFileReporter
+
+@end
@@ -0,0 +1,42 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KWJSONLinesReporter.h"
+#import "KWCallSite.h"
+#import "KWExampleResult.h"
+#import "KWFailure.h"
+
+@implementation KWJSONLinesReporter
+
+#pragma mark - Reporting Results
+
+- (void)reportResult:(KWExampleResult *)aResult {
+    static NSString * const statuses[] = { @"passed", @"failed", @"pending" };
+    NSMutableArray *failures = [NSMutableArray arrayWithCapacity:[aResult.failures count]];
+
+    for (KWFailure *failure in aResult.failures) {
+        NSMutableDictionary *object = [NSMutableDictionary dictionaryWithObject:failure.message ?: @"" forKey:@"message"];
+
+        if (failure.callSite != nil) {
+            object[@"file"] = failure.callSite.filename ?: @"";
+            object[@"line"] = @(failure.callSite.lineNumber);
+        }
+
+        [failures addObject:object];
+    }
+
+    NSDictionary *object = @{ @"spec": aResult.specName ?: @"",
+                              @"example": aResult.selectorName ?: @"",
+                              @"description": aResult.exampleDescription ?: @"",
+                              @"status": statuses[aResult.status],
+                              @"duration": @(aResult.duration),
+                              @"failures": failures };
+    NSData *data = [NSJSONSerialization dataWithJSONObject:object options:0 error:NULL];
+    [self writeString:[[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding]];
+    [self writeString:@"\n"];
+}
+
+@end
@@ -0,0 +1,13 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KWFileReporter.h"
+
+// Writes a JUnit XML document with one test suite per spec. The document is
+// written when reporting finishes, since suites start with their totals.
+@interface KWJUnitReporter : KWFileReporter
+
+@end
@@ -0,0 +1,98 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KWJUnitReporter.h"
+#import "KWCallSite.h"
+#import "KWExampleResult.h"
+#import "KWFailure.h"
+
+@interface KWJUnitReporter()
+
+@property (nonatomic, readonly) NSMutableArray *specNames;
+@property (nonatomic, readonly) NSMutableDictionary *resultsBySpecName;
+
+@end
+
+@implementation KWJUnitReporter
+
+#pragma mark - Initializing
+
+- (id)initWithFileDescriptor:(int)aFileDescriptor {
+    self = [super initWithFileDescriptor:aFileDescriptor];
+    if (self) {
+        _specNames = [[NSMutableArray alloc] init];
+        _resultsBySpecName = [[NSMutableDictionary alloc] init];
+    }
+    return self;
+}
+
+#pragma mark - Reporting Results
+
+static NSString *KWJUnitEscapedString(NSString *aString) {
+    NSMutableString *escaped = [NSMutableString stringWithString:aString ?: @""];
+    [escaped replaceOccurrencesOfString:@"&" withString:@"&amp;" options:0 range:NSMakeRange(0, [escaped length])];
+    [escaped replaceOccurrencesOfString:@"<" withString:@"&lt;" options:0 range:NSMakeRange(0, [escaped length])];
+    [escaped replaceOccurrencesOfString:@">" withString:@"&gt;" options:0 range:NSMakeRange(0, [escaped length])];
+    [escaped replaceOccurrencesOfString:@"\"" withString:@"&quot;" options:0 range:NSMakeRange(0, [escaped length])];
+    return escaped;
+}
+
+- (void)reportResult:(KWExampleResult *)aResult {
+    NSString *specName = aResult.specName ?: @"";
+    NSMutableArray *results = self.resultsBySpecName[specName];
+
+    if (results == nil) {
+        results = [NSMutableArray array];
+        self.resultsBySpecName[specName] = results;
+        [self.specNames addObject:specName];
+    }
+
+    [results addObject:aResult];
+}
+
+- (void)finishReporting {
+    [self truncateOutput];
+    [self writeString:@"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<testsuites>\n"];
+
+    for (NSString *specName in self.specNames) {
+        NSArray *results = self.resultsBySpecName[specName];
+        NSUInteger failureCount = 0;
+        NSUInteger skippedCount = 0;
+        NSTimeInterval duration = 0.0;
+
+        for (KWExampleResult *result in results) {
+            failureCount += result.status == KWExampleResultStatusFailed;
+            skippedCount += result.status == KWExampleResultStatusPending;
+            duration += result.duration;
+        }
+
+        [self writeString:[NSString stringWithFormat:@"  <testsuite name=\"%@\" tests=\"%lu\" failures=\"%lu\" skipped=\"%lu\" time=\"%.3f\">\n",
+                           KWJUnitEscapedString(specName), (unsigned long)[results count], (unsigned long)failureCount, (unsigned long)skippedCount, duration]];
+
+        for (KWExampleResult *result in results) {
+            [self writeString:[NSString stringWithFormat:@"    <testcase classname=\"%@\" name=\"%@\" time=\"%.3f\">\n",
+                               KWJUnitEscapedString(specName), KWJUnitEscapedString(result.selectorName), result.duration]];
+
+            if (result.status == KWExampleResultStatusPending)
+                [self writeString:@"      <skipped/>\n"];
+
+            for (KWFailure *failure in result.failures) {
+                NSString *location = failure.callSite != nil ? [NSString stringWithFormat:@"%@:%lu", failure.callSite.filename, (unsigned long)failure.callSite.lineNumber] : @"";
+                [self writeString:[NSString stringWithFormat:@"      <failure message=\"%@\">%@</failure>\n",
+                                   KWJUnitEscapedString(failure.message), KWJUnitEscapedString(location)]];
+            }
+
+            [self writeString:@"    </testcase>\n"];
+        }
+
+        [self writeString:@"  </testsuite>\n"];
+    }
+
+    [self writeString:@"</testsuites>\n"];
+    [super finishReporting];
+}
+
+@end
@@ -5,6 +5,7 @@
 //
 
 #import "KWMatcher.h"
+#import "KWCounters.h"
 #import "KWFormatter.h"
 #import "KWFutureObject.h"
 
@@ -16,6 +17,7 @@
     self = [super init];
     if (self) {
         _subject = anObject;
+        KWCounterIncrement(KWCounterMatchersAllocated);
     }
 
     return self;
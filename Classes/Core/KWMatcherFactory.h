@@ -21,6 +21,11 @@
 
 @property (nonatomic, readonly) NSArray *registeredMatcherClasses;
 
+// Changes whenever a matcher class is registered, and is never the same for
+// two factories, so it tells whether a matcher class resolved earlier would
+// still be resolved.
+@property (nonatomic, readonly) NSUInteger registrationGeneration;
+
 #pragma mark - Registering Matcher Classes
 
 - (void)registerMatcherClass:(Class)aClass;
@@ -34,4 +39,7 @@
 
 - (KWMatcher *)matcherFromInvocation:(NSInvocation *)anInvocation subject:(id)subject;
 
+// Returns Nil if no registered matcher class can match the subject.
+- (Class)matcherClassForSelector:(SEL)aSelector subject:(id)anObject;
+
 @end
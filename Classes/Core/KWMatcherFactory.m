@@ -10,6 +10,9 @@
 #import "KWStringUtilities.h"
 #import "KWUserDefinedMatcher.h"
 #import "KWMatchers.h"
+#import <stdatomic.h>
+
+static _Atomic(NSUInteger) KWMatcherFactoryRegistrationGeneration = 0;
 
 @interface KWMatcherFactory()
 
@@ -38,6 +41,7 @@
         return;
 
     [(NSMutableArray *)self.registeredMatcherClasses addObject:aClass];
+    _registrationGeneration = atomic_fetch_add_explicit(&KWMatcherFactoryRegistrationGeneration, 1, memory_order_relaxed) + 1;
 
     for (NSString *verificationSelectorString in [aClass matcherStrings]) {
         NSMutableArray *matcherClassChain = self.matcherClassChains[verificationSelectorString];
@@ -99,8 +103,9 @@
 - (NSMethodSignature *)methodSignatureForMatcherSelector:(SEL)aSelector {
     NSMutableArray *matcherClassChain = self.matcherClassChains[NSStringFromSelector(aSelector)];
 
+    // User-defined matchers are only used when no matcher class answers.
     if ([matcherClassChain count] == 0)
-        return nil;
+        return [[KWMatchers matchers] methodSignatureForMatcherSelector:aSelector];
 
     Class matcherClass = matcherClassChain[0];
     return [matcherClass instanceMethodSignatureForSelector:aSelector];
@@ -121,8 +126,6 @@
     return [[matcherClass alloc] initWithSubject:subject];
 }
 
-#pragma mark - Internal Methods
-
 - (Class)matcherClassForSelector:(SEL)aSelector subject:(id)anObject {
     NSArray *matcherClassChain = self.matcherClassChains[NSStringFromSelector(aSelector)];
 
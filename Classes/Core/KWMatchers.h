@@ -13,6 +13,7 @@
 typedef void (^KWMatchersBuildingBlock)(KWUserDefinedMatcherBuilder *matcherBuilder);
 
 @class KWUserDefinedMatcher;
+@class KWUserDefinedMatcherDescriptor;
 
 @interface KWMatchers : NSObject
 
@@ -24,6 +25,12 @@ typedef void (^KWMatchersBuildingBlock)(KWUserDefinedMatcherBuilder *matcherBuil
 - (void)defineMatcher:(NSString *)selectorString as:(KWMatchersBuildingBlock)block;
 - (void)addUserDefinedMatcherBuilder:(KWUserDefinedMatcherBuilder *)builder;
 
+#pragma mark - Getting Matcher Definitions
+
+// Both return nil for selectors no matcher has been defined for.
+- (KWUserDefinedMatcherDescriptor *)descriptorForSelector:(SEL)selector;
+- (NSMethodSignature *)methodSignatureForMatcherSelector:(SEL)selector;
+
 #pragma mark - Building Matchers
 
 - (KWUserDefinedMatcher *)matcherForSelector:(SEL)selector subject:(id)subject;
@@ -8,9 +8,13 @@
 
 #import "KWMatchers.h"
 #import "KWUserDefinedMatcher.h"
+#import <pthread.h>
 
 @interface KWMatchers() {
-    NSMutableDictionary *userDefinedMatchers;
+    // Matchers are looked up by every expectation that no matcher class
+    // answers, possibly on several threads, and are rarely defined.
+    pthread_rwlock_t lock;
+    CFMutableDictionaryRef userDefinedMatchers;
 }
 @end
 
@@ -33,11 +37,17 @@ static id sharedMatchers = nil;
 - (id)init {
     self = [super init];
     if (self) {
-        userDefinedMatchers = [[NSMutableDictionary alloc] init];
+        pthread_rwlock_init(&lock, NULL);
+        userDefinedMatchers = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
     }
     return self;
 }
 
+- (void)dealloc {
+    pthread_rwlock_destroy(&lock);
+    CFRelease(userDefinedMatchers);
+}
+
 #pragma mark - Defining Matchers
 
 + (void)defineMatcher:(NSString *)selectorString as:(KWMatchersBuildingBlock)block {
@@ -47,22 +57,39 @@ static id sharedMatchers = nil;
 - (void)defineMatcher:(NSString *)selectorString as:(KWMatchersBuildingBlock)block {
     KWUserDefinedMatcherBuilder *builder = [KWUserDefinedMatcherBuilder builderForSelector:NSSelectorFromString(selectorString)];
     block(builder);
-    userDefinedMatchers[builder.key] = builder;
+    [self addUserDefinedMatcherBuilder:builder];
 }
 
 - (void)addUserDefinedMatcherBuilder:(KWUserDefinedMatcherBuilder *)builder {
-    userDefinedMatchers[builder.key] = builder;
+    // Selectors are unique, so they can be compared by address. The
+    // definition is compiled now, and later changes to the builder are not
+    // seen by expectations.
+    KWUserDefinedMatcherDescriptor *descriptor = [builder descriptor];
+    pthread_rwlock_wrlock(&lock);
+    CFDictionarySetValue(userDefinedMatchers, descriptor.selector, (__bridge const void *)descriptor);
+    pthread_rwlock_unlock(&lock);
 }
 
-#pragma mark - Building Matchers
-
-- (KWUserDefinedMatcher *)matcherForSelector:(SEL)selector subject:(id)subject {
-    KWUserDefinedMatcherBuilder *builder = userDefinedMatchers[NSStringFromSelector(selector)];
+#pragma mark - Getting Matcher Definitions
 
-    if (builder == nil)
+- (KWUserDefinedMatcherDescriptor *)descriptorForSelector:(SEL)selector {
+    if (selector == NULL)
         return nil;
 
-    return [builder buildMatcherWithSubject:subject];
+    pthread_rwlock_rdlock(&lock);
+    KWUserDefinedMatcherDescriptor *descriptor = (__bridge KWUserDefinedMatcherDescriptor *)CFDictionaryGetValue(userDefinedMatchers, selector);
+    pthread_rwlock_unlock(&lock);
+    return descriptor;
+}
+
+- (NSMethodSignature *)methodSignatureForMatcherSelector:(SEL)selector {
+    return [self descriptorForSelector:selector].methodSignature;
+}
+
+#pragma mark - Building Matchers
+
+- (KWUserDefinedMatcher *)matcherForSelector:(SEL)selector subject:(id)subject {
+    return [[self descriptorForSelector:selector] matcherWithSubject:subject];
 }
 
 
@@ -30,6 +30,18 @@
 - (void)setWillEvaluateMultipleTimes:(BOOL)shouldEvaluateMultipleTimes;
 - (void)setWillEvaluateAgainstNegativeExpectation:(BOOL)willEvaluateAgainstNegativeExpectation;
 
+// YES if configuring and evaluating the matcher only reads its
+// configuration, and calls no code of its subject beyond class, protocol
+// and selector checks and the accessors of numbers. Copies of one
+// configured matcher can then be evaluated against many subjects on
+// several threads at once.
++ (BOOL)isSideEffectFree;
+
+// YES if one configured matcher can be evaluated against many subjects in
+// turn on the calling thread, though evaluating it calls code of the
+// subject, such as -isEqual: or -compare:. Implied by +isSideEffectFree.
++ (BOOL)isReusableForSubjects;
+
 @required
 
 - (BOOL)evaluate;
@@ -6,6 +6,7 @@
 
 #import "KWMessagePattern.h"
 #import "KWAny.h"
+#import "KWCounters.h"
 #import "KWFormatter.h"
 #import "KWNull.h"
 #import "KWObjCUtilities.h"
@@ -123,6 +124,7 @@
 
         // Match argument filter to object
         id argumentFilter = (self.argumentFilters)[i];
+        KWCounterIncrement(KWCounterArgumentFiltersEvaluated);
 
         if ([argumentFilter isEqual:[KWAny any]]) {
             continue;
@@ -155,7 +157,13 @@
 }
 
 - (BOOL)matchesInvocation:(NSInvocation *)anInvocation {
-    return self.selector == [anInvocation selector] && [self argumentFiltersMatchInvocationArguments:anInvocation];
+    KWCounterIncrement(KWCounterMessagePatternMatchAttempts);
+
+    if (self.selector != [anInvocation selector] || ![self argumentFiltersMatchInvocationArguments:anInvocation])
+        return NO;
+
+    KWCounterIncrement(KWCounterMessagePatternMatches);
+    return YES;
 }
 
 #pragma mark - Comparing Message Patterns
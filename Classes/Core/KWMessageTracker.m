@@ -5,6 +5,7 @@
 //
 
 #import "KWMessageTracker.h"
+#import "KWInvocationJournal.h"
 #import "KWMessagePattern.h"
 #import "NSObject+KiwiStubAdditions.h"
 
@@ -12,7 +13,10 @@
 
 #pragma mark - Properties
 
-@property (nonatomic, assign) NSUInteger receivedCount;
+@property (nonatomic, assign) NSUInteger spiedCount;
+@property (nonatomic, readonly) KWInvocationJournal *journal;
+@property (nonatomic, readonly) uint64_t firstSequenceNumber;
+@property (nonatomic, assign) BOOL watchingJournal;
 
 @end
 
@@ -27,12 +31,28 @@
         _messagePattern = aMessagePattern;
         _countType = aCountType;
         _count = aCount;
-        [anObject addMessageSpy:self forMessagePattern:aMessagePattern];
+
+        // Patterns without argument filters match on the selector alone, so
+        // they are counted from the subject's journal when asked instead of
+        // being matched against every message the subject receives. The
+        // journal only records while a tracker is watching it.
+        if (aMessagePattern.argumentFilters == nil) {
+            _journal = [anObject invocationJournalForMessagePattern:aMessagePattern];
+            _firstSequenceNumber = [_journal beginWatching];
+            _watchingJournal = YES;
+        } else {
+            [anObject addMessageSpy:self forMessagePattern:aMessagePattern];
+        }
     }
 
     return self;
 }
 
+- (void)dealloc {
+    if (_watchingJournal)
+        [_journal endWatchingAfterSequenceNumber:_firstSequenceNumber];
+}
+
 + (id)messageTrackerWithSubject:(id)anObject messagePattern:(KWMessagePattern *)aMessagePattern countType:(KWCountType)aCountType count:(NSUInteger)aCount {
     return [[self alloc] initWithSubject:anObject messagePattern:aMessagePattern countType:aCountType count:aCount];
 }
@@ -43,13 +63,34 @@
     if (![self.messagePattern matchesInvocation:anInvocation])
         return;
 
-    ++self.receivedCount;
+    ++self.spiedCount;
+}
+
+#pragma mark - Counting Messages
+
+- (NSUInteger)receivedCount {
+    if (!self.watchingJournal)
+        return self.spiedCount;
+
+    return [self.journal countOfEntriesWithSelector:self.messagePattern.selector
+                                afterSequenceNumber:self.firstSequenceNumber
+                                 upToSequenceNumber:UINT64_MAX];
 }
 
 #pragma mark - Stopping Tracking
 
 - (void)stopTracking {
-    [self.subject removeMessageSpy:self forMessagePattern:self.messagePattern];
+    if (self.journal != nil) {
+        // Keep the count so the journal can drop the entries once no other
+        // tracker is watching them.
+        if (self.watchingJournal) {
+            self.spiedCount = self.receivedCount;
+            self.watchingJournal = NO;
+            [self.journal endWatchingAfterSequenceNumber:self.firstSequenceNumber];
+        }
+    } else {
+        [self.subject removeMessageSpy:self forMessagePattern:self.messagePattern];
+    }
 }
 
 #pragma mark - Getting Message Tracker Status
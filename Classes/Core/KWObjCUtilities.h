@@ -6,6 +6,52 @@
 
 #import "KiwiConfiguration.h"
 
+#pragma mark - Objective-C Type Descriptors
+
+typedef NS_ENUM(NSUInteger, KWObjCTypeKind) {
+    KWObjCTypeKindOther = 0,
+    KWObjCTypeKindVoid,
+    KWObjCTypeKindIntegral,
+    KWObjCTypeKindFloatingPoint,
+    KWObjCTypeKindObject,
+    KWObjCTypeKindBlock,
+    KWObjCTypeKindClass,
+    KWObjCTypeKindSelector,
+    KWObjCTypeKindCharString,
+    KWObjCTypeKindPointer,
+    KWObjCTypeKindStruct,
+    KWObjCTypeKindUnion,
+    KWObjCTypeKindArray,
+    KWObjCTypeKindUnknown
+};
+
+typedef NS_OPTIONS(NSUInteger, KWObjCTypeTraits) {
+    KWObjCTypeTraitSignedIntegral   = 1 << 0,
+    KWObjCTypeTraitUnsignedIntegral = 1 << 1,
+    KWObjCTypeTraitFloatingPoint    = 1 << 2,
+    KWObjCTypeTraitBoolean          = 1 << 3,
+    KWObjCTypeTraitObject           = 1 << 4,
+    KWObjCTypeTraitBlock            = 1 << 5,
+    KWObjCTypeTraitCharString       = 1 << 6,
+    KWObjCTypeTraitClass            = 1 << 7,
+    KWObjCTypeTraitSelector         = 1 << 8,
+    KWObjCTypeTraitPointerToType    = 1 << 9,
+    KWObjCTypeTraitUnknown          = 1 << 10,
+    KWObjCTypeTraitSizeKnown        = 1 << 11
+};
+
+// Descriptors are interned: there is exactly one per distinct encoding
+// string, it is never deallocated, and it may be read from any thread.
+typedef struct KWObjCTypeDescriptor {
+    const char *objCType;
+    KWObjCTypeKind kind;
+    KWObjCTypeTraits traits;
+    NSUInteger size;
+    NSUInteger alignment;
+} KWObjCTypeDescriptor;
+
+const KWObjCTypeDescriptor *KWObjCTypeDescriptorForObjCType(const char *objCType);
+
 #pragma mark - Objective-C Type Utilities
 
 BOOL KWObjCTypeEqualToObjCType(const char *firstObjCType, const char *secondObjCType);
@@ -6,59 +6,263 @@
 
 #import "KWObjCUtilities.h"
 #import "KWStringUtilities.h"
+#import <pthread.h>
+#import <stdatomic.h>
+
+#pragma mark - Classifying Objective-C Types
+
+// These perform the actual classification of an encoding. They are only
+// consulted once per distinct encoding; everything else reads the interned
+// descriptor.
+
+static BOOL KWObjCTypeMatchesAny(const char *objCType, const char * const *candidates, NSUInteger count) {
+    for (NSUInteger i = 0; i < count; ++i) {
+        if (strcmp(objCType, candidates[i]) == 0)
+            return YES;
+    }
+
+    return NO;
+}
+
+static KWObjCTypeTraits KWObjCTypeClassifyTraits(const char *objCType) {
+    static const char * const signedTypes[] = { @encode(char), @encode(int), @encode(short), @encode(long), @encode(long long) };
+    static const char * const unsignedTypes[] = { @encode(unsigned char), @encode(unsigned int), @encode(unsigned short), @encode(unsigned long), @encode(unsigned long long) };
+    static const char * const floatingPointTypes[] = { @encode(float), @encode(double) };
+    static const char * const booleanTypes[] = { @encode(BOOL), @encode(bool) };
+    KWObjCTypeTraits traits = 0;
+
+    if (KWObjCTypeMatchesAny(objCType, signedTypes, sizeof(signedTypes) / sizeof(*signedTypes)))
+        traits |= KWObjCTypeTraitSignedIntegral;
+    if (KWObjCTypeMatchesAny(objCType, unsignedTypes, sizeof(unsignedTypes) / sizeof(*unsignedTypes)))
+        traits |= KWObjCTypeTraitUnsignedIntegral;
+    if (KWObjCTypeMatchesAny(objCType, floatingPointTypes, sizeof(floatingPointTypes) / sizeof(*floatingPointTypes)))
+        traits |= KWObjCTypeTraitFloatingPoint;
+    if (KWObjCTypeMatchesAny(objCType, booleanTypes, sizeof(booleanTypes) / sizeof(*booleanTypes)))
+        traits |= KWObjCTypeTraitBoolean;
+    if (strcmp(objCType, "@?") == 0)
+        traits |= KWObjCTypeTraitObject | KWObjCTypeTraitBlock;
+    if (strcmp(objCType, @encode(id)) == 0)
+        traits |= KWObjCTypeTraitObject;
+    if (strcmp(objCType, @encode(char *)) == 0)
+        traits |= KWObjCTypeTraitCharString;
+    if (strcmp(objCType, @encode(Class)) == 0)
+        traits |= KWObjCTypeTraitClass;
+    if (strcmp(objCType, @encode(SEL)) == 0)
+        traits |= KWObjCTypeTraitSelector;
+    if (*objCType == '^')
+        traits |= KWObjCTypeTraitPointerToType;
+    if (*objCType == '?')
+        traits |= KWObjCTypeTraitUnknown;
+
+    return traits;
+}
+
+static KWObjCTypeKind KWObjCTypeClassifyKind(const char *objCType, KWObjCTypeTraits traits) {
+    if (traits & KWObjCTypeTraitBlock)
+        return KWObjCTypeKindBlock;
+    if (traits & KWObjCTypeTraitObject)
+        return KWObjCTypeKindObject;
+    if (traits & KWObjCTypeTraitClass)
+        return KWObjCTypeKindClass;
+    if (traits & KWObjCTypeTraitSelector)
+        return KWObjCTypeKindSelector;
+    if (traits & KWObjCTypeTraitCharString)
+        return KWObjCTypeKindCharString;
+    if (traits & KWObjCTypeTraitFloatingPoint)
+        return KWObjCTypeKindFloatingPoint;
+    if (traits & (KWObjCTypeTraitSignedIntegral | KWObjCTypeTraitUnsignedIntegral))
+        return KWObjCTypeKindIntegral;
+
+    switch (*objCType) {
+        case 'v': return KWObjCTypeKindVoid;
+        case '^': return KWObjCTypeKindPointer;
+        case '{': return KWObjCTypeKindStruct;
+        case '(': return KWObjCTypeKindUnion;
+        case '[': return KWObjCTypeKindArray;
+        case '?': return KWObjCTypeKindUnknown;
+        default: return KWObjCTypeKindOther;
+    }
+}
+
+static KWObjCTypeDescriptor *KWObjCTypeDescriptorCreate(const char *objCType) {
+    KWObjCTypeDescriptor *descriptor = calloc(1, sizeof(KWObjCTypeDescriptor));
+    descriptor->objCType = strdup(objCType);
+    descriptor->traits = KWObjCTypeClassifyTraits(objCType);
+    descriptor->kind = KWObjCTypeClassifyKind(objCType, descriptor->traits);
+
+    // Not every encoding can be sized (e.g. bare '?'). Remember that instead
+    // of raising here, so that only callers that actually ask for the size
+    // see the exception, exactly as before.
+    @try {
+        NSGetSizeAndAlignment(objCType, &descriptor->size, &descriptor->alignment);
+        descriptor->traits |= KWObjCTypeTraitSizeKnown;
+    } @catch (NSException *exception) {
+        descriptor->size = 0;
+        descriptor->alignment = 0;
+    }
+
+    return descriptor;
+}
+
+#pragma mark - Objective-C Type Descriptors
+
+// Descriptors are kept in an open addressing table that readers probe
+// without taking a lock. Writers serialize on KWObjCTypeDescriptorsLock and
+// only ever fill empty slots, so readers see a slot either empty or holding
+// its final descriptor. A table that gets half full is replaced by one twice
+// its size. Replaced tables are never freed, since readers may still be
+// probing them; they add up to less than the table that replaced them.
+
+typedef struct KWObjCTypeDescriptorTable {
+    NSUInteger mask;
+    NSUInteger count;
+    _Atomic(const KWObjCTypeDescriptor *) slots[];
+} KWObjCTypeDescriptorTable;
+
+static const NSUInteger KWObjCTypeDescriptorTableInitialCapacity = 64;
+
+static _Atomic(KWObjCTypeDescriptorTable *) KWObjCTypeDescriptors = NULL;
+static pthread_mutex_t KWObjCTypeDescriptorsLock = PTHREAD_MUTEX_INITIALIZER;
+
+static NSUInteger KWObjCTypeHash(const char *objCType) {
+    // FNV-1a; encodings are short.
+    NSUInteger hash = 2166136261u;
+    for (const unsigned char *c = (const unsigned char *)objCType; *c != '\0'; ++c)
+        hash = (hash ^ *c) * 16777619u;
+    return hash;
+}
+
+static KWObjCTypeDescriptorTable *KWObjCTypeDescriptorTableCreate(NSUInteger capacity) {
+    KWObjCTypeDescriptorTable *table = calloc(1, sizeof(KWObjCTypeDescriptorTable) + capacity * sizeof(table->slots[0]));
+    table->mask = capacity - 1;
+    return table;
+}
+
+static const KWObjCTypeDescriptor *KWObjCTypeDescriptorTableLookup(KWObjCTypeDescriptorTable *table, const char *objCType, NSUInteger hash) {
+    if (table == NULL)
+        return NULL;
+
+    // Tables are never full, so every probe ends at an empty slot.
+    for (NSUInteger i = hash & table->mask;; i = (i + 1) & table->mask) {
+        const KWObjCTypeDescriptor *descriptor = atomic_load_explicit(&table->slots[i], memory_order_acquire);
+
+        if (descriptor == NULL || strcmp(descriptor->objCType, objCType) == 0)
+            return descriptor;
+    }
+}
+
+// Must be called with KWObjCTypeDescriptorsLock held.
+static void KWObjCTypeDescriptorTableInsert(KWObjCTypeDescriptorTable *table, const KWObjCTypeDescriptor *descriptor) {
+    NSUInteger i = KWObjCTypeHash(descriptor->objCType) & table->mask;
+
+    while (atomic_load_explicit(&table->slots[i], memory_order_relaxed) != NULL)
+        i = (i + 1) & table->mask;
+
+    atomic_store_explicit(&table->slots[i], descriptor, memory_order_release);
+    ++table->count;
+}
+
+// Must be called with KWObjCTypeDescriptorsLock held.
+static void KWObjCTypeDescriptorsInsert(const KWObjCTypeDescriptor *descriptor) {
+    KWObjCTypeDescriptorTable *table = atomic_load_explicit(&KWObjCTypeDescriptors, memory_order_relaxed);
+
+    if (table != NULL && (table->count + 1) * 2 <= table->mask + 1) {
+        KWObjCTypeDescriptorTableInsert(table, descriptor);
+        return;
+    }
+
+    KWObjCTypeDescriptorTable *grownTable = KWObjCTypeDescriptorTableCreate(table != NULL ? (table->mask + 1) * 2 : KWObjCTypeDescriptorTableInitialCapacity);
+
+    for (NSUInteger i = 0; table != NULL && i <= table->mask; ++i) {
+        const KWObjCTypeDescriptor *existingDescriptor = atomic_load_explicit(&table->slots[i], memory_order_relaxed);
+
+        if (existingDescriptor != NULL)
+            KWObjCTypeDescriptorTableInsert(grownTable, existingDescriptor);
+    }
+
+    KWObjCTypeDescriptorTableInsert(grownTable, descriptor);
+    atomic_store_explicit(&KWObjCTypeDescriptors, grownTable, memory_order_release);
+}
+
+const KWObjCTypeDescriptor *KWObjCTypeDescriptorForObjCType(const char *objCType) {
+    NSUInteger hash = KWObjCTypeHash(objCType);
+    const KWObjCTypeDescriptor *descriptor = KWObjCTypeDescriptorTableLookup(atomic_load_explicit(&KWObjCTypeDescriptors, memory_order_acquire), objCType, hash);
+
+    if (descriptor != NULL)
+        return descriptor;
+
+    // Classify outside of the lock; NSGetSizeAndAlignment can be slow for
+    // large aggregates and must never raise while the lock is held.
+    KWObjCTypeDescriptor *newDescriptor = KWObjCTypeDescriptorCreate(objCType);
+
+    pthread_mutex_lock(&KWObjCTypeDescriptorsLock);
+    descriptor = KWObjCTypeDescriptorTableLookup(atomic_load_explicit(&KWObjCTypeDescriptors, memory_order_relaxed), objCType, hash);
+    if (descriptor == NULL) {
+        KWObjCTypeDescriptorsInsert(newDescriptor);
+        descriptor = newDescriptor;
+        newDescriptor = NULL;
+    }
+    pthread_mutex_unlock(&KWObjCTypeDescriptorsLock);
+
+    // Another thread interned the same encoding first.
+    if (newDescriptor != NULL) {
+        free((void *)newDescriptor->objCType);
+        free(newDescriptor);
+    }
+
+    return descriptor;
+}
+
+static inline BOOL KWObjCTypeHasTraits(const char *objCType, KWObjCTypeTraits traits) {
+    return (KWObjCTypeDescriptorForObjCType(objCType)->traits & traits) != 0;
+}
 
 #pragma mark - Objective-C Type Utilities
 
 BOOL KWObjCTypeEqualToObjCType(const char *firstObjCType, const char *secondObjCType) {
-    return strcmp(firstObjCType, secondObjCType) == 0;
+    return firstObjCType == secondObjCType || strcmp(firstObjCType, secondObjCType) == 0;
 }
 
 BOOL KWObjCTypeIsNumeric(const char *objCType) {
-    return KWObjCTypeIsFloatingPoint(objCType) || KWObjCTypeIsIntegral(objCType);
+    return KWObjCTypeHasTraits(objCType, KWObjCTypeTraitFloatingPoint |
+                                         KWObjCTypeTraitSignedIntegral |
+                                         KWObjCTypeTraitUnsignedIntegral);
 }
 
 BOOL KWObjCTypeIsFloatingPoint(const char *objCType) {
-    return strcmp(objCType, @encode(float)) == 0 || strcmp(objCType, @encode(double)) == 0;
+    return KWObjCTypeHasTraits(objCType, KWObjCTypeTraitFloatingPoint);
 }
 
 BOOL KWObjCTypeIsIntegral(const char *objCType) {
-    return KWObjCTypeIsSignedIntegral(objCType) || KWObjCTypeIsUnsignedIntegral(objCType);
+    return KWObjCTypeHasTraits(objCType, KWObjCTypeTraitSignedIntegral | KWObjCTypeTraitUnsignedIntegral);
 }
 
 BOOL KWObjCTypeIsSignedIntegral(const char *objCType) {
-    return strcmp(objCType, @encode(char)) == 0 ||
-           strcmp(objCType, @encode(int)) == 0 ||
-           strcmp(objCType, @encode(short)) == 0 ||
-           strcmp(objCType, @encode(long)) == 0 ||
-           strcmp(objCType, @encode(long long)) == 0;
+    return KWObjCTypeHasTraits(objCType, KWObjCTypeTraitSignedIntegral);
 }
 
 BOOL KWObjCTypeIsUnsignedIntegral(const char *objCType) {
-    return strcmp(objCType, @encode(unsigned char)) == 0 ||
-           strcmp(objCType, @encode(unsigned int)) == 0 ||
-           strcmp(objCType, @encode(unsigned short)) == 0 ||
-           strcmp(objCType, @encode(unsigned long)) == 0 ||
-           strcmp(objCType, @encode(unsigned long long)) == 0;
+    return KWObjCTypeHasTraits(objCType, KWObjCTypeTraitUnsignedIntegral);
 }
 
 BOOL KWObjCTypeIsBoolean(const char *objCType) {
-    return strcmp(objCType, @encode(BOOL)) == 0 || strcmp(objCType, @encode(bool)) == 0;
+    return KWObjCTypeHasTraits(objCType, KWObjCTypeTraitBoolean);
 }
 
 BOOL KWObjCTypeIsObject(const char *objCType) {
-    return strcmp(objCType, @encode(id)) == 0 || strcmp(objCType, "@?") == 0;
+    return KWObjCTypeHasTraits(objCType, KWObjCTypeTraitObject);
 }
 
 BOOL KWObjCTypeIsCharString(const char *objCType) {
-    return strcmp(objCType, @encode(char *)) == 0;
+    return KWObjCTypeHasTraits(objCType, KWObjCTypeTraitCharString);
 }
 
 BOOL KWObjCTypeIsClass(const char *objCType) {
-    return strcmp(objCType, @encode(Class)) == 0;
+    return KWObjCTypeHasTraits(objCType, KWObjCTypeTraitClass);
 }
 
 BOOL KWObjCTypeIsSelector(const char *objCType) {
-    return strcmp(objCType, @encode(SEL)) == 0;
+    return KWObjCTypeHasTraits(objCType, KWObjCTypeTraitSelector);
 }
 
 BOOL KWObjCTypeIsPointerToType(const char *objCType) {
@@ -66,11 +270,11 @@ BOOL KWObjCTypeIsPointerToType(const char *objCType) {
 }
 
 BOOL KWObjCTypeIsPointerLike(const char *objCType) {
-    return KWObjCTypeIsObject(objCType) ||
-           KWObjCTypeIsCharString(objCType) ||
-           KWObjCTypeIsClass(objCType) ||
-           KWObjCTypeIsSelector(objCType) ||
-           KWObjCTypeIsPointerToType(objCType);
+    return KWObjCTypeHasTraits(objCType, KWObjCTypeTraitObject |
+                                         KWObjCTypeTraitCharString |
+                                         KWObjCTypeTraitClass |
+                                         KWObjCTypeTraitSelector |
+                                         KWObjCTypeTraitPointerToType);
 }
 
 BOOL KWObjCTypeIsUnknown(const char *objCType) {
@@ -78,13 +282,18 @@ BOOL KWObjCTypeIsUnknown(const char *objCType) {
 }
 
 NSUInteger KWObjCTypeLength(const char *objCType) {
+    const KWObjCTypeDescriptor *descriptor = KWObjCTypeDescriptorForObjCType(objCType);
+    if (descriptor->traits & KWObjCTypeTraitSizeKnown)
+        return descriptor->size;
+
+    // Let the runtime raise for encodings it cannot size.
 	NSUInteger typeSize = 0;
 	NSGetSizeAndAlignment(objCType, &typeSize, NULL);
 	return typeSize;
 }
 
 BOOL KWObjCTypeIsBlock(const char *objCType) {
-    return strcmp(objCType, "@?") == 0;
+    return KWObjCTypeHasTraits(objCType, KWObjCTypeTraitBlock);
 }
 
 
@@ -7,6 +7,7 @@
 //
 
 #import "KWProbePoller.h"
+#import "KWCounters.h"
 
 @interface KWTimeout : NSObject
 
@@ -63,7 +64,9 @@
             return [probe isSatisfied];
         }
 		CFRunLoopRunInMode(kCFRunLoopDefaultMode, _delayInterval, false);
+        KWCounterIncrement(KWCounterRunLoopSpins);
         [probe sample];
+        KWCounterIncrement(KWCounterProbePolls);
     }
     
     return YES;
@@ -0,0 +1,51 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KiwiConfiguration.h"
+#import "KWResultReporting.h"
+
+@class KWExampleResult;
+
+// Hands example results to reporters on a background queue. Reporting a
+// result only pushes it onto a lock-free queue, so examples never wait for
+// reporters or their I/O.
+//
+// The shared reporter is set up from the environment:
+//
+//   KW_REPORT_CONSOLE=1          human readable results on stderr
+//   KW_REPORT_JSON_LINES=<path>  one JSON object per example
+//   KW_REPORT_JUNIT=<path>       JUnit XML
+//   KW_REPORT_NSLOG=0|1          whether examples also log their results;
+//                                on unless a file reporter is set up
+@interface KWResultReporter : NSObject
+
+#pragma mark - Initializing
+
++ (KWResultReporter *)sharedReporter;
+
+#pragma mark - Managing Reporters
+
+- (void)addReporter:(id<KWResultReporting>)aReporter;
+
+// Hands the results reported so far to aReporter before removing it.
+- (void)removeReporter:(id<KWResultReporting>)aReporter;
+
+@property (nonatomic, readonly) BOOL hasReporters;
+@property (nonatomic, assign) BOOL logsResults;
+
+#pragma mark - Reporting Results
+
+// Returns immediately. Results reported by a process forked after the
+// reporter was set up are dropped, because the background queue does not
+// survive fork(). Processes that fork workers must set up the shared
+// reporter first, so that workers never open the report files themselves.
+- (void)reportResult:(KWExampleResult *)aResult;
+
+// Waits until every result reported so far has been handed to the
+// reporters, then has them write out what they buffered.
+- (void)finishReporting;
+
+@end
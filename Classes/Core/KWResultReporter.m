@@ -0,0 +1,166 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KWResultReporter.h"
+#import "KWConsoleReporter.h"
+#import "KWExampleResult.h"
+#import "KWJSONLinesReporter.h"
+#import "KWJUnitReporter.h"
+#import <pthread.h>
+#import <stdatomic.h>
+#import <unistd.h>
+
+// Results are pushed onto a singly linked stack by any thread and taken off
+// all at once by the background queue.
+typedef struct KWResultReporterNode {
+    struct KWResultReporterNode *next;
+    void *result;
+} KWResultReporterNode;
+
+static pid_t KWResultReporterProcess = 0;
+
+@interface KWResultReporter() {
+    _Atomic(KWResultReporterNode *) _pendingResults;
+}
+
+@property (nonatomic, readonly) NSMutableArray *reporters;
+@property (nonatomic, readonly) dispatch_queue_t queue;
+@property (nonatomic, readonly) dispatch_source_t source;
+@property (nonatomic, readwrite) BOOL hasReporters;
+
+@end
+
+@implementation KWResultReporter
+
+#pragma mark - Initializing
+
++ (KWResultReporter *)sharedReporter {
+    static KWResultReporter *sharedReporter = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedReporter = [[self alloc] init];
+        [sharedReporter addReportersFromEnvironment:[[NSProcessInfo processInfo] environment]];
+    });
+
+    return sharedReporter;
+}
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        atomic_init(&_pendingResults, NULL);
+        _reporters = [[NSMutableArray alloc] init];
+        _queue = dispatch_queue_create("org.kiwi-bdd.result-reporter", DISPATCH_QUEUE_SERIAL);
+        _source = dispatch_source_create(DISPATCH_SOURCE_TYPE_DATA_ADD, 0, 0, _queue);
+        _logsResults = YES;
+        KWResultReporterProcess = getpid();
+
+        __weak KWResultReporter *weakSelf = self;
+        dispatch_source_set_event_handler(_source, ^{
+            [weakSelf drainPendingResults];
+        });
+        dispatch_resume(_source);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    dispatch_source_cancel(_source);
+}
+
+- (void)addReportersFromEnvironment:(NSDictionary *)environment {
+    BOOL hasFileReporters = NO;
+
+    if ([environment[@"KW_REPORT_CONSOLE"] length] > 0 && ![environment[@"KW_REPORT_CONSOLE"] isEqualToString:@"0"])
+        [self addReporter:[[KWConsoleReporter alloc] initWithFileDescriptor:STDERR_FILENO]];
+
+    if ([environment[@"KW_REPORT_JSON_LINES"] length] > 0) {
+        [self addReporter:[[KWJSONLinesReporter alloc] initWithPath:environment[@"KW_REPORT_JSON_LINES"]]];
+        hasFileReporters = YES;
+    }
+
+    if ([environment[@"KW_REPORT_JUNIT"] length] > 0) {
+        [self addReporter:[[KWJUnitReporter alloc] initWithPath:environment[@"KW_REPORT_JUNIT"]]];
+        hasFileReporters = YES;
+    }
+
+    NSString *logsResults = environment[@"KW_REPORT_NSLOG"];
+    self.logsResults = [logsResults length] > 0 ? ![logsResults isEqualToString:@"0"] : !hasFileReporters;
+}
+
+#pragma mark - Managing Reporters
+
+- (void)addReporter:(id<KWResultReporting>)aReporter {
+    self.hasReporters = YES;
+    dispatch_sync(self.queue, ^{
+        [self.reporters addObject:aReporter];
+    });
+}
+
+- (void)removeReporter:(id<KWResultReporting>)aReporter {
+    dispatch_sync(self.queue, ^{
+        [self drainPendingResults];
+        [self.reporters removeObjectIdenticalTo:aReporter];
+        self.hasReporters = [self.reporters count] > 0;
+    });
+}
+
+#pragma mark - Reporting Results
+
+- (void)reportResult:(KWExampleResult *)aResult {
+    if (!self.hasReporters || getpid() != KWResultReporterProcess)
+        return;
+
+    KWResultReporterNode *node = malloc(sizeof(KWResultReporterNode));
+    node->result = (__bridge_retained void *)aResult;
+    node->next = atomic_load_explicit(&_pendingResults, memory_order_relaxed);
+
+    while (!atomic_compare_exchange_weak_explicit(&_pendingResults, &node->next, node, memory_order_release, memory_order_relaxed));
+
+    dispatch_source_merge_data(self.source, 1);
+}
+
+// Only called on the queue.
+- (void)drainPendingResults {
+    KWResultReporterNode *node = atomic_exchange_explicit(&_pendingResults, NULL, memory_order_acquire);
+    KWResultReporterNode *reversed = NULL;
+
+    // The stack holds the latest result first.
+    while (node != NULL) {
+        KWResultReporterNode *next = node->next;
+        node->next = reversed;
+        reversed = node;
+        node = next;
+    }
+
+    while (reversed != NULL) {
+        KWResultReporterNode *next = reversed->next;
+        KWExampleResult *result = (__bridge_transfer KWExampleResult *)reversed->result;
+        free(reversed);
+        reversed = next;
+
+        for (id<KWResultReporting> reporter in self.reporters) {
+            for (KWFailure *failure in result.failures)
+                [reporter reportFailure:failure];
+
+            [reporter reportResult:result];
+        }
+    }
+}
+
+- (void)finishReporting {
+    if (!self.hasReporters || getpid() != KWResultReporterProcess)
+        return;
+
+    dispatch_sync(self.queue, ^{
+        [self drainPendingResults];
+
+        for (id<KWResultReporting> reporter in self.reporters)
+            [reporter finishReporting];
+    });
+}
+
+@end
@@ -0,0 +1,25 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KiwiConfiguration.h"
+#import "KWReporting.h"
+
+@class KWExampleResult;
+
+// Reporters added to the shared KWResultReporter. All messages are sent on
+// the reporter's background queue, one at a time, so reporters do not need
+// to be thread safe. Each failure of an example is reported before the
+// result of the example.
+@protocol KWResultReporting<KWReporting>
+
+#pragma mark - Reporting Results
+
+- (void)reportResult:(KWExampleResult *)aResult;
+
+// Sent when a run ends. Reporters write out anything they buffered.
+- (void)finishReporting;
+
+@end
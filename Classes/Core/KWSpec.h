@@ -26,4 +26,14 @@
 + (NSString *)file;
 + (void)buildExampleGroups;
 
+#pragma mark - Reading Engine Counters
+
+// Counts of the work done by the mocking and matching engine, keyed by
+// counter name (see KWCounters.h). The first method counts since the process
+// started; the second counts for the running example, or the one that ran
+// last. Set KW_COUNTERS=1 to log the counts of every example and of the
+// whole run.
++ (NSDictionary *)engineCounters;
++ (NSDictionary *)engineCountersForCurrentExample;
+
 @end
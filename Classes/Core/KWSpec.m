@@ -6,13 +6,20 @@
 
 #import "KWSpec.h"
 #import "KWCallSite.h"
+#import "KWCounters.h"
 #import "KWExample.h"
 #import "KWExampleSuiteBuilder.h"
+#import "KWFailedExamples.h"
 #import "KWFailure.h"
 #import "KWExampleSuite.h"
 
 #import <objc/runtime.h>
 
+// Examples run one at a time on the main thread.
+static uint64_t KWSpecExampleStartCounters[KWCounterCount];
+static uint64_t KWSpecExampleEndCounters[KWCounterCount];
+static BOOL KWSpecExampleIsRunning = NO;
+
 @interface KWSpec()
 
 @property (nonatomic, strong) KWExample *currentExample;
@@ -50,7 +57,7 @@
     if ([self methodForSelector:buildExampleGroups] == [KWSpec methodForSelector:buildExampleGroups])
         return @[];
 
-    KWExampleSuite *exampleSuite = [[KWExampleSuiteBuilder sharedExampleSuiteBuilder] buildExampleSuite:^{
+    KWExampleSuite *exampleSuite = [[KWExampleSuiteBuilder sharedExampleSuiteBuilder] buildExampleSuiteForSpecName:NSStringFromClass(self) block:^{
         [self buildExampleGroups];
     }];
 
@@ -114,16 +121,52 @@
 
 - (void)runExample {
     self.currentExample = self.invocation.kw_example;
+    KWCountersRead(KWSpecExampleStartCounters);
+    KWSpecExampleIsRunning = YES;
 
     @try {
         [self.currentExample runWithDelegate:self];
     } @catch (NSException *exception) {
         [self recordFailureWithDescription:exception.description inFile:@"" atLine:0 expected:NO];
+        KWRecordFailedExample(NSStringFromClass([self class]), self.currentExample.selectorName);
+    }
+
+    KWCountersRead(KWSpecExampleEndCounters);
+    KWSpecExampleIsRunning = NO;
+
+    if (KWCountersShouldLog()) {
+        uint64_t exampleCounters[KWCounterCount];
+        [[self class] readExampleCounters:exampleCounters];
+        NSLog(@"%@ counters: %@", [self description], KWCountersDescription(exampleCounters));
     }
     
     self.invocation.kw_example = nil;
 }
 
+#pragma mark - Reading Engine Counters
+
++ (NSDictionary *)engineCounters {
+    uint64_t counters[KWCounterCount];
+    KWCountersRead(counters);
+    return KWCountersDictionary(counters);
+}
+
++ (NSDictionary *)engineCountersForCurrentExample {
+    uint64_t counters[KWCounterCount];
+    [self readExampleCounters:counters];
+    return KWCountersDictionary(counters);
+}
+
++ (void)readExampleCounters:(uint64_t *)counters {
+    if (KWSpecExampleIsRunning)
+        KWCountersRead(counters);
+    else
+        memcpy(counters, KWSpecExampleEndCounters, sizeof(KWSpecExampleEndCounters));
+
+    for (NSUInteger i = 0; i < KWCounterCount; ++i)
+        counters[i] -= KWSpecExampleStartCounters[i];
+}
+
 #pragma mark - KWExampleGroupDelegate methods
 
 - (void)example:(KWExample *)example didFailWithFailure:(KWFailure *)failure {
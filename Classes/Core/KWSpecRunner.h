@@ -0,0 +1,56 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KiwiConfiguration.h"
+#import "KWExampleDelegate.h"
+
+// Runs the examples of KWSpec subclasses directly, without going through
+// XCTest. Failures and results are written to the output as lines of text.
+@interface KWSpecRunner : NSObject<KWExampleDelegate>
+
+#pragma mark - Initializing
+
+- (id)initWithOutput:(NSFileHandle *)anOutput;
+
+#pragma mark - Finding Specs
+
+// Returns the loaded KWSpec subclasses that build example groups, sorted
+// by name.
++ (NSArray *)specClasses;
+
+#pragma mark - Ordering Specs
+
+// When set, the durations and results of examples are appended to the file
+// at this path, and later runs start with the spec classes that had failing
+// examples, followed by the others from the longest to the shortest. Spec
+// classes are never split, so contexts keep their beforeAll and afterAll
+// semantics.
+@property (nonatomic, copy) NSString *historyPath;
+
+#pragma mark - Running Specs
+
+// Runs the examples of every class between the before and after all specs
+// blocks of the suite configuration. Returns YES if no example failed.
+- (BOOL)runSpecClasses:(NSArray *)specClasses;
+
+// Builds the example suites of every class, then forks workerCount
+// processes that share them copy-on-write. Workers take whole spec classes
+// from a queue in shared memory, so beforeAll and afterAll blocks keep
+// running once per context, and stream their results back over pipes. A
+// worker that dies is replaced; the example it was running is reported as a
+// failure and the rest of its spec class is queued again. A workerCount of
+// 0 or 1 runs the examples in this process.
+//
+// Workers are not exec'd, so specs must not depend on services that do not
+// survive fork(), such as XPC connections made before the run.
+- (BOOL)runSpecClasses:(NSArray *)specClasses workerCount:(NSUInteger)workerCount;
+
+#pragma mark - Getting Results
+
+@property (nonatomic, readonly) NSUInteger exampleCount;
+@property (nonatomic, readonly) NSUInteger failureCount;
+
+@end
@@ -0,0 +1,609 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KWSpecRunner.h"
+#import "KWCallSite.h"
+#import "KWCounters.h"
+#import "KWExample.h"
+#import "KWExampleSuite.h"
+#import "KWExampleHistory.h"
+#import "KWExampleResult.h"
+#import "KWExampleSuiteBuilder.h"
+#import "KWFailedExamples.h"
+#import "KWFailure.h"
+#import "KWResultReporter.h"
+#import "KWSpec.h"
+#import "KWSuiteConfigurationBase.h"
+#import <objc/runtime.h>
+#import <poll.h>
+#import <stdatomic.h>
+#import <sys/mman.h>
+#import <sys/wait.h>
+#import <unistd.h>
+
+@interface KWSpecRunner()
+
+@property (nonatomic, strong) NSFileHandle *output;
+@property (nonatomic, readwrite) NSUInteger exampleCount;
+@property (nonatomic, readwrite) NSUInteger failureCount;
+@property (nonatomic, copy) NSString *currentExampleName;
+@property (nonatomic, assign) BOOL currentExampleFailed;
+@property (nonatomic, assign) Class currentSpecClass;
+@property (nonatomic, strong) KWExampleHistory *history;
+
+// Set on the runners of worker processes, whose output is read back line
+// by line by the parent.
+@property (nonatomic, assign) BOOL escapesFailureMessages;
+
+@end
+
+@implementation KWSpecRunner
+
+#pragma mark - Initializing
+
+- (id)initWithOutput:(NSFileHandle *)anOutput {
+    self = [super init];
+    if (self) {
+        _output = anOutput;
+    }
+    return self;
+}
+
+#pragma mark - Finding Specs
+
++ (NSArray *)specClasses {
+    Class specClass = [KWSpec class];
+    IMP defaultBuildExampleGroups = method_getImplementation(class_getClassMethod(specClass, @selector(buildExampleGroups)));
+    NSMutableArray *specClasses = [NSMutableArray array];
+    unsigned int classCount = 0;
+    Class *classes = objc_copyClassList(&classCount);
+
+    // Classes are inspected through the runtime only, because sending
+    // messages to arbitrary classes would initialize them.
+    for (unsigned int i = 0; i < classCount; ++i) {
+        Class superclass = class_getSuperclass(classes[i]);
+
+        while (superclass != Nil && superclass != specClass)
+            superclass = class_getSuperclass(superclass);
+
+        if (superclass == Nil)
+            continue;
+
+        Method buildExampleGroups = class_getClassMethod(classes[i], @selector(buildExampleGroups));
+        if (method_getImplementation(buildExampleGroups) != defaultBuildExampleGroups)
+            [specClasses addObject:classes[i]];
+    }
+
+    free(classes);
+    [specClasses sortUsingComparator:^NSComparisonResult(Class a, Class b) {
+        return [NSStringFromClass(a) compare:NSStringFromClass(b)];
+    }];
+    return specClasses;
+}
+
+#pragma mark - Running Specs
+
+- (void)writeLine:(NSString *)aLine {
+    [self.output writeData:[[aLine stringByAppendingString:@"\n"] dataUsingEncoding:NSUTF8StringEncoding]];
+}
+
+- (BOOL)runSpecClasses:(NSArray *)specClasses {
+    return [self runSpecClasses:specClasses workerCount:1];
+}
+
+- (BOOL)runSpecClasses:(NSArray *)specClasses workerCount:(NSUInteger)workerCount {
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    NSUInteger failureCount = self.failureCount;
+    NSMutableArray *exampleSuites = [NSMutableArray arrayWithCapacity:[specClasses count]];
+
+    for (Class specClass in specClasses) {
+        [exampleSuites addObject:[[KWExampleSuiteBuilder sharedExampleSuiteBuilder] buildExampleSuiteForSpecName:NSStringFromClass(specClass) block:^{
+            [specClass buildExampleGroups];
+        }]];
+    }
+
+    if (self.historyPath != nil) {
+        self.history = [[KWExampleHistory alloc] initWithPath:self.historyPath];
+        NSMutableArray *orderedSpecClasses = [specClasses mutableCopy];
+        [self orderExampleSuites:exampleSuites ofSpecClasses:orderedSpecClasses];
+        specClasses = orderedSpecClasses;
+    }
+
+    if (workerCount > 1 && [specClasses count] > 1) {
+        [self runExampleSuites:exampleSuites ofSpecClasses:specClasses workerCount:MIN(workerCount, [specClasses count])];
+    } else {
+        [[KWSuiteConfigurationBase defaultConfiguration] setUp];
+
+        for (NSUInteger i = 0; i < [specClasses count]; ++i)
+            [self runExampleSuite:exampleSuites[i] ofSpecClass:specClasses[i] fromIndex:0 progress:NULL];
+
+        [[KWSuiteConfigurationBase defaultConfiguration] tearDown];
+    }
+
+    KWWriteFailedExamples();
+    [[KWResultReporter sharedReporter] finishReporting];
+    [self writeLine:[NSString stringWithFormat:@"%lu examples, %lu failures, %.3f s",
+                     (unsigned long)self.exampleCount, (unsigned long)self.failureCount, CFAbsoluteTimeGetCurrent() - start]];
+
+    // Workers count in their own address spaces.
+    if (KWCountersShouldLog() && workerCount <= 1) {
+        uint64_t counters[KWCounterCount];
+        KWCountersRead(counters);
+        [self writeLine:[NSString stringWithFormat:@"counters: %@", KWCountersDescription(counters)]];
+    }
+
+    return self.failureCount == failureCount;
+}
+
+- (void)runExampleSuite:(KWExampleSuite *)exampleSuite ofSpecClass:(Class)specClass fromIndex:(NSUInteger)firstIndex progress:(_Atomic(int64_t) *)progress {
+    NSArray *examples = exampleSuite.examples;
+
+    for (NSUInteger i = firstIndex; i < [examples count]; ++i) {
+        if (progress != NULL)
+            atomic_store_explicit(progress, (int64_t)i, memory_order_release);
+
+        @autoreleasepool {
+            [self runExample:examples[i] ofSpecClass:specClass];
+        }
+    }
+}
+
+#pragma mark - Ordering Specs
+
+- (void)orderExampleSuites:(NSMutableArray *)exampleSuites ofSpecClasses:(NSMutableArray *)specClasses {
+    NSUInteger count = [specClasses count];
+    NSTimeInterval knownDuration = 0.0;
+    NSUInteger knownCount = 0;
+    NSUInteger unknownCounts[count];
+    NSTimeInterval durations[count];
+    BOOL failed[count];
+
+    for (NSUInteger i = 0; i < count; ++i) {
+        unknownCounts[i] = 0;
+        durations[i] = 0.0;
+        failed[i] = NO;
+
+        for (KWExample *example in exampleSuites[i]) {
+            NSTimeInterval duration = [self.history durationOfExample:example.selectorName inSpecClass:specClasses[i]];
+            failed[i] = failed[i] || [self.history exampleFailedLastRun:example.selectorName inSpecClass:specClasses[i]];
+
+            if (duration < 0.0) {
+                ++unknownCounts[i];
+            } else {
+                durations[i] += duration;
+                knownDuration += duration;
+                ++knownCount;
+            }
+        }
+    }
+
+    // New examples are expected to take as long as the average one.
+    NSTimeInterval averageDuration = knownCount > 0 ? knownDuration / knownCount : 0.0;
+    NSMutableArray *indexes = [NSMutableArray arrayWithCapacity:count];
+
+    for (NSUInteger i = 0; i < count; ++i) {
+        durations[i] += unknownCounts[i] * averageDuration;
+        [indexes addObject:@(i)];
+    }
+
+    // Blocks cannot capture variable length arrays.
+    const NSTimeInterval *suiteDurations = durations;
+    const BOOL *suiteFailed = failed;
+    [indexes sortWithOptions:NSSortStable usingComparator:^NSComparisonResult(NSNumber *a, NSNumber *b) {
+        NSUInteger i = [a unsignedIntegerValue];
+        NSUInteger j = [b unsignedIntegerValue];
+
+        if (suiteFailed[i] != suiteFailed[j])
+            return suiteFailed[i] ? NSOrderedAscending : NSOrderedDescending;
+        if (suiteDurations[i] != suiteDurations[j])
+            return suiteDurations[i] > suiteDurations[j] ? NSOrderedAscending : NSOrderedDescending;
+        return NSOrderedSame;
+    }];
+
+    NSArray *unorderedSuites = [exampleSuites copy];
+    NSArray *unorderedClasses = [specClasses copy];
+
+    for (NSUInteger i = 0; i < count; ++i) {
+        NSUInteger index = [indexes[i] unsignedIntegerValue];
+        exampleSuites[i] = unorderedSuites[index];
+        specClasses[i] = unorderedClasses[index];
+    }
+}
+
+#pragma mark - Running Specs in Worker Processes
+
+// Failure messages may span several lines, so workers escape backslashes
+// and line breaks in the messages of their error lines, and the parent
+// unescapes them again.
+static NSString *KWSpecRunnerEscapedMessage(NSString *aMessage) {
+    NSMutableString *message = [aMessage mutableCopy];
+    [message replaceOccurrencesOfString:@"\\" withString:@"\\\\" options:0 range:NSMakeRange(0, [message length])];
+    [message replaceOccurrencesOfString:@"\n" withString:@"\\n" options:0 range:NSMakeRange(0, [message length])];
+    [message replaceOccurrencesOfString:@"\r" withString:@"\\r" options:0 range:NSMakeRange(0, [message length])];
+    return message;
+}
+
+static NSString *KWSpecRunnerUnescapedMessage(NSString *aMessage) {
+    if ([aMessage rangeOfString:@"\\"].location == NSNotFound)
+        return aMessage;
+
+    NSUInteger length = [aMessage length];
+    NSMutableString *message = [NSMutableString stringWithCapacity:length];
+
+    for (NSUInteger i = 0; i < length; ++i) {
+        unichar character = [aMessage characterAtIndex:i];
+
+        if (character == '\\' && i + 1 < length) {
+            character = [aMessage characterAtIndex:++i];
+
+            if (character == 'n')
+                character = '\n';
+            else if (character == 'r')
+                character = '\r';
+        }
+
+        [message appendFormat:@"%C", character];
+    }
+
+    return message;
+}
+
+// A work item runs the examples of one spec class. Items queued again after
+// a crash start at the example following the one that crashed.
+typedef struct KWSpecRunnerWorkItem {
+    uint32_t suiteIndex;
+    uint32_t firstExampleIndex;
+} KWSpecRunnerWorkItem;
+
+// What a worker is doing, so that the parent can tell which example
+// crashed it. Indexes are -1 while the worker is between items.
+typedef struct KWSpecRunnerWorkerState {
+    _Atomic(int64_t) itemIndex;
+    _Atomic(int64_t) exampleIndex;
+} KWSpecRunnerWorkerState;
+
+// Lives in memory shared by the parent and its workers. Only the parent
+// appends items; idle workers claim the next one, so a worker stuck in a
+// slow spec class never holds up the others.
+typedef struct KWSpecRunnerWorkQueue {
+    _Atomic(uint64_t) nextItem;
+    _Atomic(uint64_t) itemCount;
+    KWSpecRunnerWorkerState *workers;
+    KWSpecRunnerWorkItem *items;
+} KWSpecRunnerWorkQueue;
+
+static BOOL KWSpecRunnerClaimWorkItem(KWSpecRunnerWorkQueue *queue, uint64_t *anItemIndex) {
+    uint64_t itemIndex = atomic_load_explicit(&queue->nextItem, memory_order_acquire);
+
+    do {
+        if (itemIndex >= atomic_load_explicit(&queue->itemCount, memory_order_acquire))
+            return NO;
+    } while (!atomic_compare_exchange_weak_explicit(&queue->nextItem, &itemIndex, itemIndex + 1, memory_order_acq_rel, memory_order_acquire));
+
+    *anItemIndex = itemIndex;
+    return YES;
+}
+
+static void KWSpecRunnerAppendWorkItem(KWSpecRunnerWorkQueue *queue, KWSpecRunnerWorkItem item) {
+    uint64_t itemCount = atomic_load_explicit(&queue->itemCount, memory_order_relaxed);
+    queue->items[itemCount] = item;
+    atomic_store_explicit(&queue->itemCount, itemCount + 1, memory_order_release);
+}
+
+- (void)runWorker:(NSUInteger)workerIndex queue:(KWSpecRunnerWorkQueue *)queue exampleSuites:(NSArray *)exampleSuites specClasses:(NSArray *)specClasses output:(int)fd {
+    KWSpecRunnerWorkerState *state = &queue->workers[workerIndex];
+    KWSpecRunner *runner = [[KWSpecRunner alloc] initWithOutput:[[NSFileHandle alloc] initWithFileDescriptor:fd closeOnDealloc:YES]];
+    runner.history = self.history;
+    runner.escapesFailureMessages = YES;
+    uint64_t itemIndex = 0;
+    [[KWSuiteConfigurationBase defaultConfiguration] setUp];
+
+    while (KWSpecRunnerClaimWorkItem(queue, &itemIndex)) {
+        KWSpecRunnerWorkItem item = queue->items[itemIndex];
+        atomic_store_explicit(&state->itemIndex, (int64_t)itemIndex, memory_order_release);
+        [runner runExampleSuite:exampleSuites[item.suiteIndex] ofSpecClass:specClasses[item.suiteIndex] fromIndex:item.firstExampleIndex progress:&state->exampleIndex];
+        atomic_store_explicit(&state->exampleIndex, -1, memory_order_release);
+        atomic_store_explicit(&state->itemIndex, -1, memory_order_release);
+    }
+
+    [[KWSuiteConfigurationBase defaultConfiguration] tearDown];
+}
+
+- (pid_t)forkWorker:(NSUInteger)workerIndex queue:(KWSpecRunnerWorkQueue *)queue exampleSuites:(NSArray *)exampleSuites specClasses:(NSArray *)specClasses pipe:(int *)aReadEnd {
+    int fds[2];
+
+    if (pipe(fds) != 0)
+        [NSException raise:@"KWSpecRunnerException" format:@"could not create worker pipe: %s", strerror(errno)];
+
+    atomic_store_explicit(&queue->workers[workerIndex].itemIndex, -1, memory_order_release);
+    atomic_store_explicit(&queue->workers[workerIndex].exampleIndex, -1, memory_order_release);
+    fflush(NULL);
+    pid_t pid = fork();
+
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        [NSException raise:@"KWSpecRunnerException" format:@"could not fork worker: %s", strerror(errno)];
+    }
+
+    if (pid == 0) {
+        close(fds[0]);
+        @autoreleasepool {
+            [self runWorker:workerIndex queue:queue exampleSuites:exampleSuites specClasses:specClasses output:fds[1]];
+        }
+        // Skip atexit handlers and anything else inherited from the parent.
+        _exit(0);
+    }
+
+    close(fds[1]);
+    *aReadEnd = fds[0];
+    return pid;
+}
+
+- (void)forwardWorkerOutput:(NSMutableData *)buffer flush:(BOOL)flush failures:(NSMutableArray *)failures {
+    const char *bytes = buffer.bytes;
+    NSUInteger length = buffer.length;
+    NSUInteger lineStart = 0;
+
+    for (NSUInteger i = 0; i < length; ++i) {
+        BOOL endOfLine = bytes[i] == '\n';
+
+        if (!endOfLine && !(flush && i == length - 1))
+            continue;
+
+        NSUInteger lineEnd = endOfLine ? i : i + 1;
+        NSString *line = [[NSString alloc] initWithBytes:bytes + lineStart length:lineEnd - lineStart encoding:NSUTF8StringEncoding] ?: @"";
+        lineStart = i + 1;
+        [self writeLine:[self collectResultOfLine:line failures:failures]];
+    }
+
+    [buffer replaceBytesInRange:NSMakeRange(0, lineStart) withBytes:NULL length:0];
+}
+
+// Workers count, record and report results in their own address spaces, so
+// the parent takes them from the lines the workers write instead:
+//
+//   [<file>:<line>: ]-[<spec> <selector>]: error: <escaped message>
+//   PASS|FAIL -[<spec> <selector>] (<seconds> s)
+//
+// Returns the line as it is shown, with its failure message unescaped.
+- (NSString *)collectResultOfLine:(NSString *)aLine failures:(NSMutableArray *)failures {
+    NSRange error = [aLine rangeOfString:@": error: "];
+
+    if (error.location != NSNotFound) {
+        NSString *head = [aLine substringToIndex:error.location];
+        NSRange name = [head rangeOfString:@"-[" options:NSBackwardsSearch];
+        KWCallSite *callSite = nil;
+
+        if (name.location != NSNotFound && name.location >= 2) {
+            NSString *location = [head substringToIndex:name.location - 2];
+            NSRange colon = [location rangeOfString:@":" options:NSBackwardsSearch];
+
+            if (colon.location != NSNotFound)
+                callSite = [KWCallSite callSiteWithFilename:[location substringToIndex:colon.location] lineNumber:(NSUInteger)[[location substringFromIndex:NSMaxRange(colon)] integerValue]];
+        }
+
+        NSString *message = KWSpecRunnerUnescapedMessage([aLine substringFromIndex:NSMaxRange(error)]);
+        [failures addObject:@[callSite ?: [NSNull null], message]];
+        return [[aLine substringToIndex:NSMaxRange(error)] stringByAppendingString:message];
+    }
+
+    BOOL passed = [aLine hasPrefix:@"PASS -["];
+
+    if (!passed && ![aLine hasPrefix:@"FAIL -["])
+        return aLine;
+
+    NSRange space = [aLine rangeOfString:@" " options:0 range:NSMakeRange(7, [aLine length] - 7)];
+    NSRange end = [aLine rangeOfString:@"] (" options:0 range:NSMakeRange(7, [aLine length] - 7)];
+
+    if (space.location == NSNotFound || end.location == NSNotFound || space.location > end.location)
+        return aLine;
+
+    NSString *specName = [aLine substringWithRange:NSMakeRange(7, space.location - 7)];
+    NSString *selectorName = [aLine substringWithRange:NSMakeRange(NSMaxRange(space), end.location - NSMaxRange(space))];
+    NSTimeInterval duration = [[aLine substringFromIndex:NSMaxRange(end)] doubleValue];
+    self.exampleCount++;
+
+    if (!passed) {
+        self.failureCount++;
+        KWRecordFailedExample(specName, selectorName);
+    }
+
+    [self reportResultOfSpecName:specName selectorName:selectorName passed:passed duration:duration failures:failures];
+    [failures removeAllObjects];
+    return aLine;
+}
+
+- (void)reportResultOfSpecName:(NSString *)aSpecName selectorName:(NSString *)aSelectorName passed:(BOOL)passed duration:(NSTimeInterval)aDuration failures:(NSArray *)failures {
+    NSMutableArray *resultFailures = [NSMutableArray arrayWithCapacity:[failures count]];
+
+    for (NSArray *failure in failures) {
+        KWCallSite *callSite = failure[0] != [NSNull null] ? failure[0] : nil;
+        [resultFailures addObject:[KWFailure failureWithCallSite:callSite message:failure[1]]];
+    }
+
+    // The result keeps the call sites alive along with the failures.
+    KWExampleResult *result = [[KWExampleResult alloc] initWithSpecName:aSpecName
+                                                           selectorName:aSelectorName
+                                                            description:aSelectorName
+                                                                 status:passed ? KWExampleResultStatusPassed : KWExampleResultStatusFailed
+                                                               duration:aDuration
+                                                               failures:resultFailures];
+    [[KWResultReporter sharedReporter] reportResult:result];
+}
+
+- (void)reportCrashOfWorker:(NSUInteger)workerIndex status:(int)status queue:(KWSpecRunnerWorkQueue *)queue exampleSuites:(NSArray *)exampleSuites specClasses:(NSArray *)specClasses {
+    int64_t itemIndex = atomic_load_explicit(&queue->workers[workerIndex].itemIndex, memory_order_acquire);
+    int64_t exampleIndex = atomic_load_explicit(&queue->workers[workerIndex].exampleIndex, memory_order_acquire);
+    NSString *reason = WIFSIGNALED(status) ? [NSString stringWithFormat:@"worker crashed with signal %d", WTERMSIG(status)]
+                                           : [NSString stringWithFormat:@"worker exited with status %d", WEXITSTATUS(status)];
+
+    if (itemIndex < 0 || exampleIndex < 0) {
+        [self writeLine:[NSString stringWithFormat:@"error: %@ between examples", reason]];
+        self.failureCount++;
+        return;
+    }
+
+    KWSpecRunnerWorkItem item = queue->items[itemIndex];
+    KWExampleSuite *exampleSuite = exampleSuites[item.suiteIndex];
+    KWExample *example = exampleSuite.examples[(NSUInteger)exampleIndex];
+    self.currentExampleName = [NSString stringWithFormat:@"-[%@ %@]", NSStringFromClass(specClasses[item.suiteIndex]), example.selectorName];
+    self.currentExampleFailed = NO;
+    self.exampleCount++;
+    [self example:example didFailWithFailure:[KWFailure failureWithCallSite:nil message:reason]];
+    [self writeLine:[NSString stringWithFormat:@"FAIL %@", self.currentExampleName]];
+    [self.history recordExample:example.selectorName inSpecClass:specClasses[item.suiteIndex] duration:0.0 passed:NO];
+    [self reportResultOfSpecName:NSStringFromClass(specClasses[item.suiteIndex]) selectorName:example.selectorName passed:NO duration:0.0 failures:@[@[[NSNull null], reason]]];
+    KWRecordFailedExample(NSStringFromClass(specClasses[item.suiteIndex]), example.selectorName);
+
+    if ((NSUInteger)exampleIndex + 1 < [exampleSuite.examples count])
+        KWSpecRunnerAppendWorkItem(queue, (KWSpecRunnerWorkItem){ item.suiteIndex, (uint32_t)exampleIndex + 1 });
+}
+
+- (void)runExampleSuites:(NSArray *)exampleSuites ofSpecClasses:(NSArray *)specClasses workerCount:(NSUInteger)workerCount {
+    NSUInteger exampleCount = 0;
+
+    for (KWExampleSuite *exampleSuite in exampleSuites)
+        exampleCount += [exampleSuite.examples count];
+
+    // Every crash consumes an example, so requeued items never outnumber
+    // the examples.
+    NSUInteger itemCapacity = [exampleSuites count] + exampleCount;
+    size_t size = sizeof(KWSpecRunnerWorkQueue) + workerCount * sizeof(KWSpecRunnerWorkerState) + itemCapacity * sizeof(KWSpecRunnerWorkItem);
+    void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_ANON | MAP_SHARED, -1, 0);
+
+    if (memory == MAP_FAILED)
+        [NSException raise:@"KWSpecRunnerException" format:@"could not map work queue: %s", strerror(errno)];
+
+    KWSpecRunnerWorkQueue *queue = memory;
+    queue->workers = (KWSpecRunnerWorkerState *)(queue + 1);
+    queue->items = (KWSpecRunnerWorkItem *)(queue->workers + workerCount);
+    atomic_init(&queue->nextItem, 0);
+    atomic_init(&queue->itemCount, 0);
+
+    for (NSUInteger i = 0; i < [exampleSuites count]; ++i)
+        KWSpecRunnerAppendWorkItem(queue, (KWSpecRunnerWorkItem){ (uint32_t)i, 0 });
+
+    // Workers inherit the shared reporter, which drops what they report, and
+    // the parent reports the results it reads from their pipes. Were it set
+    // up in a worker instead, the worker would open and truncate the report
+    // files of the parent.
+    [KWResultReporter sharedReporter];
+
+    pid_t pids[workerCount];
+    struct pollfd fds[workerCount];
+    NSMutableArray *buffers = [NSMutableArray arrayWithCapacity:workerCount];
+    NSMutableArray *failures = [NSMutableArray arrayWithCapacity:workerCount];
+    NSUInteger runningCount = workerCount;
+
+    for (NSUInteger i = 0; i < workerCount; ++i) {
+        pids[i] = [self forkWorker:i queue:queue exampleSuites:exampleSuites specClasses:specClasses pipe:&fds[i].fd];
+        fds[i].events = POLLIN;
+        [buffers addObject:[NSMutableData data]];
+        [failures addObject:[NSMutableArray array]];
+    }
+
+    while (runningCount > 0) {
+        if (poll(fds, (nfds_t)workerCount, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            [NSException raise:@"KWSpecRunnerException" format:@"could not poll workers: %s", strerror(errno)];
+        }
+
+        for (NSUInteger i = 0; i < workerCount; ++i) {
+            if (fds[i].fd < 0 || fds[i].revents == 0)
+                continue;
+
+            char bytes[4096];
+            ssize_t length = read(fds[i].fd, bytes, sizeof(bytes));
+
+            if (length > 0) {
+                [buffers[i] appendBytes:bytes length:(NSUInteger)length];
+                [self forwardWorkerOutput:buffers[i] flush:NO failures:failures[i]];
+                continue;
+            }
+
+            if (length < 0 && errno == EINTR)
+                continue;
+
+            // The worker closed its end of the pipe, so it has exited or is
+            // about to.
+            [self forwardWorkerOutput:buffers[i] flush:YES failures:failures[i]];
+            [failures[i] removeAllObjects];
+            close(fds[i].fd);
+            fds[i].fd = -1;
+
+            int status = 0;
+            while (waitpid(pids[i], &status, 0) < 0 && errno == EINTR);
+
+            if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+                --runningCount;
+                continue;
+            }
+
+            [self reportCrashOfWorker:i status:status queue:queue exampleSuites:exampleSuites specClasses:specClasses];
+
+            if (atomic_load_explicit(&queue->nextItem, memory_order_acquire) < atomic_load_explicit(&queue->itemCount, memory_order_acquire))
+                pids[i] = [self forkWorker:i queue:queue exampleSuites:exampleSuites specClasses:specClasses pipe:&fds[i].fd];
+            else
+                --runningCount;
+        }
+    }
+
+    munmap(memory, size);
+}
+
+#pragma mark - Running Examples
+
+- (void)runExample:(KWExample *)example ofSpecClass:(Class)specClass {
+    self.currentExampleName = [NSString stringWithFormat:@"-[%@ %@]", NSStringFromClass(specClass), example.selectorName];
+    self.currentExampleFailed = NO;
+    self.currentSpecClass = specClass;
+    self.exampleCount++;
+
+    uint64_t startCounters[KWCounterCount];
+    KWCountersRead(startCounters);
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+
+    @try {
+        [example runWithDelegate:self];
+    } @catch (NSException *exception) {
+        [self example:example didFailWithFailure:[KWFailure failureWithCallSite:nil message:exception.description]];
+        KWRecordFailedExample(NSStringFromClass(specClass), example.selectorName);
+    }
+
+    CFAbsoluteTime duration = CFAbsoluteTimeGetCurrent() - start;
+    [self.history recordExample:example.selectorName inSpecClass:specClass duration:duration passed:!self.currentExampleFailed];
+    [self writeLine:[NSString stringWithFormat:@"%@ %@ (%.3f s)", self.currentExampleFailed ? @"FAIL" : @"PASS",
+                     self.currentExampleName, duration]];
+
+    if (KWCountersShouldLog()) {
+        uint64_t counters[KWCounterCount];
+        KWCountersRead(counters);
+        for (NSUInteger i = 0; i < KWCounterCount; ++i)
+            counters[i] -= startCounters[i];
+        [self writeLine:[NSString stringWithFormat:@"  counters: %@", KWCountersDescription(counters)]];
+    }
+}
+
+#pragma mark - KWExampleDelegate methods
+
+- (NSString *)specNameForExample:(KWExample *)example {
+    return NSStringFromClass(self.currentSpecClass);
+}
+
+- (void)example:(KWExample *)example didFailWithFailure:(KWFailure *)failure {
+    if (!self.currentExampleFailed) {
+        self.currentExampleFailed = YES;
+        self.failureCount++;
+    }
+
+    NSString *location = failure.callSite != nil ? [NSString stringWithFormat:@"%@:%lu: ", failure.callSite.filename, (unsigned long)failure.callSite.lineNumber] : @"";
+    NSString *message = self.escapesFailureMessages ? KWSpecRunnerEscapedMessage(failure.message) : failure.message;
+    [self writeLine:[NSString stringWithFormat:@"%@%@: error: %@", location, self.currentExampleName, message]];
+}
+
+@end
@@ -5,6 +5,7 @@
 //
 
 #import "KWValue.h"
+#import "KWCounters.h"
 #import "KWObjCUtilities.h"
 #import "NSNumber+KiwiAdditions.h"
 
@@ -25,6 +26,7 @@
     if (self) {
         objCType = anObjCType;
         value = [[NSValue alloc] initWithBytes:bytes objCType:anObjCType];
+        KWCounterIncrement(KWCounterValueBoxings);
     }
 
     return self;
@@ -30,21 +30,28 @@ extern "C" {
 #import <Kiwi/KWBlockNode.h>
 #import <Kiwi/KWCallSite.h>
 #import <Kiwi/KWCaptureSpy.h>
+#import <Kiwi/KWConsoleReporter.h>
 #import <Kiwi/KWContextNode.h>
+#import <Kiwi/KWCounters.h>
 #import <Kiwi/KWCountType.h>
 #import <Kiwi/KWDeviceInfo.h>
 #import <Kiwi/KWExample.h>
 #import <Kiwi/KWExampleDelegate.h>
 #import <Kiwi/KWExampleNode.h>
 #import <Kiwi/KWExampleNodeVisitor.h>
+#import <Kiwi/KWExampleResult.h>
 #import <Kiwi/KWExampleSuiteBuilder.h>
 #import <Kiwi/KWExistVerifier.h>
 #import <Kiwi/KWExpectationType.h>
 #import <Kiwi/KWFailure.h>
+#import <Kiwi/KWFileReporter.h>
 #import <Kiwi/KWFormatter.h>
 #import <Kiwi/KWFutureObject.h>
 #import <Kiwi/KWInvocationCapturer.h>
+#import <Kiwi/KWInvocationJournal.h>
 #import <Kiwi/KWItNode.h>
+#import <Kiwi/KWJSONLinesReporter.h>
+#import <Kiwi/KWJUnitReporter.h>
 #import <Kiwi/KWLet.h>
 #import <Kiwi/KWMessagePattern.h>
 #import <Kiwi/KWMessageSpying.h>
@@ -54,8 +61,11 @@ extern "C" {
 #import <Kiwi/KWPendingNode.h>
 #import <Kiwi/KWProbe.h>
 #import <Kiwi/KWReporting.h>
+#import <Kiwi/KWResultReporter.h>
+#import <Kiwi/KWResultReporting.h>
 #import <Kiwi/KWSharedExample.h>
 #import <Kiwi/KWSpec.h>
+#import <Kiwi/KWSpecRunner.h>
 #import <Kiwi/KWStringUtilities.h>
 #import <Kiwi/KWStub.h>
 #import <Kiwi/KWSuiteConfigurationBase.h>
@@ -91,6 +101,7 @@ extern "C" {
 #import <Kiwi/KWMatching.h>
 #import <Kiwi/KWNilMatcher.h>
 #import <Kiwi/KWNotificationMatcher.h>
+#import <Kiwi/KWPassMatcher.h>
 #import <Kiwi/KWReceiveMatcher.h>
 #import <Kiwi/KWRegisterMatchersNode.h>
 #import <Kiwi/KWRegularExpressionPatternMatcher.h>
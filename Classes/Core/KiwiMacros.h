@@ -28,7 +28,21 @@
 
 #pragma mark - Support Macros
 
-#define KW_THIS_CALLSITE [KWCallSite callSiteWithFilename:@__FILE__ lineNumber:__LINE__]
+// Every expansion keeps its call site in a static variable of its own, so an
+// expectation allocates nothing for its call site after the first run.
+#if defined(__GNUC__)
+    #define KW_THIS_CALLSITE \
+        ({ \
+            static KWCallSite *kiwiReservedPrefix_callSite = nil; \
+            static dispatch_once_t kiwiReservedPrefix_callSiteOnce; \
+            dispatch_once(&kiwiReservedPrefix_callSiteOnce, ^{ \
+                kiwiReservedPrefix_callSite = KWInternedCallSite(__FILE__, __LINE__); \
+            }); \
+            kiwiReservedPrefix_callSite; \
+        })
+#else
+    #define KW_THIS_CALLSITE [KWCallSite callSiteWithFilename:@__FILE__ lineNumber:__LINE__]
+#endif // #if defined(__GNUC__)
 #define KW_ADD_EXIST_VERIFIER(expectationType) [KWSpec addExistVerifierWithExpectationType:expectationType callSite:KW_THIS_CALLSITE]
 #define KW_ADD_MATCH_VERIFIER(expectationType) [KWSpec addMatchVerifierWithExpectationType:expectationType callSite:KW_THIS_CALLSITE]
 #define KW_ADD_ASYNC_VERIFIER(expectationType, timeOut, wait) [KWSpec addAsyncVerifierWithExpectationType:expectationType callSite:KW_THIS_CALLSITE timeout:timeOut shouldWait:wait]
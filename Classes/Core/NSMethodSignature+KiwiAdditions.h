@@ -8,9 +8,22 @@
 
 @interface NSMethodSignature(KiwiAdditions)
 
+#pragma mark - Creating Method Signatures
+
+// Returns the signature the compiler recorded for a block, where argument 0
+// is the block itself. Returns nil for blocks compiled without a signature.
++ (NSMethodSignature *)signatureWithBlock:(id)aBlock;
+
 #pragma mark - Getting Information on Message Arguments
 
 - (NSUInteger)numberOfMessageArguments;
 - (const char *)messageArgumentTypeAtIndex:(NSUInteger)anIndex;
 
+#pragma mark - Comparing Signatures
+
+// A block is compatible with a method when it returns the same type and takes
+// the receiver followed by the method's message arguments, i.e. when it could
+// be passed to imp_implementationWithBlock() for that method.
+- (BOOL)isCompatibleWithBlockSignature:(NSMethodSignature *)aBlockSignature;
+
 @end
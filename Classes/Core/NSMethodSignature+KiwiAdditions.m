@@ -5,9 +5,73 @@
 //
 
 #import "NSMethodSignature+KiwiAdditions.h"
+#import "KWObjCUtilities.h"
+
+// Block layout as described by the Clang block ABI.
+typedef NS_OPTIONS(int, KWBlockFlags) {
+    KWBlockFlagsHasCopyDisposeHelpers = (1 << 25),
+    KWBlockFlagsHasSignature          = (1 << 30)
+};
+
+struct KWBlockLiteral {
+    void *isa;
+    KWBlockFlags flags;
+    int reserved;
+    void (*invoke)(void *, ...);
+    struct {
+        unsigned long int reserved;
+        unsigned long int size;
+        // Followed by copy/dispose helpers when KWBlockFlagsHasCopyDisposeHelpers
+        // is set, and by the signature when KWBlockFlagsHasSignature is set.
+    } *descriptor;
+};
+
+static const char *KWBlockSignatureTypes(id aBlock) {
+    struct KWBlockLiteral *block = (__bridge struct KWBlockLiteral *)aBlock;
+
+    if ((block->flags & KWBlockFlagsHasSignature) == 0)
+        return NULL;
+
+    void *descriptor = block->descriptor;
+    descriptor = (char *)descriptor + 2 * sizeof(unsigned long int);
+
+    if (block->flags & KWBlockFlagsHasCopyDisposeHelpers)
+        descriptor = (char *)descriptor + 2 * sizeof(void *);
+
+    return *(const char **)descriptor;
+}
+
+static const char *KWObjCTypeSkippingQualifiers(const char *objCType) {
+    while (*objCType != '\0' && strchr("rnNoORV", *objCType) != NULL)
+        ++objCType;
+
+    return objCType;
+}
+
+static BOOL KWObjCTypeCompatibleWithObjCType(const char *firstObjCType, const char *secondObjCType) {
+    firstObjCType = KWObjCTypeSkippingQualifiers(firstObjCType);
+    secondObjCType = KWObjCTypeSkippingQualifiers(secondObjCType);
+
+    // Block signatures carry class names (@"NSString"); any two object types
+    // are passed the same way.
+    if (*firstObjCType == '@' && *secondObjCType == '@')
+        return YES;
+
+    if (KWObjCTypeEqualToObjCType(firstObjCType, secondObjCType))
+        return YES;
+
+    return *firstObjCType == *secondObjCType && KWObjCTypeLength(firstObjCType) == KWObjCTypeLength(secondObjCType);
+}
 
 @implementation NSMethodSignature(KiwiAdditions)
 
+#pragma mark - Creating Method Signatures
+
++ (NSMethodSignature *)signatureWithBlock:(id)aBlock {
+    const char *types = aBlock != nil ? KWBlockSignatureTypes(aBlock) : NULL;
+    return types != NULL ? [NSMethodSignature signatureWithObjCTypes:types] : nil;
+}
+
 #pragma mark - Getting Information on Message Arguments
 
 - (NSUInteger)numberOfMessageArguments {
@@ -18,4 +82,25 @@
     return [self getArgumentTypeAtIndex:anIndex + 2];
 }
 
+#pragma mark - Comparing Signatures
+
+- (BOOL)isCompatibleWithBlockSignature:(NSMethodSignature *)aBlockSignature {
+    if ([aBlockSignature numberOfArguments] != [self numberOfArguments])
+        return NO;
+
+    if (!KWObjCTypeCompatibleWithObjCType([self methodReturnType], [aBlockSignature methodReturnType]))
+        return NO;
+
+    // Argument 1 is the selector for methods but the receiver for blocks.
+    if (*KWObjCTypeSkippingQualifiers([aBlockSignature getArgumentTypeAtIndex:1]) != '@')
+        return NO;
+
+    for (NSUInteger i = 2; i < [self numberOfArguments]; ++i) {
+        if (!KWObjCTypeCompatibleWithObjCType([self getArgumentTypeAtIndex:i], [aBlockSignature getArgumentTypeAtIndex:i]))
+            return NO;
+    }
+
+    return YES;
+}
+
 @end
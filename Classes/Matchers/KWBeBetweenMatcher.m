@@ -24,6 +24,12 @@
     return @[@"beBetween:and:", @"beInTheIntervalFrom:to:"];
 }
 
+#pragma mark - Getting Matcher Compatability
+
++ (BOOL)isReusableForSubjects {
+    return YES;
+}
+
 #pragma mark - Matching
 
 - (BOOL)evaluate {
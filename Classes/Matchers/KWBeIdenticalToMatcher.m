@@ -23,6 +23,12 @@
     return @[@"beIdenticalTo:"];
 }
 
+#pragma mark - Getting Matcher Compatability
+
++ (BOOL)isSideEffectFree {
+    return YES;
+}
+
 #pragma mark - Matching
 
 - (BOOL)evaluate {
@@ -21,6 +21,12 @@
     return @[@"beKindOfClass:"];
 }
 
+#pragma mark - Getting Matcher Compatability
+
++ (BOOL)isSideEffectFree {
+    return YES;
+}
+
 #pragma mark - Matching
 
 - (BOOL)evaluate {
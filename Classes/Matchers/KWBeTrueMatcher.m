@@ -20,6 +20,12 @@
     return @[@"beTrue", @"beFalse", @"beYes", @"beNo"];
 }
 
+#pragma mark - Getting Matcher Compatability
+
++ (BOOL)isSideEffectFree {
+    return YES;
+}
+
 #pragma mark - Matching
 
 - (BOOL)evaluate {
@@ -24,6 +24,12 @@
     return @[@"beWithin:of:", @"equal:withDelta:"];
 }
 
+#pragma mark - Getting Matcher Compatability
+
++ (BOOL)isSideEffectFree {
+    return YES;
+}
+
 #pragma mark - Matching
 
 // Evaluation is done by getting the underlying values as the widest data
@@ -28,6 +28,12 @@
              @"endWithString:"];
 }
 
+#pragma mark - Getting Matcher Compatability
+
++ (BOOL)isReusableForSubjects {
+    return YES;
+}
+
 #pragma mark - Matching
 
 - (BOOL)evaluate {
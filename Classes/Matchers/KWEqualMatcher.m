@@ -31,6 +31,12 @@
     return @[@"equal:"];
 }
 
+#pragma mark - Getting Matcher Compatability
+
++ (BOOL)isReusableForSubjects {
+    return YES;
+}
+
 #pragma mark - Matching
 
 - (BOOL)evaluate {
@@ -34,6 +34,12 @@ typedef NS_ENUM(NSUInteger, KWInequalityType) {
                                      @"beGreaterThanOrEqualTo:"];
 }
 
+#pragma mark - Getting Matcher Compatability
+
++ (BOOL)isReusableForSubjects {
+    return YES;
+}
+
 #pragma mark - Matching
 
 - (BOOL)evaluate {
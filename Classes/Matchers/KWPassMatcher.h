@@ -0,0 +1,43 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KiwiConfiguration.h"
+#import "KWMatcher.h"
+#import "KWMatchVerifier.h"
+
+@class KWMatcherFactory;
+
+// The number of failing elements a failure message describes.
+extern const NSUInteger KWPassMatcherFailureLimit;
+
+// Applies the matcher message of an expectation to every element of a
+// collection, with one verifier for the whole collection:
+//
+//   [[[names should] allPass] matchPattern:@"^[A-Z]"];
+//   [[[readings should] anyPass] beWithin:theValue(0.1) of:theValue(1.0)];
+//
+// Elements of matchers that declare themselves reusable are all evaluated
+// by one configured matcher. Large collections are only split across cores
+// for matchers that declare themselves side-effect free, which call no code
+// of the elements. anyPass stops at the first element that passes.
+@interface KWPassMatcher : KWMatcher
+
+#pragma mark - Configuring Matchers
+
+// These methods will become private
+- (void)allPass:(NSInvocation *)anInvocation matcherFactory:(KWMatcherFactory *)aMatcherFactory;
+- (void)anyPass:(NSInvocation *)anInvocation matcherFactory:(KWMatcherFactory *)aMatcherFactory;
+
+@end
+
+@interface KWMatchVerifier(KWPassMatcherAdditions)
+
+#pragma mark Invocation Capturing Methods
+
+- (id)allPass;
+- (id)anyPass;
+
+@end
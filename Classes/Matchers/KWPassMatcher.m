@@ -0,0 +1,360 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KWPassMatcher.h"
+#import "KWInvocationCapturer.h"
+#import "KWMatcherFactory.h"
+#import "KWMatcherResolution.h"
+#import "KWStringUtilities.h"
+#import "KWWorkarounds.h"
+#import <stdatomic.h>
+
+const NSUInteger KWPassMatcherFailureLimit = 10;
+
+// Collections smaller than this are evaluated on the calling thread, as
+// handing them to other threads costs more than it saves.
+static const NSUInteger KWPassMatcherMinimumConcurrentCount = 256;
+static const NSUInteger KWPassMatcherMinimumChunkLength = 64;
+
+static NSString * const MatchVerifierKey = @"MatchVerifierKey";
+static NSString * const PassTypeKey = @"PassTypeKey";
+
+typedef NS_ENUM(NSUInteger, KWPassType) {
+    KWPassTypeAll,
+    KWPassTypeAny
+};
+
+@interface KWPassMatcher()
+
+@property (nonatomic, assign) KWPassType passType;
+@property (nonatomic, strong) NSInvocation *elementInvocation;
+@property (nonatomic, strong) KWMatcherFactory *matcherFactory;
+@property (nonatomic, strong) NSArray *elements;
+@property (nonatomic, strong) NSMutableData *passes;
+@property (nonatomic, assign) NSUInteger passCount;
+
+@end
+
+@implementation KWPassMatcher
+
+#pragma mark - Getting Matcher Strings
+
++ (NSArray *)matcherStrings {
+    return @[@"allPass:matcherFactory:", @"anyPass:matcherFactory:"];
+}
+
+#pragma mark - Getting Matcher Compatability
+
++ (BOOL)canMatchSubject:(id)anObject {
+    return [anObject conformsToProtocol:@protocol(NSFastEnumeration)];
+}
+
+#pragma mark - Building Element Matchers
+
+- (NSArray *)elementsOfSubject {
+    id subject = self.subject;
+
+    if ([subject isKindOfClass:[NSArray class]])
+        return subject;
+
+    if ([subject isKindOfClass:[NSOrderedSet class]])
+        return [subject array];
+
+    NSMutableArray *elements = [NSMutableArray array];
+
+    for (id element in subject)
+        [elements addObject:element];
+
+    return elements;
+}
+
+- (id<KWMatching>)configuredMatcherForElement:(id)anElement {
+    id<KWMatching> matcher = (id<KWMatching>)[self.matcherFactory matcherFromInvocation:self.elementInvocation subject:anElement];
+
+    if (matcher == nil) {
+        [NSException raise:@"KWMatcherException" format:@"could not create matcher for -%@",
+                                                         NSStringFromSelector(self.elementInvocation.selector)];
+    }
+
+    [self.elementInvocation invokeWithTarget:matcher];
+
+#if KW_TARGET_HAS_INVOCATION_EXCEPTION_BUG
+    NSException *exception = KWGetAndClearExceptionFromAcrossInvocationBoundary();
+    [exception raise];
+#endif // #if KW_TARGET_HAS_INVOCATION_EXCEPTION_BUG
+
+    if ([matcher respondsToSelector:@selector(shouldBeEvaluatedAtEndOfExample)] && [matcher shouldBeEvaluatedAtEndOfExample]) {
+        [NSException raise:@"KWMatcherException" format:@"-%@ is evaluated at the end of the example and cannot be applied to elements",
+                                                         NSStringFromSelector(self.elementInvocation.selector)];
+    }
+
+    return matcher;
+}
+
+#pragma mark - Matching
+
+- (BOOL)elementPasses:(id)anElement {
+    @try {
+        return [[self configuredMatcherForElement:anElement] evaluate];
+    } @catch (NSException *exception) {
+        return NO;
+    }
+}
+
+// Reusable matchers are configured once per chunk of elements, and then
+// only have their subject replaced. Chunks are only evaluated on other
+// threads when concurrently is YES. Elements that would get a matcher of
+// another class are left for -elementPasses:.
+- (void)evaluateElements:(NSArray *)elements withResolution:(KWMatcherResolution *)aResolution concurrently:(BOOL)concurrently passes:(BOOL *)passes {
+    NSUInteger count = [elements count];
+    NSUInteger chunkCount = 1;
+
+    if (concurrently && count >= KWPassMatcherMinimumConcurrentCount)
+        chunkCount = MIN([[NSProcessInfo processInfo] activeProcessorCount] * 4, count / KWPassMatcherMinimumChunkLength);
+
+    NSUInteger chunkLength = (count + chunkCount - 1) / chunkCount;
+    NSMutableArray *matchers = [NSMutableArray arrayWithCapacity:chunkCount];
+
+    // Invoking the captured invocation changes its target, so every matcher
+    // is configured before evaluation starts.
+    for (NSUInteger i = 0; i < chunkCount; ++i)
+        [matchers addObject:[self configuredMatcherForElement:elements[0]]];
+
+    BOOL *deferred = calloc(count, sizeof(BOOL));
+    SEL selector = self.elementInvocation.selector;
+    KWMatcherFactory *matcherFactory = self.matcherFactory;
+    BOOL stopsAtFirstPass = self.passType == KWPassTypeAny;
+    atomic_bool passed = false;
+    atomic_bool *passedPointer = &passed;
+
+    void (^evaluateChunk)(size_t) = ^(size_t chunk) {
+        KWMatcher *matcher = matchers[chunk];
+        NSUInteger end = MIN((chunk + 1) * chunkLength, count);
+
+        for (NSUInteger i = chunk * chunkLength; i < end; ++i) {
+            if (stopsAtFirstPass && atomic_load_explicit(passedPointer, memory_order_relaxed))
+                return;
+
+            id element = elements[i];
+
+            @try {
+                if ([aResolution isResolutionOfSelector:selector subject:element matcherFactory:matcherFactory] ||
+                    [matcherFactory matcherClassForSelector:selector subject:element] == aResolution.matcherClass) {
+                    matcher.subject = element;
+                    passes[i] = [matcher evaluate];
+
+                    if (passes[i])
+                        atomic_store_explicit(passedPointer, true, memory_order_relaxed);
+                } else {
+                    deferred[i] = YES;
+                }
+            } @catch (NSException *exception) {
+                passes[i] = NO;
+            }
+        }
+    };
+
+    if (chunkCount == 1)
+        evaluateChunk(0);
+    else
+        dispatch_apply(chunkCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), evaluateChunk);
+
+    for (NSUInteger i = 0; i < count; ++i) {
+        if (stopsAtFirstPass && atomic_load_explicit(&passed, memory_order_relaxed))
+            break;
+
+        if (!deferred[i])
+            continue;
+
+        passes[i] = [self elementPasses:elements[i]];
+
+        if (passes[i])
+            atomic_store_explicit(&passed, true, memory_order_relaxed);
+    }
+
+    free(deferred);
+}
+
+- (BOOL)evaluate {
+    NSArray *elements = [self elementsOfSubject];
+    NSUInteger count = [elements count];
+    NSMutableData *passData = [NSMutableData dataWithLength:count * sizeof(BOOL)];
+    BOOL *passes = [passData mutableBytes];
+    KWMatcherResolution *resolution = nil;
+
+    if (count > 0)
+        resolution = [KWMatcherResolution resolutionWithSelector:self.elementInvocation.selector subject:elements[0] matcherFactory:self.matcherFactory];
+
+    Class matcherClass = resolution.matcherClass;
+    BOOL sideEffectFree = [matcherClass respondsToSelector:@selector(isSideEffectFree)] && [matcherClass isSideEffectFree];
+    BOOL reusable = resolution.cacheable &&
+                    (sideEffectFree || ([matcherClass respondsToSelector:@selector(isReusableForSubjects)] && [matcherClass isReusableForSubjects])) &&
+                    [matcherClass instancesRespondToSelector:@selector(setSubject:)];
+
+    if (reusable) {
+        [self evaluateElements:elements withResolution:resolution concurrently:sideEffectFree passes:passes];
+    } else {
+        for (NSUInteger i = 0; i < count; ++i) {
+            passes[i] = [self elementPasses:elements[i]];
+
+            if (passes[i] && self.passType == KWPassTypeAny)
+                break;
+        }
+    }
+
+    NSUInteger passCount = 0;
+
+    for (NSUInteger i = 0; i < count; ++i) {
+        if (passes[i])
+            ++passCount;
+    }
+
+    self.elements = elements;
+    self.passes = passData;
+    self.passCount = passCount;
+
+    if (self.passType == KWPassTypeAll)
+        return passCount == count;
+    else
+        return passCount > 0;
+}
+
+#pragma mark - Getting Failure Messages
+
+- (NSString *)elementDescription {
+    @try {
+        return [[self configuredMatcherForElement:[self.elements firstObject]] description];
+    } @catch (NSException *exception) {
+        return NSStringFromSelector(self.elementInvocation.selector);
+    }
+}
+
+- (NSString *)messageForElement:(id)anElement passed:(BOOL)passed {
+    @try {
+        id<KWMatching> matcher = [self configuredMatcherForElement:anElement];
+        [matcher evaluate];
+        return passed ? [matcher failureMessageForShouldNot] : [matcher failureMessageForShould];
+    } @catch (NSException *exception) {
+        return [exception description];
+    }
+}
+
+// Describes up to KWPassMatcherFailureLimit of the elements that passed, or
+// of those that did not.
+- (NSString *)elementsPhraseForElementsThatPassed:(BOOL)passed {
+    const BOOL *passes = [self.passes bytes];
+    NSUInteger count = [self.elements count];
+    NSUInteger matchingCount = passed ? self.passCount : count - self.passCount;
+    NSUInteger describedCount = 0;
+    NSMutableString *phrase = [NSMutableString string];
+
+    for (NSUInteger i = 0; i < count && describedCount < KWPassMatcherFailureLimit; ++i) {
+        if (passes[i] != passed)
+            continue;
+
+        [phrase appendFormat:@"\n  [%lu] %@", (unsigned long)i, [self messageForElement:self.elements[i] passed:passed]];
+        ++describedCount;
+    }
+
+    if (matchingCount > describedCount)
+        [phrase appendFormat:@"\n  ... and %lu more", (unsigned long)(matchingCount - describedCount)];
+
+    return phrase;
+}
+
+- (NSString *)failureMessageForShould {
+    NSUInteger count = [self.elements count];
+
+    if (self.passType == KWPassTypeAll) {
+        return [NSString stringWithFormat:@"expected all %lu elements to %@, but %lu did not:%@",
+                                          (unsigned long)count,
+                                          [self elementDescription],
+                                          (unsigned long)(count - self.passCount),
+                                          [self elementsPhraseForElementsThatPassed:NO]];
+    }
+
+    return [NSString stringWithFormat:@"expected any of %lu elements to %@, but none did:%@",
+                                      (unsigned long)count,
+                                      [self elementDescription],
+                                      [self elementsPhraseForElementsThatPassed:NO]];
+}
+
+- (NSString *)failureMessageForShouldNot {
+    if (self.passType == KWPassTypeAll) {
+        return [NSString stringWithFormat:@"expected not all %lu elements to %@",
+                                          (unsigned long)[self.elements count],
+                                          [self elementDescription]];
+    }
+
+    // anyPass stops at the first element that passes, so there may be more.
+    return [NSString stringWithFormat:@"expected no elements to %@, but at least %lu did:%@",
+                                      [self elementDescription],
+                                      (unsigned long)self.passCount,
+                                      [self elementsPhraseForElementsThatPassed:YES]];
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"have %@ %@", self.passType == KWPassTypeAll ? @"all elements" : @"any element", [self elementDescription]];
+}
+
+#pragma mark - Configuring Matchers
+
+- (void)allPass:(NSInvocation *)anInvocation matcherFactory:(KWMatcherFactory *)aMatcherFactory {
+    self.passType = KWPassTypeAll;
+    self.elementInvocation = anInvocation;
+    self.matcherFactory = aMatcherFactory;
+}
+
+- (void)anyPass:(NSInvocation *)anInvocation matcherFactory:(KWMatcherFactory *)aMatcherFactory {
+    self.passType = KWPassTypeAny;
+    self.elementInvocation = anInvocation;
+    self.matcherFactory = aMatcherFactory;
+}
+
+#pragma mark - Capturing Invocations
+
++ (NSMethodSignature *)invocationCapturer:(KWInvocationCapturer *)anInvocationCapturer methodSignatureForSelector:(SEL)aSelector {
+    KWMatchVerifier *verifier = (anInvocationCapturer.userInfo)[MatchVerifierKey];
+    NSMethodSignature *signature = [verifier.matcherFactory methodSignatureForMatcherSelector:aSelector];
+
+    if (signature != nil)
+        return signature;
+
+    NSString *encoding = KWEncodingForDefaultMethod();
+    return [NSMethodSignature signatureWithObjCTypes:[encoding UTF8String]];
+}
+
++ (void)invocationCapturer:(KWInvocationCapturer *)anInvocationCapturer didCaptureInvocation:(NSInvocation *)anInvocation {
+    NSDictionary *userInfo = anInvocationCapturer.userInfo;
+    id verifier = userInfo[MatchVerifierKey];
+    KWPassType passType = [userInfo[PassTypeKey] unsignedIntegerValue];
+
+    // Elements are matched after the capturer has gone.
+    [anInvocation retainArguments];
+
+    if (passType == KWPassTypeAll)
+        [verifier allPass:anInvocation matcherFactory:[verifier matcherFactory]];
+    else
+        [verifier anyPass:anInvocation matcherFactory:[verifier matcherFactory]];
+}
+
+@end
+
+@implementation KWMatchVerifier(KWPassMatcherAdditions)
+
+#pragma mark Invocation Capturing Methods
+
+- (id)allPass {
+    NSDictionary *userInfo = @{ MatchVerifierKey: self, PassTypeKey: @(KWPassTypeAll) };
+    return [KWInvocationCapturer invocationCapturerWithDelegate:[KWPassMatcher class] userInfo:userInfo];
+}
+
+- (id)anyPass {
+    NSDictionary *userInfo = @{ MatchVerifierKey: self, PassTypeKey: @(KWPassTypeAny) };
+    return [KWInvocationCapturer invocationCapturerWithDelegate:[KWPassMatcher class] userInfo:userInfo];
+}
+
+@end
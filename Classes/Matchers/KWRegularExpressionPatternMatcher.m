@@ -27,6 +27,12 @@
     return @[@"matchPattern:", @"matchPattern:options:"];
 }
 
+#pragma mark - Getting Matcher Compatability
+
++ (BOOL)isReusableForSubjects {
+    return YES;
+}
+
 #pragma mark - Matching
 
 - (BOOL)evaluate {
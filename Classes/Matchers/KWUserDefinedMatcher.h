@@ -14,6 +14,12 @@
 typedef BOOL (^KWUserDefinedMatcherBlock)();
 #pragma clang diagnostic pop
 
+typedef NSString * (^KWUserDefinedMatcherMessageBlock)(id);
+
+@class KWUserDefinedMatcherDescriptor;
+
+// A matcher block takes the subject followed by the arguments of the matcher
+// message, of any type, e.g. ^BOOL(id subject, double value, id other).
 @interface KWUserDefinedMatcher : KWMatcher
 
 @property (nonatomic, assign) SEL selector;
@@ -24,11 +30,39 @@ typedef BOOL (^KWUserDefinedMatcherBlock)();
 
 + (id)matcherWithSubject:(id)aSubject block:(KWUserDefinedMatcherBlock)aBlock;
 - (id)initWithSubject:(id)aSubject block:(KWUserDefinedMatcherBlock)aBlock;
+- (id)initWithSubject:(id)aSubject descriptor:(KWUserDefinedMatcherDescriptor *)aDescriptor;
 @end
 
 #pragma mark -
 
-typedef NSString * (^KWUserDefinedMatcherMessageBlock)(id);
+// A compiled user-defined matcher definition. Descriptors never change once
+// created, so any number of matchers, on any thread, can be built from one.
+@interface KWUserDefinedMatcherDescriptor : NSObject
+
+- (id)initWithSelector:(SEL)aSelector
+          matcherBlock:(KWUserDefinedMatcherBlock)aMatcherBlock
+failureMessageForShouldBlock:(KWUserDefinedMatcherMessageBlock)aShouldBlock
+failureMessageForShouldNotBlock:(KWUserDefinedMatcherMessageBlock)aShouldNotBlock
+           description:(NSString *)aDescription;
+
+@property (nonatomic, readonly) SEL selector;
+@property (nonatomic, readonly) KWUserDefinedMatcherBlock matcherBlock;
+@property (nonatomic, readonly) KWUserDefinedMatcherMessageBlock failureMessageForShouldBlock;
+@property (nonatomic, readonly) KWUserDefinedMatcherMessageBlock failureMessageForShouldNotBlock;
+@property (nonatomic, readonly) NSString *matcherDescription;
+
+// The signature of the matcher message, with argument types taken from the
+// matcher block. Arguments the block does not take are objects.
+@property (nonatomic, readonly) NSMethodSignature *methodSignature;
+
+// Nil for blocks compiled without a signature.
+@property (nonatomic, readonly) NSMethodSignature *blockSignature;
+
+- (KWUserDefinedMatcher *)matcherWithSubject:(id)aSubject;
+
+@end
+
+#pragma mark -
 
 @interface KWUserDefinedMatcherBuilder : NSObject
 
@@ -47,5 +81,10 @@ typedef NSString * (^KWUserDefinedMatcherMessageBlock)(id);
 
 #pragma mark - Buiding The Matcher
 
+// Compiles the definition as configured so far. Changes made to the builder
+// afterwards do not affect the descriptor.
+- (KWUserDefinedMatcherDescriptor *)descriptor;
+
+// Returns a new matcher on every call.
 - (KWUserDefinedMatcher *)buildMatcherWithSubject:(id)subject;
 @end
@@ -7,9 +7,85 @@
 //
 
 #import "KWUserDefinedMatcher.h"
+#import "KWObjCUtilities.h"
+#import "NSMethodSignature+KiwiAdditions.h"
+
+static NSString * const KWUserDefinedMatcherDefaultDescription = @"match user defined matcher";
+
+#pragma mark - Compiling Matcher Signatures
+
+static NSMethodSignature *KWUserDefinedMatcherMethodSignature(SEL aSelector, NSMethodSignature *aBlockSignature) {
+    NSUInteger parameterCount = KWSelectorParameterCount(aSelector);
+    NSMutableString *types = [NSMutableString stringWithFormat:@"%s%s%s", @encode(void), @encode(id), @encode(SEL)];
+
+    // Argument 0 of the block is the block itself, and argument 1 the
+    // subject, so message argument i is block argument i + 2.
+    for (NSUInteger i = 0; i < parameterCount; ++i) {
+        const char *type = i + 2 < [aBlockSignature numberOfArguments] ? [aBlockSignature getArgumentTypeAtIndex:i + 2] : @encode(id);
+        [types appendFormat:@"%s", type];
+    }
+
+    return [NSMethodSignature signatureWithObjCTypes:[types UTF8String]];
+}
+
+#pragma mark - Evaluating Matcher Blocks
+
+static BOOL KWUserDefinedMatcherEvaluateBlock(KWUserDefinedMatcherBlock aBlock, NSMethodSignature *aBlockSignature, id aSubject, NSInvocation *anInvocation) {
+    if (aBlockSignature == nil) {
+        // Without a signature only object arguments can be passed on, and
+        // only as many as there used to be dummy methods for.
+        if (anInvocation.methodSignature.numberOfArguments == 3) {
+            __unsafe_unretained id argument = nil;
+            [anInvocation getArgument:&argument atIndex:2];
+            return aBlock(aSubject, argument);
+        }
+
+        return aBlock(aSubject);
+    }
+
+    NSInvocation *blockInvocation = [NSInvocation invocationWithMethodSignature:aBlockSignature];
+    NSUInteger numberOfArguments = [aBlockSignature numberOfArguments];
+    NSUInteger numberOfMessageArguments = anInvocation != nil ? [anInvocation.methodSignature numberOfArguments] : 0;
+    NSUInteger bufferLength = MAX([aBlockSignature frameLength], [aBlockSignature methodReturnLength]);
+    char stackBuffer[256] __attribute__((aligned(16)));
+    void *buffer = bufferLength <= sizeof(stackBuffer) ? stackBuffer : calloc(1, bufferLength);
+
+    if (numberOfArguments > 1) {
+        __unsafe_unretained id subject = aSubject;
+        [blockInvocation setArgument:&subject atIndex:1];
+    }
+
+    // The message was compiled with the argument types of the block, so the
+    // bytes can be copied across as they are.
+    for (NSUInteger i = 2; i < numberOfArguments && i < numberOfMessageArguments; ++i) {
+        [anInvocation getArgument:buffer atIndex:i];
+        [blockInvocation setArgument:buffer atIndex:i];
+    }
+
+    BOOL result = NO;
+
+    @try {
+        [blockInvocation invokeWithTarget:aBlock];
+        NSUInteger returnLength = [aBlockSignature methodReturnLength];
+
+        if (returnLength > 0) {
+            memset(buffer, 0, returnLength);
+            [blockInvocation getReturnValue:buffer];
+
+            for (NSUInteger i = 0; i < returnLength && !result; ++i)
+                result = ((const char *)buffer)[i] != 0;
+        }
+    } @finally {
+        if (buffer != stackBuffer)
+            free(buffer);
+    }
+
+    return result;
+}
 
 @interface KWUserDefinedMatcher(){}
-@property (nonatomic, copy) NSInvocation *invocation;
+@property (nonatomic, strong) NSInvocation *invocation;
+@property (nonatomic, strong) KWUserDefinedMatcherDescriptor *descriptor;
 @end
 
 @implementation KWUserDefinedMatcher
@@ -28,23 +104,55 @@
     self = [super initWithSubject:aSubject];
     if (self) {
         matcherBlock = [aBlock copy];
-        self.description = @"match user defined matcher";
+        self.description = KWUserDefinedMatcherDefaultDescription;
     }
     return self;
 }
 
+- (id)initWithSubject:(id)aSubject descriptor:(KWUserDefinedMatcherDescriptor *)aDescriptor {
+    self = [super initWithSubject:aSubject];
+    if (self) {
+        _descriptor = aDescriptor;
+        selector = aDescriptor.selector;
+        matcherBlock = aDescriptor.matcherBlock;
+        description = aDescriptor.matcherDescription;
+    }
+    return self;
+}
+
+#pragma mark - Getting Failure Messages
+
+// Messages of matchers built from a descriptor are only made when asked for.
+- (NSString *)failureMessageForShould {
+    if (failureMessageForShould == nil && self.descriptor.failureMessageForShouldBlock != nil)
+        return self.descriptor.failureMessageForShouldBlock(self.subject);
+
+    return failureMessageForShould;
+}
+
+- (NSString *)failureMessageForShouldNot {
+    if (failureMessageForShouldNot == nil && self.descriptor.failureMessageForShouldNotBlock != nil)
+        return self.descriptor.failureMessageForShouldNotBlock(self.subject);
+
+    return failureMessageForShouldNot;
+}
+
+#pragma mark - Matching
+
+- (NSMethodSignature *)blockSignature {
+    if (self.descriptor != nil && self.descriptor.matcherBlock == self.matcherBlock)
+        return self.descriptor.blockSignature;
+
+    return [NSMethodSignature signatureWithBlock:self.matcherBlock];
+}
 
 - (BOOL)evaluate {
-    BOOL result;
-
-    if (self.invocation.methodSignature.numberOfArguments == 3) {
-        id argument;
-        [self.invocation getArgument:&argument atIndex:2];
-        result = matcherBlock(self.subject, argument);
-    } else {
-        result = matcherBlock(self.subject);
+    if (self.matcherBlock == nil) {
+        [NSException raise:@"KWMatcherException" format:@"no match block was defined for -%@",
+                                                         NSStringFromSelector(self.selector)];
     }
-    return result;
+
+    return KWUserDefinedMatcherEvaluateBlock(self.matcherBlock, [self blockSignature], self.subject, self.invocation);
 }
 
 #pragma mark - Message forwarding
@@ -57,29 +165,62 @@
 }
 
 - (void)forwardInvocation:(NSInvocation *)anInvocation {
-    _invocation = anInvocation;
+    if (anInvocation.selector != self.selector) {
+        [super forwardInvocation:anInvocation];
+        return;
+    }
+
+    [anInvocation retainArguments];
+    self.invocation = anInvocation;
 }
 
 - (NSMethodSignature *)methodSignatureForSelector:(SEL)aSelector {
     if (aSelector == self.selector) {
-        NSString *selectorString = NSStringFromSelector(self.selector);
-
-        /**
-         *   TODO: find a way of doing this that:
-         *   - doesn't require dummy methods (create the method signatures manually)
-         *   - supports an unlimited number of arguments
-         */
-        if ([selectorString hasSuffix:@":"]) {
-            return [self methodSignatureForSelector:@selector(matcherMethodWithArgument:)];
-        } else {
-            return [self methodSignatureForSelector:@selector(matcherMethodWithoutArguments)];
-        }
+        if (self.descriptor != nil && self.descriptor.matcherBlock == self.matcherBlock)
+            return self.descriptor.methodSignature;
+
+        return KWUserDefinedMatcherMethodSignature(aSelector, [self blockSignature]);
     }
     return [super methodSignatureForSelector:aSelector];
 }
 
-- (void)matcherMethodWithoutArguments {}
-- (void)matcherMethodWithArgument:(id)argument {}
+@end
+
+#pragma mark -
+
+@implementation KWUserDefinedMatcherDescriptor
+
+- (id)initWithSelector:(SEL)aSelector
+          matcherBlock:(KWUserDefinedMatcherBlock)aMatcherBlock
+failureMessageForShouldBlock:(KWUserDefinedMatcherMessageBlock)aShouldBlock
+failureMessageForShouldNotBlock:(KWUserDefinedMatcherMessageBlock)aShouldNotBlock
+           description:(NSString *)aDescription {
+    NSMethodSignature *blockSignature = [NSMethodSignature signatureWithBlock:aMatcherBlock];
+    NSUInteger parameterCount = KWSelectorParameterCount(aSelector);
+
+    if (blockSignature != nil && [blockSignature numberOfArguments] > parameterCount + 2) {
+        [NSException raise:@"KWMatcherException" format:@"the match block of -%@ takes %lu arguments after the subject, but the message only has %lu",
+                                                         NSStringFromSelector(aSelector),
+                                                         (unsigned long)([blockSignature numberOfArguments] - 2),
+                                                         (unsigned long)parameterCount];
+    }
+
+    self = [super init];
+    if (self) {
+        _selector = aSelector;
+        _matcherBlock = [aMatcherBlock copy];
+        _failureMessageForShouldBlock = [aShouldBlock copy];
+        _failureMessageForShouldNotBlock = [aShouldNotBlock copy];
+        _matcherDescription = [aDescription copy] ?: KWUserDefinedMatcherDefaultDescription;
+        _blockSignature = blockSignature;
+        _methodSignature = KWUserDefinedMatcherMethodSignature(aSelector, blockSignature);
+    }
+    return self;
+}
+
+- (KWUserDefinedMatcher *)matcherWithSubject:(id)aSubject {
+    return [[KWUserDefinedMatcher alloc] initWithSubject:aSubject descriptor:self];
+}
 
 @end
 
@@ -87,10 +228,12 @@
 
 @interface KWUserDefinedMatcherBuilder ()
 
-@property (nonatomic, strong) KWUserDefinedMatcher *matcher;
+@property (nonatomic, assign) SEL selector;
+@property (nonatomic, copy) KWUserDefinedMatcherBlock matcherBlock;
 @property (nonatomic, copy) KWUserDefinedMatcherMessageBlock failureMessageForShouldBlock;
 @property (nonatomic, copy) KWUserDefinedMatcherMessageBlock failureMessageForShouldNotBlock;
 @property (nonatomic, copy) NSString *matcherBuilderDescription;
+@property (nonatomic, strong) KWUserDefinedMatcherDescriptor *compiledDescriptor;
 
 @end
 
@@ -107,52 +250,53 @@
 - (id)initWithSelector:(SEL)aSelector {
     self = [super init];
     if (self) {
-        _matcher = [[KWUserDefinedMatcher alloc] init];
-        _matcher.selector = aSelector;
+        _selector = aSelector;
     }
     return self;
 }
 
 - (NSString *)key {
-    return NSStringFromSelector(self.matcher.selector);
+    return NSStringFromSelector(self.selector);
 }
 
 #pragma mark - Configuring The Matcher
 
 - (void)match:(KWUserDefinedMatcherBlock)block {
-    self.matcher.matcherBlock = block;
+    self.matcherBlock = block;
+    self.compiledDescriptor = nil;
 }
 
 - (void)failureMessageForShould:(KWUserDefinedMatcherMessageBlock)block {
     self.failureMessageForShouldBlock = block;
+    self.compiledDescriptor = nil;
 }
 
 - (void)failureMessageForShouldNot:(KWUserDefinedMatcherMessageBlock)block {
     self.failureMessageForShouldNotBlock = block;
+    self.compiledDescriptor = nil;
 }
 
 - (void)description:(NSString *)aDescription {
     self.matcherBuilderDescription = aDescription;
+    self.compiledDescriptor = nil;
 }
 
 #pragma mark - Buiding The Matcher
 
-- (KWUserDefinedMatcher *)buildMatcherWithSubject:(id)subject {
-    [self.matcher setSubject:subject];
-
-    if (self.failureMessageForShouldBlock) {
-        [self.matcher setFailureMessageForShould:self.failureMessageForShouldBlock(subject)];
-    }
-
-    if (self.failureMessageForShouldNotBlock) {
-        [self.matcher setFailureMessageForShouldNot:self.failureMessageForShouldNotBlock(subject)];
+- (KWUserDefinedMatcherDescriptor *)descriptor {
+    if (self.compiledDescriptor == nil) {
+        self.compiledDescriptor = [[KWUserDefinedMatcherDescriptor alloc] initWithSelector:self.selector
+                                                                              matcherBlock:self.matcherBlock
+                                                              failureMessageForShouldBlock:self.failureMessageForShouldBlock
+                                                           failureMessageForShouldNotBlock:self.failureMessageForShouldNotBlock
+                                                                               description:self.matcherBuilderDescription];
     }
 
-    if (self.matcherBuilderDescription) {
-        [self.matcher setDescription:self.matcherBuilderDescription];
-    }
+    return self.compiledDescriptor;
+}
 
-    return self.matcher;
+- (KWUserDefinedMatcher *)buildMatcherWithSubject:(id)subject {
+    return [[self descriptor] matcherWithSubject:subject];
 }
 
 @end
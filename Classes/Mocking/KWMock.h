@@ -9,6 +9,7 @@
 
 @class KWMessagePattern;
 @class KWCaptureSpy;
+@class KWInvocationJournal;
 
 @protocol KWMessageSpying;
 @protocol KWVerifying;
@@ -56,6 +57,7 @@
 
 - (void)stub:(SEL)aSelector;
 - (void)stub:(SEL)aSelector withBlock:(id (^)(NSArray *params))block;
+- (void)stub:(SEL)aSelector withTypedBlock:(id)block;
 - (void)stub:(SEL)aSelector withArguments:(id)firstArgument, ...;
 - (void)stub:(SEL)aSelector andReturn:(id)aValue;
 - (void)stub:(SEL)aSelector andReturn:(id)aValue withArguments:(id)firstArgument, ...;
@@ -74,6 +76,9 @@
 - (void)addMessageSpy:(id<KWMessageSpying>)aSpy forMessagePattern:(KWMessagePattern *)aMessagePattern;
 - (void)removeMessageSpy:(id<KWMessageSpying>)aSpy forMessagePattern:(KWMessagePattern *)aMessagePattern;
 
+#pragma mark - Journaling Messages
+
+- (KWInvocationJournal *)invocationJournalForMessagePattern:(KWMessagePattern *)aMessagePattern;
 
 #pragma mark - Expecting Messages
 
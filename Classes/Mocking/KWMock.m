@@ -6,7 +6,11 @@
 
 #import "KWMock.h"
 #import <objc/runtime.h>
+#import <pthread.h>
+#import "KWCounters.h"
 #import "KWFormatter.h"
+#import "KWIntercept.h"
+#import "KWInvocationJournal.h"
 #import "KWMessagePattern.h"
 #import "KWMessageSpying.h"
 #import "KWStringUtilities.h"
@@ -24,13 +28,216 @@ static NSString * const ChangeStubValueAfterTimesKey = @"ChangeStubValueAfterTim
 
 @interface KWMock()
 
-@property (nonatomic, readonly) NSMutableArray *stubs;
-@property (nonatomic, readonly) NSMutableArray *expectedMessagePatterns;
-@property (nonatomic, readonly) NSMapTable *messageSpies;
+// Mocks may be called from several threads at once. Stubs, expected message
+// patterns and spies are published as immutable snapshots through atomic
+// properties; writers serialize on the mock's lock, copy the current snapshot
+// and publish the changed copy.
+@property (atomic, copy) NSArray *stubs;
+@property (atomic, copy) NSArray *expectedMessagePatterns;
+@property (atomic, strong) NSMapTable *messageSpies;
 
 @end
 
-@implementation KWMock
+#pragma mark - Caching Method Signatures
+
+// Every mock of the same class or protocol answers -methodSignatureForSelector:
+// identically, so signatures are shared between all mocks, keyed by the
+// mocked class (or protocol) and selector. Methods added to intercept
+// classes can change what a class answers, so the cache is emptied whenever
+// that happens.
+
+typedef struct KWMockSignatureKey {
+    const void *mockedType;
+    SEL selector;
+} KWMockSignatureKey;
+
+static Boolean KWMockSignatureKeyEqual(const void *first, const void *second) {
+    const KWMockSignatureKey *firstKey = first;
+    const KWMockSignatureKey *secondKey = second;
+    return firstKey->mockedType == secondKey->mockedType && firstKey->selector == secondKey->selector;
+}
+
+static CFHashCode KWMockSignatureKeyHash(const void *key) {
+    const KWMockSignatureKey *signatureKey = key;
+    return ((uintptr_t)signatureKey->mockedType >> 4) ^ ((uintptr_t)signatureKey->selector >> 2);
+}
+
+static void KWMockSignatureKeyRelease(CFAllocatorRef allocator, const void *key) {
+    free((void *)key);
+}
+
+static pthread_rwlock_t KWMockSignaturesLock = PTHREAD_RWLOCK_INITIALIZER;
+static CFMutableDictionaryRef KWMockSignatures = NULL;
+static NSUInteger KWMockSignaturesChangeCount = 0;
+
+static NSMethodSignature *KWMockCachedSignature(const void *mockedType, SEL aSelector, NSUInteger changeCount) {
+    KWMockSignatureKey key = { mockedType, aSelector };
+
+    pthread_rwlock_rdlock(&KWMockSignaturesLock);
+    NSMethodSignature *signature = nil;
+    if (KWMockSignatures != NULL && KWMockSignaturesChangeCount == changeCount)
+        signature = (__bridge NSMethodSignature *)CFDictionaryGetValue(KWMockSignatures, &key);
+    pthread_rwlock_unlock(&KWMockSignaturesLock);
+
+    return signature;
+}
+
+// changeCount is the intercepted methods change count read before the
+// signature was looked up, so that a signature looked up while methods were
+// being added is dropped with the rest.
+static void KWMockCacheSignature(const void *mockedType, SEL aSelector, NSUInteger changeCount, NSMethodSignature *signature) {
+    KWMockSignatureKey *key = malloc(sizeof(KWMockSignatureKey));
+    key->mockedType = mockedType;
+    key->selector = aSelector;
+
+    pthread_rwlock_wrlock(&KWMockSignaturesLock);
+    if (KWMockSignatures == NULL) {
+        CFDictionaryKeyCallBacks keyCallBacks = { 0, NULL, KWMockSignatureKeyRelease, NULL, KWMockSignatureKeyEqual, KWMockSignatureKeyHash };
+        KWMockSignatures = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, &keyCallBacks, &kCFTypeDictionaryValueCallBacks);
+    }
+    if (KWMockSignaturesChangeCount != changeCount) {
+        CFDictionaryRemoveAllValues(KWMockSignatures);
+        KWMockSignaturesChangeCount = changeCount;
+    }
+    CFDictionarySetValue(KWMockSignatures, key, (__bridge const void *)signature);
+    pthread_rwlock_unlock(&KWMockSignaturesLock);
+}
+
+#pragma mark - Caching Protocol Closures
+
+// The transitive closure of a protocol never changes once the protocol is
+// registered, so it is computed once per protocol and flattened into a table
+// of selector to method types. Lookups on protocol mocks are then a single
+// hash probe instead of a walk over the protocol graph.
+
+static Boolean KWProtocolNameEqual(const void *first, const void *second) {
+    return strcmp(first, second) == 0;
+}
+
+static CFHashCode KWProtocolNameHash(const void *name) {
+    CFHashCode hash = 2166136261u;
+    for (const unsigned char *c = name; *c != '\0'; ++c)
+        hash = (hash ^ *c) * 16777619u;
+    return hash;
+}
+
+@interface KWProtocolClosure : NSObject {
+    CFMutableDictionaryRef _methodTypes;
+    CFMutableSetRef _protocolNames;
+}
+
+- (id)initWithProtocol:(Protocol *)aProtocol;
+
+@property (nonatomic, readonly) NSSet *protocols;
+
+- (const char *)methodTypesForSelector:(SEL)aSelector;
+- (BOOL)containsProtocol:(Protocol *)aProtocol;
+
+@end
+
+@implementation KWProtocolClosure
+
+- (id)initWithProtocol:(Protocol *)aProtocol {
+    self = [super init];
+    if (self) {
+        // Selectors and protocol names are owned by the runtime and live for
+        // the lifetime of the process.
+        CFSetCallBacks nameCallBacks = { 0, NULL, NULL, NULL, KWProtocolNameEqual, KWProtocolNameHash };
+        _methodTypes = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, NULL);
+        _protocolNames = CFSetCreateMutable(kCFAllocatorDefault, 0, &nameCallBacks);
+
+        NSMutableSet *protocolSet = [NSMutableSet set];
+        NSMutableArray *protocolQueue = [NSMutableArray arrayWithObject:aProtocol];
+
+        do {
+            Protocol *protocol = [protocolQueue lastObject];
+            [protocolQueue removeLastObject];
+
+            if ([protocolSet containsObject:protocol])
+                continue;
+
+            [protocolSet addObject:protocol];
+            CFSetAddValue(_protocolNames, protocol_getName(protocol));
+
+            // Optional methods were preferred over required ones when the
+            // closure was searched on every call, so add them first.
+            [self addMethodDescriptionsOfProtocol:protocol required:NO];
+            [self addMethodDescriptionsOfProtocol:protocol required:YES];
+
+            unsigned int count = 0;
+            Protocol *__unsafe_unretained*protocols = protocol_copyProtocolList(protocol, &count);
+
+            for (unsigned int i = 0; i < count; ++i)
+                [protocolQueue addObject:protocols[i]];
+
+            free(protocols);
+        } while ([protocolQueue count] != 0);
+
+        _protocols = [protocolSet copy];
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    CFRelease(_methodTypes);
+    CFRelease(_protocolNames);
+}
+
+- (void)addMethodDescriptionsOfProtocol:(Protocol *)aProtocol required:(BOOL)isRequired {
+    unsigned int count = 0;
+    struct objc_method_description *descriptions = protocol_copyMethodDescriptionList(aProtocol, isRequired, YES, &count);
+
+    for (unsigned int i = 0; i < count; ++i) {
+        if (descriptions[i].types != NULL)
+            CFDictionaryAddValue(_methodTypes, descriptions[i].name, descriptions[i].types);
+    }
+
+    free(descriptions);
+}
+
+- (const char *)methodTypesForSelector:(SEL)aSelector {
+    return CFDictionaryGetValue(_methodTypes, aSelector);
+}
+
+- (BOOL)containsProtocol:(Protocol *)aProtocol {
+    return aProtocol != nil && CFSetContainsValue(_protocolNames, protocol_getName(aProtocol));
+}
+
+@end
+
+static pthread_rwlock_t KWProtocolClosuresLock = PTHREAD_RWLOCK_INITIALIZER;
+static CFMutableDictionaryRef KWProtocolClosures = NULL;
+
+static KWProtocolClosure *KWProtocolClosureForProtocol(Protocol *aProtocol) {
+    if (aProtocol == nil)
+        return nil;
+
+    pthread_rwlock_rdlock(&KWProtocolClosuresLock);
+    KWProtocolClosure *closure = KWProtocolClosures ? (__bridge KWProtocolClosure *)CFDictionaryGetValue(KWProtocolClosures, (__bridge const void *)aProtocol) : nil;
+    pthread_rwlock_unlock(&KWProtocolClosuresLock);
+
+    if (closure != nil)
+        return closure;
+
+    closure = [[KWProtocolClosure alloc] initWithProtocol:aProtocol];
+
+    pthread_rwlock_wrlock(&KWProtocolClosuresLock);
+    if (KWProtocolClosures == NULL)
+        KWProtocolClosures = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+    KWProtocolClosure *existingClosure = (__bridge KWProtocolClosure *)CFDictionaryGetValue(KWProtocolClosures, (__bridge const void *)aProtocol);
+    if (existingClosure != nil)
+        closure = existingClosure;
+    else
+        CFDictionarySetValue(KWProtocolClosures, (__bridge const void *)aProtocol, (__bridge const void *)closure);
+    pthread_rwlock_unlock(&KWProtocolClosuresLock);
+
+    return closure;
+}
+
+@implementation KWMock {
+    pthread_mutex_t _lock;
+}
 
 #pragma mark - Initializing
 
@@ -92,14 +299,20 @@ static NSString * const ChangeStubValueAfterTimesKey = @"ChangeStubValueAfterTim
         _mockName = [aName copy];
         _mockedClass = aClass;
         _mockedProtocol = aProtocol;
-        _stubs = [[NSMutableArray alloc] init];
-        _expectedMessagePatterns = [[NSMutableArray alloc] init];
+        _stubs = @[];
+        _expectedMessagePatterns = @[];
         _messageSpies = [NSMapTable mapTableWithKeyOptions:NSMapTableStrongMemory valueOptions:NSMapTableStrongMemory];
+        pthread_mutex_init(&_lock, NULL);
     }
 
     return self;
 }
 
+- (void)dealloc {
+    KWClearInterceptedObject(self);
+    pthread_mutex_destroy(&_lock);
+}
+
 - (id)initAsPartialMockForObject:(id)object {
     return [self initAsPartialMockWithName:nil forObject:object];
 }
@@ -156,53 +369,37 @@ static NSString * const ChangeStubValueAfterTimesKey = @"ChangeStubValueAfterTim
 #pragma mark - Getting Transitive Closure For Mocked Protocols
 
 - (NSSet *)mockedProtocolTransitiveClosureSet {
-    if (self.mockedProtocol == nil)
-        return nil;
-
-    NSMutableSet *protocolSet = [NSMutableSet set];
-    NSMutableArray *protocolQueue = [NSMutableArray array];
-    [protocolQueue addObject:self.mockedProtocol];
-
-    do {
-        Protocol *protocol = [protocolQueue lastObject];
-        [protocolSet addObject:protocol];
-        [protocolQueue removeLastObject];
-
-        unsigned int count = 0;
-        Protocol *__unsafe_unretained*protocols = protocol_copyProtocolList(protocol, &count);
-
-        if (count == 0)
-            continue;
-
-        for (unsigned int i = 0; i < count; ++i)
-            [protocolQueue addObject:protocols[i]];
-
-        free(protocols);
-    } while ([protocolQueue count] != 0);
-
-    return protocolSet;
+    return KWProtocolClosureForProtocol(self.mockedProtocol).protocols;
 }
 
 #pragma mark - Stubbing Methods
 
-- (void)removeStubWithMessagePattern:(KWMessagePattern *)messagePattern {
-    KWStub *stub = [self currentStubWithMessagePattern:messagePattern];
-    if (stub) {
-        [self.stubs removeObject:stub];
-    }
-}
+- (void)addStub:(KWStub *)aStub overrideExisting:(BOOL)overrideExisting {
+    pthread_mutex_lock(&_lock);
+    NSMutableArray *stubs = [self.stubs mutableCopy];
+    NSUInteger stubCount = [stubs count];
+    BOOL shouldAddStub = YES;
 
-- (KWStub *)currentStubWithMessagePattern:(KWMessagePattern *)messagePattern {
-    NSUInteger stubCount = [self.stubs count];
-    
     for (NSUInteger i = 0; i < stubCount; ++i) {
-        KWStub *stub = (self.stubs)[i];
-        
-        if ([stub.messagePattern isEqualToMessagePattern:messagePattern]) {
-            return stub;
+        KWStub *existingStub = stubs[i];
+
+        if ([existingStub.messagePattern isEqualToMessagePattern:aStub.messagePattern]) {
+            if (overrideExisting)
+                [stubs removeObjectAtIndex:i];
+            else
+                shouldAddStub = NO;
+
+            break;
         }
     }
-    return nil;
+
+    if (shouldAddStub) {
+        [stubs addObject:aStub];
+        self.stubs = stubs;
+        KWCounterIncrement(KWCounterStubsInstalled);
+    }
+
+    pthread_mutex_unlock(&_lock);
 }
 
 - (void)stub:(SEL)aSelector {
@@ -215,6 +412,11 @@ static NSString * const ChangeStubValueAfterTimesKey = @"ChangeStubValueAfterTim
     [self stubMessagePattern:messagePattern withBlock:block];
 }
 
+- (void)stub:(SEL)aSelector withTypedBlock:(id)block {
+    KWMessagePattern *messagePattern = [KWMessagePattern messagePatternWithSelector:aSelector];
+    [self stubMessagePattern:messagePattern withTypedBlock:block];
+}
+
 - (void)stub:(SEL)aSelector withArguments:(id)firstArgument, ... {
     va_list argumentList;
     va_start(argumentList, firstArgument);
@@ -256,54 +458,76 @@ static NSString * const ChangeStubValueAfterTimesKey = @"ChangeStubValueAfterTim
 
 - (void)stubMessagePattern:(KWMessagePattern *)aMessagePattern andReturn:(id)aValue overrideExisting:(BOOL)overrideExisting {
     [self expectMessagePattern:aMessagePattern];
-    KWStub *existingStub = [self currentStubWithMessagePattern:aMessagePattern];
-    if (existingStub) {
-        if (overrideExisting) {
-            [self.stubs removeObject:existingStub];
-        } else {
-            return;
-        }
-    }
     KWStub *stub = [KWStub stubWithMessagePattern:aMessagePattern value:aValue];
-    [self.stubs addObject:stub];
+    [self addStub:stub overrideExisting:overrideExisting];
 }
 
 - (void)stubMessagePattern:(KWMessagePattern *)aMessagePattern withBlock:(id (^)(NSArray *params))block {
     [self expectMessagePattern:aMessagePattern];
-    [self removeStubWithMessagePattern:aMessagePattern];
     KWStub *stub = [KWStub stubWithMessagePattern:aMessagePattern block:block];
-    [self.stubs addObject:stub];
+    [self addStub:stub overrideExisting:YES];
+}
+
+- (void)stubMessagePattern:(KWMessagePattern *)aMessagePattern withTypedBlock:(id)block {
+    KWStub *stub = [KWStub stubWithMessagePattern:aMessagePattern
+                                       typedBlock:block
+                                  methodSignature:[self methodSignatureForSelector:aMessagePattern.selector]];
+    [self expectMessagePattern:aMessagePattern];
+    [self addStub:stub overrideExisting:YES];
 }
 
 - (void)stubMessagePattern:(KWMessagePattern *)aMessagePattern andReturn:(id)aValue times:(id)times afterThatReturn:(id)aSecondValue {   
     [self expectMessagePattern:aMessagePattern];
-    [self removeStubWithMessagePattern:aMessagePattern];
     KWStub *stub = [KWStub stubWithMessagePattern:aMessagePattern value:aValue times:times afterThatReturn:aSecondValue];
-    [self.stubs addObject:stub];
+    [self addStub:stub overrideExisting:YES];
 }
 
 - (void)clearStubs {
-    [self.stubs removeAllObjects];
+    pthread_mutex_lock(&_lock);
+    self.stubs = @[];
+    pthread_mutex_unlock(&_lock);
 }
 
 #pragma mark - Spying on Messages
 
 - (void)addMessageSpy:(id<KWMessageSpying>)aSpy forMessagePattern:(KWMessagePattern *)aMessagePattern {
     [self expectMessagePattern:aMessagePattern];
-    NSMutableArray *messagePatternSpies = [self.messageSpies objectForKey:aMessagePattern];
-
-    if (messagePatternSpies == nil) {
-        messagePatternSpies = [[NSMutableArray alloc] init];
-        [self.messageSpies setObject:messagePatternSpies forKey:aMessagePattern];
+    pthread_mutex_lock(&_lock);
+    NSArray *messagePatternSpies = [self.messageSpies objectForKey:aMessagePattern];
+
+    if (![messagePatternSpies containsObject:aSpy]) {
+        NSMapTable *messageSpies = [self.messageSpies copy];
+        [messageSpies setObject:(messagePatternSpies != nil ? [messagePatternSpies arrayByAddingObject:aSpy] : @[aSpy]) forKey:aMessagePattern];
+        self.messageSpies = messageSpies;
+        KWCounterIncrement(KWCounterSpiesInstalled);
     }
 
-    if (![messagePatternSpies containsObject:aSpy])
-        [messagePatternSpies addObject:aSpy];
+    pthread_mutex_unlock(&_lock);
 }
 
 - (void)removeMessageSpy:(id<KWMessageSpying>)aSpy forMessagePattern:(KWMessagePattern *)aMessagePattern {
-    NSMutableArray *messagePatternSpies = [self.messageSpies objectForKey:aMessagePattern];
-    [messagePatternSpies removeObject:aSpy];
+    pthread_mutex_lock(&_lock);
+    NSArray *messagePatternSpies = [self.messageSpies objectForKey:aMessagePattern];
+
+    if ([messagePatternSpies containsObject:aSpy]) {
+        NSMutableArray *remainingSpies = [messagePatternSpies mutableCopy];
+        [remainingSpies removeObject:aSpy];
+        NSMapTable *messageSpies = [self.messageSpies copy];
+        [messageSpies setObject:[remainingSpies copy] forKey:aMessagePattern];
+        self.messageSpies = messageSpies;
+    }
+
+    pthread_mutex_unlock(&_lock);
+}
+
+#pragma mark - Journaling Messages
+
+// Mocks only journal messages once a journal has been asked for, and the
+// journal is cleared with the stubs and spies of the generation it was asked
+// for in, like the journals of intercepted objects.
+- (KWInvocationJournal *)invocationJournalForMessagePattern:(KWMessagePattern *)aMessagePattern {
+    [self expectMessagePattern:aMessagePattern];
+    return KWObjectInvocationJournal(self);
 }
 
 #pragma mark - Expecting Message Patterns
@@ -326,8 +550,12 @@ static NSString * const ChangeStubValueAfterTimesKey = @"ChangeStubValueAfterTim
 }
 
 - (void)expectMessagePattern:(KWMessagePattern *)aMessagePattern {
+    pthread_mutex_lock(&_lock);
+
     if (![self.expectedMessagePatterns containsObject:aMessagePattern])
-        [self.expectedMessagePatterns addObject:aMessagePattern];
+        self.expectedMessagePatterns = [self.expectedMessagePatterns arrayByAddingObject:aMessagePattern];
+
+    pthread_mutex_unlock(&_lock);
 }
 
 #pragma mark - Capturing Invocations
@@ -364,9 +592,13 @@ static NSString * const ChangeStubValueAfterTimesKey = @"ChangeStubValueAfterTim
 }
 
 - (BOOL)processReceivedInvocation:(NSInvocation *)invocation {
-    for (KWMessagePattern *messagePattern in self.messageSpies) {
+    KWCounterIncrement(KWCounterMockInvocations);
+    [KWInvocationJournalForObject(self) recordInvocation:invocation];
+    NSMapTable *messageSpies = self.messageSpies;
+
+    for (KWMessagePattern *messagePattern in messageSpies) {
         if ([messagePattern matchesInvocation:invocation]) {
-            NSArray *spies = [self.messageSpies objectForKey:messagePattern];
+            NSArray *spies = [messageSpies objectForKey:messagePattern];
 
               for (id<KWMessageSpying> spy in spies) {
                 [spy object:self didReceiveInvocation:invocation];
@@ -383,34 +615,32 @@ static NSString * const ChangeStubValueAfterTimesKey = @"ChangeStubValueAfterTim
 }
 
 - (NSMethodSignature *)mockedProtocolMethodSignatureForSelector:(SEL)aSelector {
-    NSSet *protocols = [self mockedProtocolTransitiveClosureSet];
-
-    for (Protocol *protocol in protocols) {
-        struct objc_method_description description = protocol_getMethodDescription(protocol, aSelector, NO, YES);
-
-        if (description.types == nil)
-            description = protocol_getMethodDescription(protocol, aSelector, YES, YES);
-
-        if (description.types != nil)
-            return [NSMethodSignature signatureWithObjCTypes:description.types];
-    }
-
-    return nil;
+    const char *types = [KWProtocolClosureForProtocol(self.mockedProtocol) methodTypesForSelector:aSelector];
+    return types != NULL ? [NSMethodSignature signatureWithObjCTypes:types] : nil;
 }
 
 - (NSMethodSignature *)methodSignatureForSelector:(SEL)aSelector {
-    NSMethodSignature *methodSignature = [self.mockedClass instanceMethodSignatureForSelector:aSelector];
+    const void *mockedType = self.mockedClass != nil ? (__bridge const void *)self.mockedClass : (__bridge const void *)self.mockedProtocol;
+    NSUInteger changeCount = KWInterceptedMethodsChangeCount();
+    NSMethodSignature *methodSignature = KWMockCachedSignature(mockedType, aSelector, changeCount);
 
     if (methodSignature != nil)
         return methodSignature;
 
-    methodSignature = [self mockedProtocolMethodSignatureForSelector:aSelector];
+    methodSignature = [self.mockedClass instanceMethodSignatureForSelector:aSelector];
 
-    if (methodSignature != nil)
-        return methodSignature;
+    if (methodSignature == nil)
+        methodSignature = [self mockedProtocolMethodSignatureForSelector:aSelector];
+
+    // The default signature is not cached, since the method may still be
+    // added to the mocked class.
+    if (methodSignature == nil) {
+        NSString *encoding = KWEncodingForDefaultMethod();
+        return [NSMethodSignature signatureWithObjCTypes:[encoding UTF8String]];
+    }
 
-    NSString *encoding = KWEncodingForDefaultMethod();
-    return [NSMethodSignature signatureWithObjCTypes:[encoding UTF8String]];
+    KWMockCacheSignature(mockedType, aSelector, changeCount, methodSignature);
+    return methodSignature;
 }
 
 - (void)forwardInvocation:(NSInvocation *)anInvocation {
@@ -468,26 +698,11 @@ static NSString * const ChangeStubValueAfterTimesKey = @"ChangeStubValueAfterTim
 }
 
 - (BOOL)mockedProtocolRespondsToSelector:(SEL)aSelector {
-    NSSet *protocols = [self mockedProtocolTransitiveClosureSet];
-
-    for (Protocol *protocol in protocols) {
-        struct objc_method_description description = protocol_getMethodDescription(protocol, aSelector, NO, YES);
-
-        if (description.types == nil)
-            description = protocol_getMethodDescription(protocol, aSelector, YES, YES);
-
-        if (description.types != nil)
-            return YES;
-    }
-
-    return NO;
+    return [KWProtocolClosureForProtocol(self.mockedProtocol) methodTypesForSelector:aSelector] != NULL;
 }
 
 - (BOOL)mockedProtocolConformsToProtocol:(Protocol *)aProtocol {
-    if (self.mockedProtocol == nil)
-        return NO;
-
-    return protocol_isEqual(self.mockedProtocol, aProtocol) || protocol_conformsToProtocol(self.mockedProtocol, aProtocol);
+    return [KWProtocolClosureForProtocol(self.mockedProtocol) containsProtocol:aProtocol];
 }
 
 - (BOOL)isKindOfClass:(Class)aClass {
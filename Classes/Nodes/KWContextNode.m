@@ -14,6 +14,7 @@
 #import "KWExampleNodeVisitor.h"
 #import "KWExample.h"
 #import "KWFailure.h"
+#import "KWIntercept.h"
 #import "KWRegisterMatchersNode.h"
 #import "KWSymbolicator.h"
 
@@ -22,6 +23,7 @@ static NSString * const KWContextNodeException = @"KWContextNodeException";
 @interface KWContextNode()
 
 @property (nonatomic, assign) NSUInteger performedExampleCount;
+@property (nonatomic, assign) NSUInteger interceptGeneration;
 
 @end
 
@@ -103,8 +105,18 @@ static NSString * const KWContextNodeException = @"KWContextNodeException";
                 [registerNode acceptExampleNodeVisitor:example];
             }
 
-            if (self.performedExampleCount == 0) {
-                [self.beforeAllNode acceptExampleNodeVisitor:example];
+            if (self.performedExampleCount == 0 && self.beforeAllNode != nil) {
+                // Stubs and spies created by beforeAll blocks last until
+                // the afterAll block of the context has run.
+                NSUInteger exampleGeneration = KWCurrentInterceptGeneration();
+                self.interceptGeneration = KWNewInterceptGeneration();
+                KWSetCurrentInterceptGeneration(self.interceptGeneration);
+
+                @try {
+                    [self.beforeAllNode acceptExampleNodeVisitor:example];
+                } @finally {
+                    KWSetCurrentInterceptGeneration(exampleGeneration);
+                }
             }
 
             KWLetNode *letNodeTree = [self letNodeTree];
@@ -125,6 +137,11 @@ static NSString * const KWContextNodeException = @"KWContextNodeException";
             KWFailure *failure = [KWFailure failureWithCallSite:self.callSite format:@"%@ \"%@\" raised", [exception name], [exception reason]];
             [example reportFailure:failure];
         }
+
+        if (self.interceptGeneration != 0 && [example isLastInContext:self]) {
+            KWClearStubsAndSpiesOfGeneration(self.interceptGeneration);
+            self.interceptGeneration = 0;
+        }
         
         self.performedExampleCount++;
     };
@@ -7,6 +7,7 @@
 #import "KiwiConfiguration.h"
 #import <objc/runtime.h>
 
+@class KWInvocationJournal;
 @class KWMessagePattern;
 @class KWStub;
 
@@ -16,6 +17,26 @@ IMP KWRegularForwardingImplementation(void);
 IMP KWStretForwardingImplementation(void);
 IMP KWForwardingImplementationForMethodEncoding(const char* encoding);
 
+#pragma mark - Getting Direct Implementations
+
+// Returns an implementation of aSelector for interceptClass that answers
+// stubbed messages without going through the forwarding machinery, or NULL
+// if the method has a signature that needs forwarding (struct or long double
+// values, floating point arguments, or more than four arguments).
+IMP KWDirectImplementationForMethod(Class interceptClass, SEL aSelector, const char* encoding);
+
+#pragma mark - Observing Intercepted Methods
+
+// Incremented whenever a method is added to an intercept class, so that
+// caches of what classes answer can tell when they may be stale.
+NSUInteger KWInterceptedMethodsChangeCount(void);
+
+#pragma mark - Calling Original Implementations
+
+// Intercept classes keep the original implementation of every intercepted
+// method under this selector.
+SEL KWOriginalSelectorForSelector(SEL aSelector);
+
 #pragma mark - Getting Intercept Class Information
 
 BOOL KWObjectIsClass(id anObject);
@@ -32,6 +53,27 @@ void KWSetupMethodInterceptSupport(Class interceptClass, SEL aSelector);
 #pragma mark - Managing Stubs & Spies
 void KWClearStubsAndSpies(void);
 
+// The registry does not retain the objects it has stubs, spies or journals
+// for. Removes everything it has for anObject, which is about to be
+// deallocated.
+void KWClearInterceptedObject(id anObject);
+
+#pragma mark - Scoping Stubs & Spies
+
+// Stubs, spies and journals belong to the generation that is current when
+// they are created. Each example runs in a generation of its own, and each
+// context with a beforeAll block has one that lives until its afterAll block
+// has run. Generation 0 is current outside of examples and is only cleared
+// by KWClearStubsAndSpies().
+NSUInteger KWNewInterceptGeneration(void);
+NSUInteger KWCurrentInterceptGeneration(void);
+void KWSetCurrentInterceptGeneration(NSUInteger generation);
+
+// Removes the stubs, spies and journals that were created in generation and
+// restores the class of objects that have none left. A stub that overrode a
+// stub from another generation is removed, uncovering the overridden stub.
+void KWClearStubsAndSpiesOfGeneration(NSUInteger generation);
+
 #pragma mark - Managing Objects Stubs
 
 void KWAssociateObjectStub(id anObject, KWStub *aStub, BOOL overrideExisting);
@@ -43,3 +85,13 @@ void KWClearAllObjectStubs(void);
 void KWAssociateMessageSpy(id anObject, id aSpy, KWMessagePattern *aMessagePattern);
 void KWClearObjectSpy(id anObject, id aSpy, KWMessagePattern *aMessagePattern);
 void KWClearAllMessageSpies(void);
+
+#pragma mark - Managing Invocation Journals
+
+// Returns the journal of messages received by anObject's intercepted
+// methods, or by a mock, creating it if needed. Journals are cleared along with stubs and
+// spies.
+KWInvocationJournal *KWObjectInvocationJournal(id anObject);
+
+// Returns nil if no journal has been asked for.
+KWInvocationJournal *KWInvocationJournalForObject(id anObject);
@@ -5,35 +5,39 @@
 //
 
 #import "KWIntercept.h"
+#import "KWCounters.h"
+#import "KWInvocationJournal.h"
 #import "KWMessagePattern.h"
 #import "KWMessageSpying.h"
+#import "KWObjCUtilities.h"
 #import "KWStub.h"
+#import <objc/message.h>
+#import <pthread.h>
+#import <stdatomic.h>
 
 static const char * const KWInterceptClassSuffix = "_KWIntercept";
+static const char * const KWOriginalSelectorPrefix = "KWOriginal_";
 
-void KWObjectStubsInit(void);
 void KWClearObjectStubs(id anObject);
 void KWClearAllObjectStubs(void);
-NSMutableArray *KWObjectStubsForObject(id anObject);
-void KWObjectStubsSet(id anObject, NSMutableArray *stubs);
+NSArray *KWObjectStubsForObject(id anObject);
 
-void KWMessageSpiesInit(void);
 NSMapTable *KWMessageSpiesForObject(id anObject);
 void KWClearMessageSpies(id anObject);
-void KWMessageSpiesSet(id anObject, NSMapTable *spies);
+
+void KWClearInvocationJournal(id anObject);
+void KWClearAllInvocationJournals(void);
+
+static NSDictionary *KWDirectDispatchEntriesForObject(id anObject);
 
 Class KWRestoreOriginalClass(id anObject);
 BOOL KWObjectClassRestored(id anObject);
 
-typedef id (^KWInterceptedObjectBlock)(void);
-// Use KWInterceptedObjectKey, instead of the object itself, when
-// registering an object in a global map table, to prevent an infinite
-// loop when the object is hashed.
-KWInterceptedObjectBlock KWInterceptedObjectKey(id anObject);
 
 #pragma mark - Intercept Enabled Method Implementations
 
 void KWInterceptedForwardInvocation(id anObject, SEL aSelector, NSInvocation* anInvocation);
+void KWInterceptedProcessInvocation(id anObject, NSInvocation *anInvocation);
 void KWInterceptedDealloc(id anObject, SEL aSelector);
 Class KWInterceptedClass(id anObject, SEL aSelector);
 Class KWInterceptedSuperclass(id anObject, SEL aSelector);
@@ -82,6 +86,227 @@ IMP KWForwardingImplementationForMethodEncoding(const char* encoding) {
     }
 }
 
+#pragma mark - Getting Direct Implementations
+
+// Direct implementations take every argument as a uintptr_t and return a
+// uintptr_t, float or double, which matches how the supported architectures
+// pass anything that fits into a general purpose register. Stubs that can
+// answer without an invocation are handled in place; everything else builds
+// the invocation the forwarding machinery would have built and processes it
+// as KWInterceptedForwardInvocation would.
+
+static const NSUInteger KWDirectImplementationMaxArguments = 4;
+
+typedef NS_ENUM(NSUInteger, KWDirectReturnKind) {
+    KWDirectReturnKindWord,
+    KWDirectReturnKindFloat,
+    KWDirectReturnKindDouble
+};
+
+// What a direct implementation needs to know about its method, worked out
+// once when the method is added to its intercept class. Intercept classes
+// are never disposed, so neither is this.
+typedef struct KWDirectMethod {
+    SEL selector;
+    __unsafe_unretained Class originalClass;
+    CFTypeRef signature;
+    const char *returnType;
+    KWDirectReturnKind returnKind;
+    NSUInteger argumentCount;
+} KWDirectMethod;
+
+typedef NS_ENUM(NSUInteger, KWDirectDispatchResult) {
+    KWDirectDispatchResultProcessed,
+    KWDirectDispatchResultNeedsInvocation,
+    KWDirectDispatchResultNotStubbed
+};
+
+#define KWCallImplementationBody(returnType) \
+    switch (count) { \
+        case 0: return ((returnType (*)(id, SEL))implementation)(anObject, aSelector); \
+        case 1: return ((returnType (*)(id, SEL, uintptr_t))implementation)(anObject, aSelector, a[0]); \
+        case 2: return ((returnType (*)(id, SEL, uintptr_t, uintptr_t))implementation)(anObject, aSelector, a[0], a[1]); \
+        case 3: return ((returnType (*)(id, SEL, uintptr_t, uintptr_t, uintptr_t))implementation)(anObject, aSelector, a[0], a[1], a[2]); \
+        default: return ((returnType (*)(id, SEL, uintptr_t, uintptr_t, uintptr_t, uintptr_t))implementation)(anObject, aSelector, a[0], a[1], a[2], a[3]); \
+    }
+
+static uintptr_t KWCallWordImplementation(IMP implementation, id anObject, SEL aSelector, const uintptr_t *a, NSUInteger count) { KWCallImplementationBody(uintptr_t) }
+static float KWCallFloatImplementation(IMP implementation, id anObject, SEL aSelector, const uintptr_t *a, NSUInteger count) { KWCallImplementationBody(float) }
+static double KWCallDoubleImplementation(IMP implementation, id anObject, SEL aSelector, const uintptr_t *a, NSUInteger count) { KWCallImplementationBody(double) }
+
+#undef KWCallImplementationBody
+
+static void KWCallImplementationForDirectMethod(IMP implementation, id anObject, const KWDirectMethod *method, const uintptr_t *arguments, void *returnBuffer) {
+    switch (method->returnKind) {
+        case KWDirectReturnKindWord:
+            *(uintptr_t *)returnBuffer = KWCallWordImplementation(implementation, anObject, method->selector, arguments, method->argumentCount);
+            break;
+        case KWDirectReturnKindFloat:
+            *(float *)returnBuffer = KWCallFloatImplementation(implementation, anObject, method->selector, arguments, method->argumentCount);
+            break;
+        case KWDirectReturnKindDouble:
+            *(double *)returnBuffer = KWCallDoubleImplementation(implementation, anObject, method->selector, arguments, method->argumentCount);
+            break;
+    }
+}
+
+// Calls the implementation the intercept class inherits from the original
+// class, with the original selector, without touching the object's class.
+static BOOL KWInterceptedCallOriginalImplementation(id anObject, const KWDirectMethod *method, const uintptr_t *arguments, void *returnBuffer) {
+    IMP implementation = class_getMethodImplementation(method->originalClass, method->selector);
+
+    // Messages the original class answers by forwarding would come straight
+    // back to the intercept class.
+    if (implementation == NULL || implementation == (IMP)_objc_msgForward)
+        return NO;
+
+    KWCallImplementationForDirectMethod(implementation, anObject, method, arguments, returnBuffer);
+    return YES;
+}
+
+static KWDirectDispatchResult KWInterceptedProcessMessageDirectly(id anObject, const KWDirectMethod *method, const uintptr_t *arguments, void *returnBuffer) {
+    NSDictionary *entries = KWDirectDispatchEntriesForObject(anObject);
+    id entry = entries != nil ? (__bridge id)CFDictionaryGetValue((__bridge CFDictionaryRef)entries, method->selector) : nil;
+
+    if (entry == nil)
+        return KWDirectDispatchResultNotStubbed;
+
+    if (entry == (__bridge id)kCFNull)
+        return KWDirectDispatchResultNeedsInvocation;
+
+    // Patterns without argument filters match on the selector alone, so the
+    // lookup stands in for trying the stub's pattern.
+    KWCounterIncrement(KWCounterMessagePatternMatchAttempts);
+    KWCounterIncrement(KWCounterMessagePatternMatches);
+    KWStub *stub = entry;
+    IMP typedBlockImplementation = stub.typedBlockImplementation;
+
+    if (typedBlockImplementation != NULL) {
+        KWCallImplementationForDirectMethod(typedBlockImplementation, anObject, method, arguments, returnBuffer);
+        [stub typedBlockDidReturnValue:returnBuffer objCType:method->returnType];
+    } else {
+        [stub writeReturnValue:returnBuffer forSelector:method->selector objCType:method->returnType];
+    }
+
+    return KWDirectDispatchResultProcessed;
+}
+
+static void KWInterceptedDirectDispatch(id anObject, const KWDirectMethod *method, const uintptr_t *arguments, void *returnBuffer) {
+    KWCounterIncrement(KWCounterInterceptedInvocations);
+    [KWInvocationJournalForObject(anObject) recordSelector:method->selector arguments:arguments count:method->argumentCount];
+
+    switch (KWInterceptedProcessMessageDirectly(anObject, method, arguments, returnBuffer)) {
+        case KWDirectDispatchResultProcessed:
+            return;
+        case KWDirectDispatchResultNotStubbed:
+            if (KWInterceptedCallOriginalImplementation(anObject, method, arguments, returnBuffer))
+                return;
+            break;
+        case KWDirectDispatchResultNeedsInvocation:
+            break;
+    }
+
+    NSMethodSignature *signature = (__bridge NSMethodSignature *)method->signature;
+    NSInvocation *invocation = [NSInvocation invocationWithMethodSignature:signature];
+    [invocation setTarget:anObject];
+    [invocation setSelector:method->selector];
+
+    for (NSUInteger i = 0; i < method->argumentCount; ++i)
+        [invocation setArgument:(void *)&arguments[i] atIndex:i + 2];
+
+    KWInterceptedProcessInvocation(anObject, invocation);
+
+    if ([signature methodReturnLength] > 0)
+        [invocation getReturnValue:returnBuffer];
+}
+
+#define KWDirectImplementationBody(returnType, arguments) \
+    double returnValue[2] = { 0.0, 0.0 }; \
+    KWInterceptedDirectDispatch(anObject, method, arguments, returnValue); \
+    return *(returnType *)returnValue;
+
+#define KWDirectImplementationReturning(returnType) \
+    switch (method->argumentCount) { \
+        case 0: return imp_implementationWithBlock(^returnType(id anObject) { \
+            KWDirectImplementationBody(returnType, NULL) }); \
+        case 1: return imp_implementationWithBlock(^returnType(id anObject, uintptr_t a) { \
+            const uintptr_t arguments[] = { a }; KWDirectImplementationBody(returnType, arguments) }); \
+        case 2: return imp_implementationWithBlock(^returnType(id anObject, uintptr_t a, uintptr_t b) { \
+            const uintptr_t arguments[] = { a, b }; KWDirectImplementationBody(returnType, arguments) }); \
+        case 3: return imp_implementationWithBlock(^returnType(id anObject, uintptr_t a, uintptr_t b, uintptr_t c) { \
+            const uintptr_t arguments[] = { a, b, c }; KWDirectImplementationBody(returnType, arguments) }); \
+        default: return imp_implementationWithBlock(^returnType(id anObject, uintptr_t a, uintptr_t b, uintptr_t c, uintptr_t d) { \
+            const uintptr_t arguments[] = { a, b, c, d }; KWDirectImplementationBody(returnType, arguments) }); \
+    }
+
+static IMP KWDirectImplementationForDirectMethod(const KWDirectMethod *method) {
+    switch (method->returnKind) {
+        case KWDirectReturnKindWord:
+            KWDirectImplementationReturning(uintptr_t)
+        case KWDirectReturnKindFloat:
+            KWDirectImplementationReturning(float)
+        case KWDirectReturnKindDouble:
+            KWDirectImplementationReturning(double)
+    }
+
+    return NULL;
+}
+
+#undef KWDirectImplementationReturning
+#undef KWDirectImplementationBody
+
+static BOOL KWObjCTypeFitsInWord(const char *objCType) {
+    const KWObjCTypeDescriptor *descriptor = KWObjCTypeDescriptorForObjCType(objCType);
+
+    switch (descriptor->kind) {
+        case KWObjCTypeKindIntegral:
+        case KWObjCTypeKindObject:
+        case KWObjCTypeKindBlock:
+        case KWObjCTypeKindClass:
+        case KWObjCTypeKindSelector:
+        case KWObjCTypeKindCharString:
+        case KWObjCTypeKindPointer:
+            return descriptor->size <= sizeof(uintptr_t);
+        default:
+            // bool is not one of the integral encodings.
+            return (descriptor->traits & KWObjCTypeTraitBoolean) != 0;
+    }
+}
+
+IMP KWDirectImplementationForMethod(Class interceptClass, SEL aSelector, const char* encoding) {
+    NSMethodSignature *signature = [NSMethodSignature signatureWithObjCTypes:encoding];
+    NSUInteger numberOfMessageArguments = [signature numberOfArguments] - 2;
+
+    if (numberOfMessageArguments > KWDirectImplementationMaxArguments)
+        return NULL;
+
+    for (NSUInteger i = 0; i < numberOfMessageArguments; ++i) {
+        if (!KWObjCTypeFitsInWord([signature getArgumentTypeAtIndex:i + 2]))
+            return NULL;
+    }
+
+    const char *returnType = [signature methodReturnType];
+    KWDirectReturnKind returnKind;
+
+    if (KWObjCTypeEqualToObjCType(returnType, @encode(void)) || KWObjCTypeFitsInWord(returnType))
+        returnKind = KWDirectReturnKindWord;
+    else if (KWObjCTypeEqualToObjCType(returnType, @encode(float)))
+        returnKind = KWDirectReturnKindFloat;
+    else if (KWObjCTypeEqualToObjCType(returnType, @encode(double)))
+        returnKind = KWDirectReturnKindDouble;
+    else
+        return NULL;
+
+    KWDirectMethod *method = calloc(1, sizeof(KWDirectMethod));
+    method->selector = aSelector;
+    method->originalClass = class_getSuperclass(interceptClass);
+    method->signature = CFBridgingRetain(signature);
+    method->returnType = returnType;
+    method->returnKind = returnKind;
+    method->argumentCount = numberOfMessageArguments;
+    return KWDirectImplementationForDirectMethod(method);
+}
+
 #pragma mark - Getting Intercept Class Information
 
 BOOL KWObjectIsClass(id anObject) {
@@ -111,6 +336,7 @@ Class KWInterceptClassForCanonicalClass(Class canonicalClass) {
 
     interceptClass = objc_allocateClassPair(canonicalClass, [interceptClassName UTF8String], 0);
     objc_registerClassPair(interceptClass);
+    KWCounterIncrement(KWCounterInterceptClassesCreated);
 
     class_addMethod(interceptClass, @selector(forwardInvocation:), (IMP)KWInterceptedForwardInvocation, "v@:@");
     class_addMethod(interceptClass, @selector(class), (IMP)KWInterceptedClass, "#@:");
@@ -148,6 +374,14 @@ Class KWRealClassForClass(Class aClass) {
     return aClass;
 }
 
+#pragma mark - Observing Intercepted Methods
+
+static _Atomic(NSUInteger) KWInterceptedMethodsChanges = 0;
+
+NSUInteger KWInterceptedMethodsChangeCount(void) {
+    return atomic_load_explicit(&KWInterceptedMethodsChanges, memory_order_acquire);
+}
+
 #pragma mark - Enabling Intercepting
 
 static BOOL IsTollFreeBridged(Class class, id obj)
@@ -193,13 +427,65 @@ void KWSetupMethodInterceptSupport(Class interceptClass, SEL aSelector) {
     }
 
     const char *encoding = method_getTypeEncoding(method);
-    IMP forwardingImplementation = KWForwardingImplementationForMethodEncoding(encoding);
-    class_addMethod(interceptClass, aSelector, forwardingImplementation, encoding);
+    IMP originalImplementation = method_getImplementation(method);
+
+    // Only the first call for a selector sees the original implementation;
+    // later calls fail to add the method, which is what we want. The method
+    // forwards until its direct implementation, if it can have one, is in
+    // place.
+    if (!class_addMethod(interceptClass, aSelector, KWForwardingImplementationForMethodEncoding(encoding), encoding))
+        return;
+
+    atomic_fetch_add_explicit(&KWInterceptedMethodsChanges, 1, memory_order_release);
+
+    if (originalImplementation != (IMP)_objc_msgForward)
+        class_addMethod(interceptClass, KWOriginalSelectorForSelector(aSelector), originalImplementation, encoding);
+
+    IMP directImplementation = KWDirectImplementationForMethod(interceptClass, aSelector, encoding);
+
+    if (directImplementation != NULL)
+        class_replaceMethod(interceptClass, aSelector, directImplementation, encoding);
+}
+
+#pragma mark - Calling Original Implementations
+
+static pthread_rwlock_t KWOriginalSelectorsLock = PTHREAD_RWLOCK_INITIALIZER;
+static CFMutableDictionaryRef KWOriginalSelectors = NULL;
+
+SEL KWOriginalSelectorForSelector(SEL aSelector) {
+    pthread_rwlock_rdlock(&KWOriginalSelectorsLock);
+    SEL originalSelector = KWOriginalSelectors ? (SEL)CFDictionaryGetValue(KWOriginalSelectors, aSelector) : NULL;
+    pthread_rwlock_unlock(&KWOriginalSelectorsLock);
+
+    if (originalSelector != NULL)
+        return originalSelector;
+
+    NSString *name = [NSString stringWithFormat:@"%s%s", KWOriginalSelectorPrefix, sel_getName(aSelector)];
+    originalSelector = sel_registerName([name UTF8String]);
+
+    pthread_rwlock_wrlock(&KWOriginalSelectorsLock);
+    if (KWOriginalSelectors == NULL)
+        KWOriginalSelectors = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, NULL);
+    CFDictionarySetValue(KWOriginalSelectors, aSelector, originalSelector);
+    pthread_rwlock_unlock(&KWOriginalSelectorsLock);
+
+    return originalSelector;
 }
 
 #pragma mark - Intercept Enabled Method Implementations
 
+// Available on every supported version of Foundation, but not declared.
+@interface NSInvocation (KWInterceptPrivate)
+- (void)invokeUsingIMP:(IMP)anImplementation;
+@end
+
 void KWInterceptedForwardInvocation(id anObject, SEL aSelector, NSInvocation* anInvocation) {
+    KWCounterIncrement(KWCounterInterceptedInvocations);
+    [KWInvocationJournalForObject(anObject) recordInvocation:anInvocation];
+    KWInterceptedProcessInvocation(anObject, anInvocation);
+}
+
+void KWInterceptedProcessInvocation(id anObject, NSInvocation *anInvocation) {
     NSMapTable *spiesMap = KWMessageSpiesForObject(anObject);
     for (KWMessagePattern *messagePattern in spiesMap) {
         if ([messagePattern matchesInvocation:anInvocation]) {
@@ -216,15 +502,29 @@ void KWInterceptedForwardInvocation(id anObject, SEL aSelector, NSInvocation* an
             return;
     }
 
-    Class interceptClass = KWRestoreOriginalClass(anObject);
+    // The intercept class keeps the original implementation under an alias
+    // selector, so the invocation can call it without the object's class
+    // being changed under other threads. It is called with the original
+    // selector, as the direct implementations do, since implementations
+    // such as KVO setters dispatch on _cmd.
+    SEL selector = [anInvocation selector];
+    SEL originalSelector = KWOriginalSelectorForSelector(selector);
+    Class interceptClass = object_getClass(anObject);
+
+    if (class_respondsToSelector(interceptClass, originalSelector) && [anInvocation respondsToSelector:@selector(invokeUsingIMP:)]) {
+        [anInvocation invokeUsingIMP:class_getMethodImplementation(interceptClass, originalSelector)];
+        return;
+    }
+
+    // Methods the original class answers by forwarding have no alias.
+    KWRestoreOriginalClass(anObject);
     [anInvocation invoke];
     // anObject->isa = interceptClass;
     object_setClass(anObject, interceptClass);
 }
 
 void KWInterceptedDealloc(id anObject, SEL aSelector) {
-    KWClearMessageSpies(anObject);
-    KWClearObjectStubs(anObject);
+    KWClearInterceptedObject(anObject);
     KWRestoreOriginalClass(anObject);
 }
 
@@ -249,138 +549,455 @@ BOOL KWInterceptedSupportsSecureCodingFalse(id anObject, SEL aSelector) {
     return NO;
 }
 
-#pragma mark - Managing Objects Stubs
+#pragma mark - Intercept Registry
 
-void KWAssociateObjectStub(id anObject, KWStub *aStub, BOOL overrideExisting) {
-    KWObjectStubsInit();
+// The stubs, spies and journals of intercepted objects are kept in map tables
+// that are never changed once they have been published. Dispatch reads the
+// current tables through atomic properties and never waits for writers or
+// other readers. Writers serialize on KWInterceptRegistryLock, copy the
+// tables they change and publish the copies. Arrays of stubs and tables of
+// spies stored in the registry are treated as immutable in the same way.
+
+@interface KWInterceptRegistry : NSObject
+
+@property (atomic, strong) NSMapTable *objectStubs;
+@property (atomic, strong) NSMapTable *messageSpies;
+@property (atomic, strong) NSMapTable *invocationJournals;
+
+// For each stubbed or spied object, a dictionary from selector to the stub
+// that answers the selector without an invocation, or to NSNull when
+// messages with the selector need one. Selectors that are neither stubbed
+// nor spied are left out. Kept up to date with objectStubs and messageSpies
+// so that direct implementations do not have to scan them.
+@property (atomic, strong) NSMapTable *directDispatchEntries;
+
+@end
+
+@implementation KWInterceptRegistry
+
+@end
+
+static pthread_mutex_t KWInterceptRegistryLock = PTHREAD_MUTEX_INITIALIZER;
+
+static KWInterceptRegistry *KWSharedInterceptRegistry(void) {
+    static KWInterceptRegistry *registry = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        registry = [[KWInterceptRegistry alloc] init];
+    });
+    return registry;
+}
+
+// Intercepted objects are keyed by pointer identity, so they are never
+// hashed or compared, which could send them messages and loop back into the
+// intercept class. Keys are neither retained nor weakly referenced, which
+// the runtime refuses for objects that do not allow it; an object's entries
+// are removed when it is deallocated instead.
+static NSMapTable *KWInterceptRegistryMapTableCopy(NSMapTable *mapTable) {
+    if (mapTable == nil)
+        return [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsOpaqueMemory | NSPointerFunctionsObjectPointerPersonality valueOptions:NSMapTableStrongMemory];
+
+    return [mapTable copy];
+}
+
+// Returns mapTable itself when it has no entry for anObject.
+static NSMapTable *KWInterceptRegistryMapTableRemovingObject(NSMapTable *mapTable, id anObject) {
+    if ([mapTable objectForKey:anObject] == nil)
+        return mapTable;
+
+    NSMapTable *copy = [mapTable copy];
+    [copy removeObjectForKey:anObject];
+    return copy;
+}
+
+static NSMapTable *KWMessagePatternMapTableCopy(NSMapTable *mapTable) {
+    if (mapTable == nil)
+        return [NSMapTable mapTableWithKeyOptions:NSMapTableStrongMemory valueOptions:NSMapTableStrongMemory];
+
+    return [mapTable copy];
+}
+
+// Must be called with KWInterceptRegistryLock held, after the changed stubs
+// and spies of anObject have been published.
+static void KWSetDirectDispatchEntriesLocked(KWInterceptRegistry *registry, NSMapTable *directDispatchEntries, id anObject) {
+    CFMutableDictionaryRef entries = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+    NSMapTable *spies = [registry.messageSpies objectForKey:anObject];
+
+    // Spies have to see an invocation.
+    for (KWMessagePattern *messagePattern in spies) {
+        if ([[spies objectForKey:messagePattern] count] > 0)
+            CFDictionarySetValue(entries, messagePattern.selector, kCFNull);
+    }
+
+    for (KWStub *stub in [registry.objectStubs objectForKey:anObject]) {
+        SEL selector = stub.messagePattern.selector;
+
+        if (!CFDictionaryContainsKey(entries, selector))
+            CFDictionarySetValue(entries, selector, [stub canProcessMessagesWithoutInvocation] ? (__bridge const void *)stub : kCFNull);
+    }
+
+    if (CFDictionaryGetCount(entries) > 0) {
+        [directDispatchEntries setObject:CFBridgingRelease(entries) forKey:anObject];
+    } else {
+        [directDispatchEntries removeObjectForKey:anObject];
+        CFRelease(entries);
+    }
+}
+
+static void KWUpdateDirectDispatchEntriesLocked(KWInterceptRegistry *registry, id anObject) {
+    NSMapTable *directDispatchEntries = KWInterceptRegistryMapTableCopy(registry.directDispatchEntries);
+    KWSetDirectDispatchEntriesLocked(registry, directDispatchEntries, anObject);
+    registry.directDispatchEntries = directDispatchEntries;
+}
+
+static void KWUpdateAllDirectDispatchEntriesLocked(KWInterceptRegistry *registry, id<NSFastEnumeration> objects) {
+    NSMapTable *directDispatchEntries = KWInterceptRegistryMapTableCopy(registry.directDispatchEntries);
+
+    for (id anObject in objects)
+        KWSetDirectDispatchEntriesLocked(registry, directDispatchEntries, anObject);
+
+    registry.directDispatchEntries = directDispatchEntries;
+}
+
+static NSDictionary *KWDirectDispatchEntriesForObject(id anObject) {
+    return [KWSharedInterceptRegistry().directDispatchEntries objectForKey:anObject];
+}
+
+#pragma mark - Intercept Generations
+
+// Records what a generation added to the registry, so that it can be taken
+// out again without touching what other generations added.
 
-    NSMutableArray *stubs = KWObjectStubsForObject(anObject);
+@interface KWInterceptGeneration : NSObject
+
+@property (nonatomic, readonly) NSMapTable *objectStubs;
+@property (nonatomic, readonly) NSMapTable *messageSpies;
+@property (nonatomic, readonly) NSMapTable *invocationJournals;
+
+@end
+
+@implementation KWInterceptGeneration
+
+- (id)init {
+    self = [super init];
+    if (self) {
+        _objectStubs = KWInterceptRegistryMapTableCopy(nil);
+        _messageSpies = KWInterceptRegistryMapTableCopy(nil);
+        _invocationJournals = KWInterceptRegistryMapTableCopy(nil);
+    }
+    return self;
+}
+
+- (BOOL)containsStub:(KWStub *)aStub forObject:(id)anObject {
+    return [[self.objectStubs objectForKey:anObject] indexOfObjectIdenticalTo:aStub] != NSNotFound;
+}
+
+- (void)addStub:(KWStub *)aStub forObject:(id)anObject {
+    NSMutableArray *stubs = [self.objectStubs objectForKey:anObject];
     if (stubs == nil) {
-        stubs = [[NSMutableArray alloc] init];
-        KWObjectStubsSet(anObject, stubs);
+        stubs = [NSMutableArray array];
+        [self.objectStubs setObject:stubs forKey:anObject];
     }
+    [stubs addObject:aStub];
+}
+
+- (void)removeStub:(KWStub *)aStub forObject:(id)anObject {
+    [[self.objectStubs objectForKey:anObject] removeObjectIdenticalTo:aStub];
+}
+
+- (void)addSpy:(id)aSpy messagePattern:(KWMessagePattern *)aMessagePattern forObject:(id)anObject {
+    NSMutableArray *spies = [self.messageSpies objectForKey:anObject];
+    if (spies == nil) {
+        spies = [NSMutableArray array];
+        [self.messageSpies setObject:spies forKey:anObject];
+    }
+    [spies addObject:@[aMessagePattern, aSpy]];
+}
+
+- (void)addInvocationJournal:(KWInvocationJournal *)aJournal forObject:(id)anObject {
+    [self.invocationJournals setObject:aJournal forKey:anObject];
+}
+
+- (void)removeObject:(id)anObject {
+    [self.objectStubs removeObjectForKey:anObject];
+    [self.messageSpies removeObjectForKey:anObject];
+    [self.invocationJournals removeObjectForKey:anObject];
+}
+
+@end
+
+// Guarded by KWInterceptRegistryLock.
+static NSUInteger KWInterceptGenerationCount = 0;
+static NSUInteger KWInterceptCurrentGeneration = 0;
+static NSMutableDictionary *KWInterceptGenerations = nil;
+
+// Must be called with KWInterceptRegistryLock held.
+static KWInterceptGeneration *KWCurrentInterceptGenerationLocked(void) {
+    if (KWInterceptGenerations == nil)
+        KWInterceptGenerations = [[NSMutableDictionary alloc] init];
+
+    NSNumber *key = @(KWInterceptCurrentGeneration);
+    KWInterceptGeneration *generation = KWInterceptGenerations[key];
+    if (generation == nil) {
+        generation = [[KWInterceptGeneration alloc] init];
+        KWInterceptGenerations[key] = generation;
+    }
+    return generation;
+}
+
+// Must be called with KWInterceptRegistryLock held. Nothing in the registry
+// retains anObject, so it has to be taken out of every table, those of its
+// generations included, before its memory can be reused.
+static void KWForgetInterceptedObjectLocked(KWInterceptRegistry *registry, id anObject) {
+    registry.objectStubs = KWInterceptRegistryMapTableRemovingObject(registry.objectStubs, anObject);
+    registry.messageSpies = KWInterceptRegistryMapTableRemovingObject(registry.messageSpies, anObject);
+    registry.invocationJournals = KWInterceptRegistryMapTableRemovingObject(registry.invocationJournals, anObject);
+    registry.directDispatchEntries = KWInterceptRegistryMapTableRemovingObject(registry.directDispatchEntries, anObject);
+
+    for (KWInterceptGeneration *generation in [KWInterceptGenerations objectEnumerator])
+        [generation removeObject:anObject];
+}
 
+void KWClearInterceptedObject(id anObject) {
+    KWInterceptRegistry *registry = KWSharedInterceptRegistry();
+    pthread_mutex_lock(&KWInterceptRegistryLock);
+    KWForgetInterceptedObjectLocked(registry, anObject);
+    pthread_mutex_unlock(&KWInterceptRegistryLock);
+}
+
+NSUInteger KWNewInterceptGeneration(void) {
+    pthread_mutex_lock(&KWInterceptRegistryLock);
+    NSUInteger generation = ++KWInterceptGenerationCount;
+    pthread_mutex_unlock(&KWInterceptRegistryLock);
+    return generation;
+}
+
+NSUInteger KWCurrentInterceptGeneration(void) {
+    pthread_mutex_lock(&KWInterceptRegistryLock);
+    NSUInteger generation = KWInterceptCurrentGeneration;
+    pthread_mutex_unlock(&KWInterceptRegistryLock);
+    return generation;
+}
+
+void KWSetCurrentInterceptGeneration(NSUInteger generation) {
+    pthread_mutex_lock(&KWInterceptRegistryLock);
+    KWInterceptCurrentGeneration = generation;
+    pthread_mutex_unlock(&KWInterceptRegistryLock);
+}
+
+#pragma mark - Managing Objects Stubs
+
+void KWAssociateObjectStub(id anObject, KWStub *aStub, BOOL overrideExisting) {
+    KWInterceptRegistry *registry = KWSharedInterceptRegistry();
+    pthread_mutex_lock(&KWInterceptRegistryLock);
+
+    KWInterceptGeneration *generation = KWCurrentInterceptGenerationLocked();
+    NSMutableArray *stubs = [NSMutableArray arrayWithArray:[registry.objectStubs objectForKey:anObject]];
     NSUInteger stubCount = [stubs count];
+    NSUInteger stubIndex = stubCount;
+    BOOL shouldAddStub = YES;
 
     for (NSUInteger i = 0; i < stubCount; ++i) {
         KWStub *existingStub = stubs[i];
 
         if ([aStub.messagePattern isEqualToMessagePattern:existingStub.messagePattern]) {
-            if (overrideExisting) {
+            if (!overrideExisting) {
+                shouldAddStub = NO;
+            } else if ([generation containsStub:existingStub forObject:anObject]) {
+                // Stubs of this generation come before those of enclosing
+                // generations, so the replacement takes the place of the
+                // stub it replaces.
                 [stubs removeObjectAtIndex:i];
-                break;
+                [generation removeStub:existingStub forObject:anObject];
+                stubIndex = i;
             } else {
-                return;
+                // The stub belongs to an enclosing generation, such as a
+                // beforeAll block, and has to come back when this one is
+                // cleared. Shadow it instead of replacing it.
+                stubIndex = i;
             }
+
+            break;
         }
     }
 
-    [stubs addObject:aStub];
+    if (shouldAddStub) {
+        [stubs insertObject:aStub atIndex:stubIndex];
+        KWCounterIncrement(KWCounterStubsInstalled);
+        [generation addStub:aStub forObject:anObject];
+        NSMapTable *objectStubs = KWInterceptRegistryMapTableCopy(registry.objectStubs);
+        [objectStubs setObject:[stubs copy] forKey:anObject];
+        registry.objectStubs = objectStubs;
+        KWUpdateDirectDispatchEntriesLocked(registry, anObject);
+    }
+
+    pthread_mutex_unlock(&KWInterceptRegistryLock);
 }
 
 #pragma mark - Managing Message Spies
 
 void KWAssociateMessageSpy(id anObject, id aSpy, KWMessagePattern *aMessagePattern) {
-    KWMessageSpiesInit();
-
-    NSMapTable *spies = KWMessageSpiesForObject(anObject);
-    if (spies == nil) {
-        spies = [NSMapTable mapTableWithKeyOptions:NSMapTableStrongMemory valueOptions:NSMapTableStrongMemory];
-        KWMessageSpiesSet(anObject, spies);
-    }
-
-    NSMutableArray *messagePatternSpies = [spies objectForKey:aMessagePattern];
-    if (messagePatternSpies == nil) {
-        messagePatternSpies = [[NSMutableArray alloc] init];
-        [spies setObject:messagePatternSpies forKey:aMessagePattern];
+    KWInterceptRegistry *registry = KWSharedInterceptRegistry();
+    pthread_mutex_lock(&KWInterceptRegistryLock);
+
+    NSMapTable *spies = KWMessagePatternMapTableCopy([registry.messageSpies objectForKey:anObject]);
+    NSArray *messagePatternSpies = [spies objectForKey:aMessagePattern];
+
+    if (![messagePatternSpies containsObject:aSpy]) {
+        [KWCurrentInterceptGenerationLocked() addSpy:aSpy messagePattern:aMessagePattern forObject:anObject];
+        KWCounterIncrement(KWCounterSpiesInstalled);
+        [spies setObject:(messagePatternSpies != nil ? [messagePatternSpies arrayByAddingObject:aSpy] : @[aSpy]) forKey:aMessagePattern];
+        NSMapTable *messageSpies = KWInterceptRegistryMapTableCopy(registry.messageSpies);
+        [messageSpies setObject:spies forKey:anObject];
+        registry.messageSpies = messageSpies;
+        KWUpdateDirectDispatchEntriesLocked(registry, anObject);
     }
 
-
-    if ([messagePatternSpies containsObject:aSpy])
-        return;
-
-    [messagePatternSpies addObject:aSpy];
+    pthread_mutex_unlock(&KWInterceptRegistryLock);
 }
 
 #pragma mark - KWMessageSpies
 
-static NSMapTable *KWMessageSpies = nil;
-
-void KWMessageSpiesInit(void) {
-    if (KWMessageSpies == nil) {
-        KWMessageSpies = [NSMapTable mapTableWithKeyOptions:NSMapTableStrongMemory valueOptions:NSMapTableStrongMemory];
-    };
-}
-
 NSMapTable *KWMessageSpiesForObject(id anObject) {
-    return [KWMessageSpies objectForKey:KWInterceptedObjectKey(anObject)];
-}
-
-void KWMessageSpiesSet(id anObject, NSMapTable *spies) {
-    [KWMessageSpies setObject:spies forKey:KWInterceptedObjectKey(anObject)];
+    return [KWSharedInterceptRegistry().messageSpies objectForKey:anObject];
 }
 
 void KWClearObjectSpy(id anObject, id aSpy, KWMessagePattern *aMessagePattern) {
-    NSMapTable *spyArrayDictionary = KWMessageSpiesForObject(anObject);
-    NSMutableArray *spies = [spyArrayDictionary objectForKey:aMessagePattern];
-    [spies removeObject:aSpy];
+    KWInterceptRegistry *registry = KWSharedInterceptRegistry();
+    pthread_mutex_lock(&KWInterceptRegistryLock);
+
+    NSMapTable *spies = [registry.messageSpies objectForKey:anObject];
+    NSArray *messagePatternSpies = [spies objectForKey:aMessagePattern];
+
+    if ([messagePatternSpies containsObject:aSpy]) {
+        NSMutableArray *remainingSpies = [messagePatternSpies mutableCopy];
+        [remainingSpies removeObject:aSpy];
+        spies = KWMessagePatternMapTableCopy(spies);
+        [spies setObject:[remainingSpies copy] forKey:aMessagePattern];
+        NSMapTable *messageSpies = KWInterceptRegistryMapTableCopy(registry.messageSpies);
+        [messageSpies setObject:spies forKey:anObject];
+        registry.messageSpies = messageSpies;
+        KWUpdateDirectDispatchEntriesLocked(registry, anObject);
+    }
+
+    pthread_mutex_unlock(&KWInterceptRegistryLock);
 }
 
 void KWClearMessageSpies(id anObject) {
-    [KWMessageSpies removeObjectForKey:KWInterceptedObjectKey(anObject)];
+    KWInterceptRegistry *registry = KWSharedInterceptRegistry();
+    pthread_mutex_lock(&KWInterceptRegistryLock);
+    NSMapTable *messageSpies = KWInterceptRegistryMapTableCopy(registry.messageSpies);
+    [messageSpies removeObjectForKey:anObject];
+    registry.messageSpies = messageSpies;
+    KWUpdateDirectDispatchEntriesLocked(registry, anObject);
+    pthread_mutex_unlock(&KWInterceptRegistryLock);
 }
 
 void KWClearAllMessageSpies(void) {
-    for (KWInterceptedObjectBlock key in KWMessageSpies) {
-        id spiedObject = key();
+    KWInterceptRegistry *registry = KWSharedInterceptRegistry();
+    pthread_mutex_lock(&KWInterceptRegistryLock);
+    NSMapTable *messageSpies = registry.messageSpies;
+    registry.messageSpies = nil;
+    KWUpdateAllDirectDispatchEntriesLocked(registry, messageSpies);
+    pthread_mutex_unlock(&KWInterceptRegistryLock);
+
+    for (id spiedObject in messageSpies) {
         if (KWObjectClassRestored(spiedObject)) {
             continue;
         }
         KWRestoreOriginalClass(spiedObject);
     }
-    [KWMessageSpies removeAllObjects];
 }
 
+#pragma mark KWInvocationJournals
 
-#pragma mark KWObjectStubs
+KWInvocationJournal *KWObjectInvocationJournal(id anObject) {
+    KWInterceptRegistry *registry = KWSharedInterceptRegistry();
+    pthread_mutex_lock(&KWInterceptRegistryLock);
 
-static NSMapTable *KWObjectStubs = nil;
-
-void KWObjectStubsInit(void) {
-    if (KWObjectStubs == nil) {
-        KWObjectStubs = [NSMapTable mapTableWithKeyOptions:NSMapTableStrongMemory valueOptions:NSMapTableStrongMemory];
+    KWInvocationJournal *journal = [registry.invocationJournals objectForKey:anObject];
+    if (journal == nil) {
+        journal = [[KWInvocationJournal alloc] init];
+        [KWCurrentInterceptGenerationLocked() addInvocationJournal:journal forObject:anObject];
+        NSMapTable *invocationJournals = KWInterceptRegistryMapTableCopy(registry.invocationJournals);
+        [invocationJournals setObject:journal forKey:anObject];
+        registry.invocationJournals = invocationJournals;
     }
+
+    pthread_mutex_unlock(&KWInterceptRegistryLock);
+    return journal;
+}
+
+KWInvocationJournal *KWInvocationJournalForObject(id anObject) {
+    NSMapTable *invocationJournals = KWSharedInterceptRegistry().invocationJournals;
+    if (invocationJournals == nil)
+        return nil;
+
+    return [invocationJournals objectForKey:anObject];
+}
+
+void KWClearInvocationJournal(id anObject) {
+    KWInterceptRegistry *registry = KWSharedInterceptRegistry();
+    pthread_mutex_lock(&KWInterceptRegistryLock);
+    NSMapTable *invocationJournals = KWInterceptRegistryMapTableCopy(registry.invocationJournals);
+    [invocationJournals removeObjectForKey:anObject];
+    registry.invocationJournals = invocationJournals;
+    pthread_mutex_unlock(&KWInterceptRegistryLock);
 }
 
-NSMutableArray *KWObjectStubsForObject(id anObject) {
-    return [KWObjectStubs objectForKey:KWInterceptedObjectKey(anObject)];
+void KWClearAllInvocationJournals(void) {
+    KWInterceptRegistry *registry = KWSharedInterceptRegistry();
+    pthread_mutex_lock(&KWInterceptRegistryLock);
+    NSMapTable *invocationJournals = registry.invocationJournals;
+    registry.invocationJournals = nil;
+    pthread_mutex_unlock(&KWInterceptRegistryLock);
+
+    for (id journaledObject in invocationJournals) {
+        if (KWObjectClassRestored(journaledObject)) {
+            continue;
+        }
+        KWRestoreOriginalClass(journaledObject);
+    }
 }
 
-void KWObjectStubsSet(id anObject, NSMutableArray *stubs) {
-    [KWObjectStubs setObject:stubs forKey:KWInterceptedObjectKey(anObject)];
+#pragma mark KWObjectStubs
+
+NSArray *KWObjectStubsForObject(id anObject) {
+    return [KWSharedInterceptRegistry().objectStubs objectForKey:anObject];
 }
 
 void KWClearObjectStubs(id anObject) {
-    [KWObjectStubs removeObjectForKey:KWInterceptedObjectKey(anObject)];
+    KWInterceptRegistry *registry = KWSharedInterceptRegistry();
+    pthread_mutex_lock(&KWInterceptRegistryLock);
+    NSMapTable *objectStubs = KWInterceptRegistryMapTableCopy(registry.objectStubs);
+    [objectStubs removeObjectForKey:anObject];
+    registry.objectStubs = objectStubs;
+    KWUpdateDirectDispatchEntriesLocked(registry, anObject);
+    pthread_mutex_unlock(&KWInterceptRegistryLock);
 }
 
 void KWClearAllObjectStubs(void) {
-    for (KWInterceptedObjectBlock key in KWObjectStubs) {
-        id stubbedObject = key();
+    KWInterceptRegistry *registry = KWSharedInterceptRegistry();
+    pthread_mutex_lock(&KWInterceptRegistryLock);
+    NSMapTable *objectStubs = registry.objectStubs;
+    registry.objectStubs = nil;
+    KWUpdateAllDirectDispatchEntriesLocked(registry, objectStubs);
+    pthread_mutex_unlock(&KWInterceptRegistryLock);
+
+    for (id stubbedObject in objectStubs) {
         if (KWObjectClassRestored(stubbedObject)) {
             continue;
         }
         KWRestoreOriginalClass(stubbedObject);
     }
-    [KWObjectStubs removeAllObjects];
 }
 
 #pragma mark KWRestoredObjects
 
-static NSMutableArray *KWRestoredObjects = nil;
+static NSHashTable *KWRestoredObjects = nil;
 
 BOOL KWObjectClassRestored(id anObject) {
-    return [KWRestoredObjects containsObject:KWInterceptedObjectKey(anObject)];
+    return [KWRestoredObjects containsObject:anObject];
 }
 
 Class KWRestoreOriginalClass(id anObject) {
@@ -395,25 +1012,105 @@ Class KWRestoreOriginalClass(id anObject) {
     return interceptClass;
 }
 
-#pragma mark KWInterceptedObjectKey
-
-static void *kKWInterceptedObjectKey = &kKWInterceptedObjectKey;
-
-KWInterceptedObjectBlock KWInterceptedObjectKey(id anObject) {
-    KWInterceptedObjectBlock key = objc_getAssociatedObject(anObject, kKWInterceptedObjectKey);
-    if (key == nil) {
-        __weak id weakobj = anObject;
-        key = ^{ return weakobj; };
-        objc_setAssociatedObject(anObject, kKWInterceptedObjectKey, [key copy], OBJC_ASSOCIATION_COPY);
-    }
-    return key;
-}
-
 #pragma mark - Managing Stubs & Spies
 
 void KWClearStubsAndSpies(void) {
-    KWRestoredObjects = [NSMutableArray array];
+    pthread_mutex_lock(&KWInterceptRegistryLock);
+    [KWInterceptGenerations removeAllObjects];
+    pthread_mutex_unlock(&KWInterceptRegistryLock);
+
+    KWRestoredObjects = [NSHashTable hashTableWithOptions:NSPointerFunctionsOpaqueMemory | NSPointerFunctionsObjectPointerPersonality];
     KWClearAllMessageSpies();
+    KWClearAllInvocationJournals();
     KWClearAllObjectStubs();
     KWRestoredObjects = nil;
 }
+
+#pragma mark - Scoping Stubs & Spies
+
+void KWClearStubsAndSpiesOfGeneration(NSUInteger generationNumber) {
+    KWInterceptRegistry *registry = KWSharedInterceptRegistry();
+    NSHashTable *clearedObjects = [NSHashTable hashTableWithOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality];
+    NSMutableArray *restoredObjects = [NSMutableArray array];
+    pthread_mutex_lock(&KWInterceptRegistryLock);
+
+    NSNumber *key = @(generationNumber);
+    KWInterceptGeneration *generation = KWInterceptGenerations[key];
+    [KWInterceptGenerations removeObjectForKey:key];
+
+    if ([generation.objectStubs count] > 0) {
+        NSMapTable *objectStubs = KWInterceptRegistryMapTableCopy(registry.objectStubs);
+
+        for (id stubbedObject in generation.objectStubs) {
+            NSMutableArray *stubs = [NSMutableArray arrayWithArray:[objectStubs objectForKey:stubbedObject]];
+            for (KWStub *stub in [generation.objectStubs objectForKey:stubbedObject])
+                [stubs removeObjectIdenticalTo:stub];
+
+            if ([stubs count] > 0)
+                [objectStubs setObject:[stubs copy] forKey:stubbedObject];
+            else
+                [objectStubs removeObjectForKey:stubbedObject];
+
+            [clearedObjects addObject:stubbedObject];
+        }
+
+        registry.objectStubs = objectStubs;
+    }
+
+    if ([generation.messageSpies count] > 0) {
+        NSMapTable *messageSpies = KWInterceptRegistryMapTableCopy(registry.messageSpies);
+
+        for (id spiedObject in generation.messageSpies) {
+            NSMapTable *spies = KWMessagePatternMapTableCopy([messageSpies objectForKey:spiedObject]);
+
+            for (NSArray *record in [generation.messageSpies objectForKey:spiedObject]) {
+                NSMutableArray *messagePatternSpies = [NSMutableArray arrayWithArray:[spies objectForKey:record[0]]];
+                [messagePatternSpies removeObjectIdenticalTo:record[1]];
+
+                if ([messagePatternSpies count] > 0)
+                    [spies setObject:[messagePatternSpies copy] forKey:record[0]];
+                else
+                    [spies removeObjectForKey:record[0]];
+            }
+
+            if ([spies count] > 0)
+                [messageSpies setObject:spies forKey:spiedObject];
+            else
+                [messageSpies removeObjectForKey:spiedObject];
+
+            [clearedObjects addObject:spiedObject];
+        }
+
+        registry.messageSpies = messageSpies;
+    }
+
+    if ([generation.invocationJournals count] > 0) {
+        NSMapTable *invocationJournals = KWInterceptRegistryMapTableCopy(registry.invocationJournals);
+
+        for (id journaledObject in generation.invocationJournals) {
+            if ([invocationJournals objectForKey:journaledObject] == [generation.invocationJournals objectForKey:journaledObject])
+                [invocationJournals removeObjectForKey:journaledObject];
+
+            [clearedObjects addObject:journaledObject];
+        }
+
+        registry.invocationJournals = invocationJournals;
+    }
+
+    if ([generation.objectStubs count] > 0 || [generation.messageSpies count] > 0)
+        KWUpdateAllDirectDispatchEntriesLocked(registry, clearedObjects);
+
+    // Objects that are restored no longer go through KWInterceptedDealloc,
+    // so records other generations still hold for them are dropped now.
+    for (id clearedObject in clearedObjects) {
+        if ([registry.objectStubs objectForKey:clearedObject] == nil && [registry.messageSpies objectForKey:clearedObject] == nil && [registry.invocationJournals objectForKey:clearedObject] == nil) {
+            KWForgetInterceptedObjectLocked(registry, clearedObject);
+            [restoredObjects addObject:clearedObject];
+        }
+    }
+
+    pthread_mutex_unlock(&KWInterceptRegistryLock);
+
+    for (id restoredObject in restoredObjects)
+        KWRestoreOriginalClass(restoredObject);
+}
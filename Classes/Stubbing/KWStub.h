@@ -17,10 +17,18 @@
 - (id)initWithMessagePattern:(KWMessagePattern *)aMessagePattern block:(id (^)(NSArray *params))aBlock;
 - (id)initWithMessagePattern:(KWMessagePattern *)aMessagePattern value:(id)aValue times:(id)times afterThatReturn:(id)aSecondValue;
 
+// A typed block has the same return type as the stubbed method and takes the
+// receiver followed by the method's arguments, e.g.
+// ^NSUInteger(Cruiser *cruiser, NSUInteger index) for -energyLevelInWarpCore:.
+// Its signature is checked against aSignature here, and it is then called
+// with the invocation's arguments as they are, without boxing.
+- (id)initWithMessagePattern:(KWMessagePattern *)aMessagePattern typedBlock:(id)aBlock methodSignature:(NSMethodSignature *)aSignature;
+
 + (id)stubWithMessagePattern:(KWMessagePattern *)aMessagePattern;
 + (id)stubWithMessagePattern:(KWMessagePattern *)aMessagePattern value:(id)aValue;
 + (id)stubWithMessagePattern:(KWMessagePattern *)aMessagePattern block:(id (^)(NSArray *params))aBlock;
 + (id)stubWithMessagePattern:(KWMessagePattern *)aMessagePattern value:(id)aValue times:(id)times afterThatReturn:(id)aSecondValue;
++ (id)stubWithMessagePattern:(KWMessagePattern *)aMessagePattern typedBlock:(id)aBlock methodSignature:(NSMethodSignature *)aSignature;
 
 #pragma mark - Properties
 
@@ -30,8 +38,23 @@
 @property (nonatomic, readonly) int returnedValueTimes;
 @property (nonatomic, readonly) id secondValue;
 
+// An implementation made from the typed block, which takes the receiver and
+// arguments just as the stubbed method does. NULL unless the stub has a
+// typed block.
+@property (nonatomic, readonly) IMP typedBlockImplementation;
+
 #pragma mark - Processing Invocations
 
 - (BOOL)processInvocation:(NSInvocation *)anInvocation;
 
+#pragma mark - Processing Messages Without Invocations
+
+// Stubs without argument filters or untyped blocks do not need to look at
+// the invocation at all; intercepted methods use this to answer directly.
+// Typed block stubs are answered by calling typedBlockImplementation and
+// then telling the stub what the block returned.
+- (BOOL)canProcessMessagesWithoutInvocation;
+- (void)writeReturnValue:(void *)buffer forSelector:(SEL)aSelector objCType:(const char *)returnType;
+- (void)typedBlockDidReturnValue:(const void *)buffer objCType:(const char *)returnType;
+
 @end
@@ -5,18 +5,77 @@
 //
 
 #import "KWStub.h"
+#import <objc/runtime.h>
 #import "KWMessagePattern.h"
 #import "KWObjCUtilities.h"
 #import "KWStringUtilities.h"
 #import "KWValue.h"
 
 #import "NSInvocation+OCMAdditions.h"
+#import "NSMethodSignature+KiwiAdditions.h"
+
+// The bytes a wrapped value resolves to for one return type. A payload is
+// never changed once it has been created, so concurrent calls can share it.
+// Its type is the interned encoding of a KWObjCTypeDescriptor, since the
+// method signature the return type came from may not outlive the payload.
+@interface KWStubReturnPayload : NSObject
+
+- (id)initWithObjCType:(const char *)anObjCType value:(id)aValue valueData:(NSData *)aValueData secondValueData:(NSData *)aSecondValueData;
+
+@property (nonatomic, readonly) const char *objCType;
+@property (nonatomic, readonly) id value;
+@property (nonatomic, readonly) NSData *valueData;
+@property (nonatomic, readonly) NSData *secondValueData;
+
+@end
+
+@implementation KWStubReturnPayload
+
+- (id)initWithObjCType:(const char *)anObjCType value:(id)aValue valueData:(NSData *)aValueData secondValueData:(NSData *)aSecondValueData {
+    self = [super init];
+    if (self) {
+        _objCType = anObjCType;
+        _value = aValue;
+        _valueData = aValueData;
+        _secondValueData = aSecondValueData;
+    }
+    return self;
+}
+
+@end
+
+@interface NSInvocation (KWStubPrivate)
+
+- (void)invokeUsingIMP:(IMP)anImplementation;
+
+@end
+
+static BOOL KWSelectorReturnsRetainedObject(SEL aSelector) {
+    NSString *selectorString = NSStringFromSelector(aSelector);
+
+    // To conform to memory management conventions, retain if writing a
+    // result that begins with alloc, new or contains copy.
+    return KWStringHasWordPrefix(selectorString, @"alloc") ||
+           KWStringHasWordPrefix(selectorString, @"new") ||
+           KWStringHasWord(selectorString, @"copy") ||
+           KWStringHasWord(selectorString, @"Copy");
+}
 
 @interface KWStub(){}
 @property (nonatomic, copy) id (^block)(NSArray *params);
+@property (nonatomic, copy) id typedBlock;
+@property (nonatomic, strong) NSMethodSignature *typedBlockSignature;
+
+// Stubbed methods may be called from several threads at once. The payload is
+// published through an atomic property, and everything else a call changes is
+// updated with atomic operations.
+@property (atomic, strong) KWStubReturnPayload *returnPayload;
 @end
 
-@implementation KWStub
+@implementation KWStub {
+    int _returnValueTimesThreshold;
+    BOOL _returnsRetainedObject;
+}
 
 #pragma mark - Initializing
 
@@ -29,6 +88,7 @@
     if (self) {
         messagePattern = aMessagePattern;
         value = aValue;
+        _returnsRetainedObject = KWSelectorReturnsRetainedObject(aMessagePattern.selector);
     }
     return self;
 }
@@ -38,6 +98,7 @@
     if (self) {
         messagePattern = aMessagePattern;
         _block = aBlock;
+        _returnsRetainedObject = KWSelectorReturnsRetainedObject(aMessagePattern.selector);
     }
     return self;
 }
@@ -49,10 +110,39 @@
         value = aValue;
         returnValueTimes = times;
         secondValue = aSecondValue;
+        _returnValueTimesThreshold = [times intValue];
+        _returnsRetainedObject = KWSelectorReturnsRetainedObject(aMessagePattern.selector);
     }
     return self;
 }
 
+- (id)initWithMessagePattern:(KWMessagePattern *)aMessagePattern typedBlock:(id)aBlock methodSignature:(NSMethodSignature *)aSignature {
+    NSMethodSignature *blockSignature = [NSMethodSignature signatureWithBlock:aBlock];
+
+    if (blockSignature == nil || ![aSignature isCompatibleWithBlockSignature:blockSignature]) {
+        [NSException raise:@"KWStubException" format:@"cannot stub -%@ with a typed block because the block does not return %s and take the receiver followed by the method arguments",
+                                                     NSStringFromSelector(aMessagePattern.selector),
+                                                     [aSignature methodReturnType]];
+    }
+
+    self = [super init];
+    if (self) {
+        messagePattern = aMessagePattern;
+        _typedBlock = [aBlock copy];
+        _typedBlockSignature = blockSignature;
+        // The block takes the receiver where a method takes self, so an
+        // implementation made from it can be called like the method itself.
+        _typedBlockImplementation = imp_implementationWithBlock(_typedBlock);
+        _returnsRetainedObject = KWSelectorReturnsRetainedObject(aMessagePattern.selector);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    if (_typedBlockImplementation != NULL)
+        imp_removeBlock(_typedBlockImplementation);
+}
+
 + (id)stubWithMessagePattern:(KWMessagePattern *)aMessagePattern {
     return [self stubWithMessagePattern:aMessagePattern value:nil];
 }
@@ -69,6 +159,10 @@
     return [[self alloc] initWithMessagePattern:aMessagePattern value:aValue times:times afterThatReturn:aSecondValue];
 }
 
++ (id)stubWithMessagePattern:(KWMessagePattern *)aMessagePattern typedBlock:(id)aBlock methodSignature:(NSMethodSignature *)aSignature {
+    return [[self alloc] initWithMessagePattern:aMessagePattern typedBlock:aBlock methodSignature:aSignature];
+}
+
 #pragma mark - Properties
 
 @synthesize messagePattern;
@@ -76,6 +170,7 @@
 @synthesize secondValue;
 @synthesize returnValueTimes;
 @synthesize returnedValueTimes;
+@synthesize typedBlockImplementation = _typedBlockImplementation;
 
 #pragma mark - Processing Invocations
 
@@ -91,89 +186,142 @@
     free(bytes);
 }
 
-- (NSData *)valueDataWithObjCType:(const char *)objCType {
-    assert(self.value && "self.value must not be nil");
-    NSData *data = [self.value dataForObjCType:objCType];
+- (NSData *)dataForValue:(KWValue *)aValue objCType:(const char *)objCType {
+    // When the return type is not the same as the type of the wrapped value,
+    // attempt to convert the wrapped value to the desired type.
+    if (KWObjCTypeEqualToObjCType([aValue objCType], objCType))
+        return [aValue dataValue];
+
+    NSData *data = [aValue dataForObjCType:objCType];
 
     if (data == nil) {
         [NSException raise:@"KWStubException" format:@"wrapped stub value type (%s) could not be converted to the target type (%s)",
-                                                     [self.value objCType],
+                                                     [aValue objCType],
                                                      objCType];
     }
 
     return data;
 }
 
-- (void)writeWrappedValueToInvocationReturnValue:(NSInvocation *)anInvocation {
-    assert(self.value && "self.value must not be nil");
-    const char *returnType = [[anInvocation methodSignature] methodReturnType];
-    NSData *data = nil;
+- (KWStubReturnPayload *)returnPayloadForValue:(KWValue *)aValue objCType:(const char *)returnType {
+    // Block stubs return a new value on every call, so the value is part of
+    // the cache key along with the return type.
+    const char *internedReturnType = KWObjCTypeDescriptorForObjCType(returnType)->objCType;
+    KWStubReturnPayload *payload = self.returnPayload;
 
-    NSData *choosedForData = [self.value dataValue];
+    if (payload != nil && payload.value == aValue && payload.objCType == internedReturnType)
+        return payload;
 
-    if (returnValueTimes != nil) {
-        NSString *returnValueTimesString = returnValueTimes;
-        int returnValueTimesInt = [returnValueTimesString intValue];
-        
-        if (returnedValueTimes >= returnValueTimesInt) {
-            choosedForData = [self.secondValue dataValue];
-        }
-        returnedValueTimes++;
-    }
+    NSData *valueData = [self dataForValue:aValue objCType:returnType];
+    NSData *secondValueData = nil;
 
-    
-    // When the return type is not the same as the type of the wrapped value,
-    // attempt to convert the wrapped value to the desired type.
+    if (self.returnValueTimes != nil && [self.secondValue isKindOfClass:[KWValue class]])
+        secondValueData = [self dataForValue:self.secondValue objCType:returnType];
+
+    payload = [[KWStubReturnPayload alloc] initWithObjCType:internedReturnType value:aValue valueData:valueData secondValueData:secondValueData];
+    self.returnPayload = payload;
+    return payload;
+}
 
-    if (KWObjCTypeEqualToObjCType([self.value objCType], returnType))
-        data = choosedForData;
+- (BOOL)shouldReturnSecondValue {
+    if (returnValueTimes == nil)
+        return NO;
+
+    return __sync_fetch_and_add(&returnedValueTimes, 1) >= _returnValueTimesThreshold;
+}
+
+- (void)retainReturnedObject:(id)anObject {
+#ifndef __clang_analyzer__
+    // This shows up as a false positive in clang due to the runtime
+    // conditional, so ignore it.
+    if (!_returnsRetainedObject || anObject == nil)
+        return;
+
+    // NOTE: this should be done in a better way.
+    // If you don't understand it, it's basically just a -performSelector: call
+    // Currently, I'm rather doing this than suppressing the warnings with #pragma
+    SEL selector = NSSelectorFromString(@"retain");
+    ((void (*)(id, SEL))[anObject methodForSelector:selector])(anObject, selector);
+#endif
+}
+
+- (void)writeWrappedValue:(KWValue *)aValue toInvocationReturnValue:(NSInvocation *)anInvocation {
+    assert(aValue && "aValue must not be nil");
+    KWStubReturnPayload *payload = [self returnPayloadForValue:aValue objCType:[[anInvocation methodSignature] methodReturnType]];
+    NSData *data = [self shouldReturnSecondValue] ? payload.secondValueData : payload.valueData;
+
+    if (data == nil)
+        [self writeZerosToInvocationReturnValue:anInvocation];
     else
-        data = [self valueDataWithObjCType:returnType];
-
-    [anInvocation setReturnValue:(void *)[data bytes]];
-}
-
-- (void)writeObjectValueToInvocationReturnValue:(NSInvocation *)anInvocation {
-    assert(self.value && "self.value must not be nil");
-    
-    void *choosedForData = &value;
-    
-    if (returnValueTimes != nil) {
-        NSString *returnValueTimesString = returnValueTimes;
-        int returnValueTimesInt = [returnValueTimesString intValue];
-        
-        if (returnedValueTimes >= returnValueTimesInt) {
-            choosedForData = &secondValue;
-        }
-        returnedValueTimes++;
+        [anInvocation setReturnValue:(void *)[data bytes]];
+}
+
+- (void)writeObjectValue:(id)aValue toInvocationReturnValue:(NSInvocation *)anInvocation {
+    assert(aValue && "aValue must not be nil");
+    __unsafe_unretained id result = [self shouldReturnSecondValue] ? self.secondValue : aValue;
+    [anInvocation setReturnValue:&result];
+    [self retainReturnedObject:result];
+}
+
+- (void)invokeTypedBlockWithBlockInvocation:(NSInvocation *)anInvocation {
+    // Only used where NSInvocation cannot call an implementation of our
+    // choosing; the arguments are copied into an invocation of the block.
+    NSMethodSignature *signature = [anInvocation methodSignature];
+    NSInvocation *blockInvocation = [NSInvocation invocationWithMethodSignature:self.typedBlockSignature];
+    NSUInteger numberOfArguments = [signature numberOfArguments];
+    NSUInteger bufferLength = MAX([signature frameLength], [signature methodReturnLength]);
+    char stackBuffer[256] __attribute__((aligned(16)));
+    void *buffer = bufferLength <= sizeof(stackBuffer) ? stackBuffer : malloc(bufferLength);
+
+    __unsafe_unretained id target = [anInvocation target];
+    [blockInvocation setArgument:&target atIndex:1];
+
+    for (NSUInteger i = 2; i < numberOfArguments; ++i) {
+        [anInvocation getArgument:buffer atIndex:i];
+        [blockInvocation setArgument:buffer atIndex:i];
     }
 
-    [anInvocation setReturnValue:choosedForData];
+    [blockInvocation invokeWithTarget:self.typedBlock];
 
-#ifndef __clang_analyzer__
-    NSString *selectorString = NSStringFromSelector([anInvocation selector]);
-
-    // To conform to memory management conventions, retain if writing a result
-    // that begins with alloc, new or contains copy. This shows up as a false
-    // positive in clang due to the runtime conditional, so ignore it.
-    if (KWStringHasWordPrefix(selectorString, @"alloc") ||
-        KWStringHasWordPrefix(selectorString, @"new") ||
-        KWStringHasWord(selectorString, @"copy") ||
-        KWStringHasWord(selectorString, @"Copy")) {
-
-        // NOTE: this should be done in a better way.
-        // If you don't understand it, it's basically just a -performSelector: call
-        // Currently, I'm rather doing this than suppressing the warnings with #pragma
-        SEL selector = NSSelectorFromString(@"retain");
-        ((void (*)(id, SEL))[self.value methodForSelector:selector])(self.value, selector);
+    if ([signature methodReturnLength] > 0) {
+        [blockInvocation getReturnValue:buffer];
+        [anInvocation setReturnValue:buffer];
+    }
+
+    if (buffer != stackBuffer)
+        free(buffer);
+}
+
+- (void)invokeTypedBlockWithInvocation:(NSInvocation *)anInvocation {
+    NSMethodSignature *signature = [anInvocation methodSignature];
+
+    // The invocation already holds the receiver and arguments the block
+    // takes, so it can call the block's implementation as it is.
+    if ([anInvocation respondsToSelector:@selector(invokeUsingIMP:)])
+        [anInvocation invokeUsingIMP:self.typedBlockImplementation];
+    else
+        [self invokeTypedBlockWithBlockInvocation:anInvocation];
+
+    if (KWObjCTypeIsObject([signature methodReturnType])) {
+        __unsafe_unretained id result = nil;
+        [anInvocation getReturnValue:&result];
+        [self retainReturnedObject:result];
     }
-#endif
 }
 
 - (BOOL)processInvocation:(NSInvocation *)anInvocation {
     if (![self.messagePattern matchesInvocation:anInvocation])
         return NO;
-	
+
+    if (self.typedBlock) {
+        [self invokeTypedBlockWithInvocation:anInvocation];
+        return YES;
+    }
+
+    // The block's result is only returned from this call; it is not stored
+    // on the stub, which other threads may be using at the same time.
+    id returnValue = self.value;
+
 	if (self.block) {
 		NSUInteger numberOfArguments = [[anInvocation methodSignature] numberOfArguments];
 		NSMutableArray *args = [NSMutableArray arrayWithCapacity:(numberOfArguments-2)];
@@ -189,24 +337,50 @@
 			[args addObject:arg];
 		}
 		
-		id newValue = self.block(args);
-		if (newValue != value) {
-			value = newValue;
-		}
+		returnValue = self.block(args);
 		
 		[args removeAllObjects]; // We don't want these objects to be in autorelease pool
 	}
 
-    if (self.value == nil)
+    if (returnValue == nil)
         [self writeZerosToInvocationReturnValue:anInvocation];
-    else if ([self.value isKindOfClass:[KWValue class]])
-        [self writeWrappedValueToInvocationReturnValue:anInvocation];
+    else if ([returnValue isKindOfClass:[KWValue class]])
+        [self writeWrappedValue:returnValue toInvocationReturnValue:anInvocation];
     else
-        [self writeObjectValueToInvocationReturnValue:anInvocation];
+        [self writeObjectValue:returnValue toInvocationReturnValue:anInvocation];
 
     return YES;
 }
 
+#pragma mark - Processing Messages Without Invocations
+
+- (BOOL)canProcessMessagesWithoutInvocation {
+    return self.messagePattern.argumentFilters == nil && self.block == nil;
+}
+
+- (void)typedBlockDidReturnValue:(const void *)buffer objCType:(const char *)returnType {
+    if (KWObjCTypeIsObject(returnType))
+        [self retainReturnedObject:*(__unsafe_unretained id *)buffer];
+}
+
+- (void)writeReturnValue:(void *)buffer forSelector:(SEL)aSelector objCType:(const char *)returnType {
+    if (self.value == nil) {
+        memset(buffer, 0, KWObjCTypeLength(returnType));
+    } else if ([self.value isKindOfClass:[KWValue class]]) {
+        KWStubReturnPayload *payload = [self returnPayloadForValue:self.value objCType:returnType];
+        NSData *data = [self shouldReturnSecondValue] ? payload.secondValueData : payload.valueData;
+
+        if (data == nil)
+            memset(buffer, 0, KWObjCTypeLength(returnType));
+        else
+            memcpy(buffer, [data bytes], [data length]);
+    } else {
+        __unsafe_unretained id result = [self shouldReturnSecondValue] ? self.secondValue : self.value;
+        memcpy(buffer, &result, sizeof(id));
+        [self retainReturnedObject:result];
+    }
+}
+
 #pragma mark - Debugging
 
 - (NSString *)description {
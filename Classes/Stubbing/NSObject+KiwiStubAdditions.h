@@ -7,6 +7,7 @@
 #import "KiwiConfiguration.h"
 
 @class KWCaptureSpy;
+@class KWInvocationJournal;
 @class KWMessagePattern;
 
 @protocol KWMessageSpying;
@@ -17,6 +18,7 @@
 
 - (void)stub:(SEL)aSelector;
 - (void)stub:(SEL)aSelector withBlock:(id (^)(NSArray *params))block;
+- (void)stub:(SEL)aSelector withTypedBlock:(id)block;
 - (void)stub:(SEL)aSelector withArguments:(id)firstArgument, ...;
 - (void)stub:(SEL)aSelector andReturn:(id)aValue;
 - (void)stub:(SEL)aSelector andReturn:(id)aValue withArguments:(id)firstArgument, ...;
@@ -24,6 +26,7 @@
 
 + (void)stub:(SEL)aSelector;
 + (void)stub:(SEL)aSelector withBlock:(id (^)(NSArray *params))block;
++ (void)stub:(SEL)aSelector withTypedBlock:(id)block;
 + (void)stub:(SEL)aSelector withArguments:(id)firstArgument, ...;
 + (void)stub:(SEL)aSelector andReturn:(id)aValue;
 + (void)stub:(SEL)aSelector andReturn:(id)aValue withArguments:(id)firstArgument, ...;
@@ -34,11 +37,13 @@
 - (void)stubMessagePattern:(KWMessagePattern *)aMessagePattern andReturn:(id)aValue overrideExisting:(BOOL)overrideExisting;
 - (void)stubMessagePattern:(KWMessagePattern *)aMessagePattern andReturn:(id)aValue times:(id)times afterThatReturn:(id)aSecondValue;
 - (void)stubMessagePattern:(KWMessagePattern *)aMessagePattern withBlock:(id (^)(NSArray *params))block;
+- (void)stubMessagePattern:(KWMessagePattern *)aMessagePattern withTypedBlock:(id)block;
 
 // These methods will become private
 + (void)stubMessagePattern:(KWMessagePattern *)aMessagePattern andReturn:(id)aValue;
 + (void)stubMessagePattern:(KWMessagePattern *)aMessagePattern andReturn:(id)aValue times:(id)times afterThatReturn:(id)aSecondValue;
 + (void)stubMessagePattern:(KWMessagePattern *)aMessagePattern withBlock:(id (^)(NSArray *params))block;
++ (void)stubMessagePattern:(KWMessagePattern *)aMessagePattern withTypedBlock:(id)block;
 
 - (void)clearStubs;
 
@@ -50,6 +55,14 @@
 + (void)addMessageSpy:(id<KWMessageSpying>)aSpy forMessagePattern:(KWMessagePattern *)aMessagePattern;
 + (void)removeMessageSpy:(id<KWMessageSpying>)aSpy forMessagePattern:(KWMessagePattern *)aMessagePattern;
 
+#pragma mark - Journaling Messages
+
+// Makes sure messages matching the selector of aMessagePattern are recorded,
+// and returns the journal they are recorded in.
+- (KWInvocationJournal *)invocationJournalForMessagePattern:(KWMessagePattern *)aMessagePattern;
+
++ (KWInvocationJournal *)invocationJournalForMessagePattern:(KWMessagePattern *)aMessagePattern;
+
 @end
 
 @interface NSObject(KiwiStubAdditions) <KiwiStubAdditions>
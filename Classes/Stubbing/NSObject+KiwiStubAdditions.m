@@ -55,6 +55,11 @@ static NSString * const ChangeStubValueAfterTimesKey = @"ChangeStubValueAfterTim
     [self stubMessagePattern:messagePattern withBlock:block];
 }
 
+- (void)stub:(SEL)aSelector withTypedBlock:(id)block {
+    KWMessagePattern *messagePattern = [KWMessagePattern messagePatternWithSelector:aSelector];
+    [self stubMessagePattern:messagePattern withTypedBlock:block];
+}
+
 - (void)stub:(SEL)aSelector withArguments:(id)firstArgument, ... {
     va_list argumentList;
     va_start(argumentList, firstArgument);
@@ -89,6 +94,11 @@ static NSString * const ChangeStubValueAfterTimesKey = @"ChangeStubValueAfterTim
     [self stubMessagePattern:messagePattern withBlock:block];
 }
 
++ (void)stub:(SEL)aSelector withTypedBlock:(id)block {
+    KWMessagePattern *messagePattern = [KWMessagePattern messagePatternWithSelector:aSelector];
+    [self stubMessagePattern:messagePattern withTypedBlock:block];
+}
+
 + (void)stub:(SEL)aSelector withArguments:(id)firstArgument, ... {
     va_list argumentList;
     va_start(argumentList, firstArgument);
@@ -153,6 +163,19 @@ static NSString * const ChangeStubValueAfterTimesKey = @"ChangeStubValueAfterTim
     KWAssociateObjectStub(self, stub, YES);
 }
 
+- (void)stubMessagePattern:(KWMessagePattern *)aMessagePattern withTypedBlock:(id)block {
+    NSMethodSignature *signature = [self methodSignatureForSelector:aMessagePattern.selector];
+    if (signature == nil) {
+        [NSException raise:@"KWStubException" format:@"cannot stub -%@ because no such method exists",
+         NSStringFromSelector(aMessagePattern.selector)];
+    }
+
+    KWStub *stub = [KWStub stubWithMessagePattern:aMessagePattern typedBlock:block methodSignature:signature];
+    Class interceptClass = KWSetupObjectInterceptSupport(self);
+    KWSetupMethodInterceptSupport(interceptClass, aMessagePattern.selector);
+    KWAssociateObjectStub(self, stub, YES);
+}
+
 + (void)stubMessagePattern:(KWMessagePattern *)aMessagePattern andReturn:(id)aValue {
     [self stubMessagePattern:aMessagePattern andReturn:aValue overrideExisting:YES];
 }
@@ -201,6 +224,19 @@ static NSString * const ChangeStubValueAfterTimesKey = @"ChangeStubValueAfterTim
     KWAssociateObjectStub(self, stub, override);
 }
 
++ (void)stubMessagePattern:(KWMessagePattern *)aMessagePattern withTypedBlock:(id)block {
+    NSMethodSignature *signature = [self methodSignatureForSelector:aMessagePattern.selector];
+    if (signature == nil) {
+        [NSException raise:@"KWStubException" format:@"cannot stub -%@ because no such method exists",
+         NSStringFromSelector(aMessagePattern.selector)];
+    }
+
+    KWStub *stub = [KWStub stubWithMessagePattern:aMessagePattern typedBlock:block methodSignature:signature];
+    Class interceptClass = KWSetupObjectInterceptSupport(self);
+    KWSetupMethodInterceptSupport(interceptClass, aMessagePattern.selector);
+    KWAssociateObjectStub(self, stub, YES);
+}
+
 - (void)clearStubs {
     KWClearObjectStubs(self);
 }
@@ -237,4 +273,28 @@ static NSString * const ChangeStubValueAfterTimesKey = @"ChangeStubValueAfterTim
     KWClearObjectSpy(self, aSpy, aMessagePattern);
 }
 
+#pragma mark - Journaling Messages
+
+- (KWInvocationJournal *)invocationJournalForMessagePattern:(KWMessagePattern *)aMessagePattern {
+    if ([self methodSignatureForSelector:aMessagePattern.selector] == nil) {
+        [NSException raise:@"KWSpyException" format:@"cannot record -%@ because no such method exists",
+         NSStringFromSelector(aMessagePattern.selector)];
+    }
+
+    Class interceptClass = KWSetupObjectInterceptSupport(self);
+    KWSetupMethodInterceptSupport(interceptClass, aMessagePattern.selector);
+    return KWObjectInvocationJournal(self);
+}
+
++ (KWInvocationJournal *)invocationJournalForMessagePattern:(KWMessagePattern *)aMessagePattern {
+    if ([self methodSignatureForSelector:aMessagePattern.selector] == nil) {
+        [NSException raise:@"KWSpyException" format:@"cannot record -%@ because no such method exists",
+         NSStringFromSelector(aMessagePattern.selector)];
+    }
+
+    Class interceptClass = KWSetupObjectInterceptSupport(self);
+    KWSetupMethodInterceptSupport(interceptClass, aMessagePattern.selector);
+    return KWObjectInvocationJournal(self);
+}
+
 @end
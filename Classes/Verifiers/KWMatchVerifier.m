@@ -12,6 +12,7 @@
 #import "KWFormatter.h"
 #import "KWInvocationCapturer.h"
 #import "KWMatcherFactory.h"
+#import "KWMatcherResolution.h"
 #import "KWReporting.h"
 #import "KWStringUtilities.h"
 #import "KWWorkarounds.h"
@@ -49,7 +50,8 @@
         _callSite = aCallSite;
         _matcherFactory = aMatcherFactory;
         _reporter = aReporter;
-        _example = (KWExample *)aReporter;
+        // Verifiers can report to anything, but only examples track them.
+        _example = [(id)aReporter isKindOfClass:[KWExample class]] ? (KWExample *)aReporter : nil;
     }
 
     return self;
@@ -111,9 +113,40 @@
     }
 }
 
+#pragma mark - Resolving Matchers
+
+- (KWMatcherResolution *)cachedMatcherResolutionForSelector:(SEL)aSelector {
+    if (!self.callSite.interned)
+        return nil;
+
+    KWMatcherResolution *resolution = self.callSite.matcherResolution;
+    return [resolution isResolutionOfSelector:aSelector subject:self.subject matcherFactory:self.matcherFactory] ? resolution : nil;
+}
+
+- (KWMatcherResolution *)matcherResolutionForSelector:(SEL)aSelector {
+    KWMatcherResolution *resolution = [self cachedMatcherResolutionForSelector:aSelector];
+
+    if (resolution != nil)
+        return resolution;
+
+    resolution = [KWMatcherResolution resolutionWithSelector:aSelector subject:self.subject matcherFactory:self.matcherFactory];
+
+    if (resolution.cacheable && self.callSite.interned)
+        self.callSite.matcherResolution = resolution;
+
+    return resolution;
+}
+
 #pragma mark - Handling Invocations
 
 - (NSMethodSignature *)methodSignatureForSelector:(SEL)aSelector {
+    // Matcher selectors are never implemented by verifiers, so a resolution
+    // cached for the selector answers before the class is searched.
+    KWMatcherResolution *resolution = [self cachedMatcherResolutionForSelector:aSelector];
+
+    if (resolution != nil)
+        return resolution.methodSignature;
+
     NSMethodSignature *signature = [super methodSignatureForSelector:aSelector];
 
     if (signature != nil)
@@ -131,11 +164,21 @@
 }
 
 - (void)forwardInvocation:(NSInvocation *)anInvocation {
+    // The example may hold the last reference to this verifier, and lets go
+    // of it as soon as the expectation has been evaluated.
+    NS_VALID_UNTIL_END_OF_SCOPE KWMatchVerifier *verifier = self;
+    (void)verifier;
+
 #if KW_TARGET_HAS_INVOCATION_EXCEPTION_BUG
     @try {
 #endif // #if KW_TARGET_HAS_INVOCATION_EXCEPTION_BUG
 
-    self.matcher = (id<KWMatching>)[self.matcherFactory matcherFromInvocation:anInvocation subject:self.subject];
+    KWMatcherResolution *resolution = [self matcherResolutionForSelector:anInvocation.selector];
+
+    if (resolution != nil)
+        self.matcher = [[resolution.matcherClass alloc] initWithSubject:self.subject];
+    else
+        self.matcher = (id<KWMatching>)[self.matcherFactory matcherFromInvocation:anInvocation subject:self.subject];
 
     if (self.matcher == nil) {
       KWFailure *failure = [KWFailure failureWithCallSite:self.callSite format:@"could not create matcher for -%@",
@@ -143,7 +186,9 @@
       [self.reporter reportFailure:failure];
     }
         
-    if (self.expectationType == KWExpectationTypeShouldNot && [self.matcher respondsToSelector:@selector(setWillEvaluateAgainstNegativeExpectation:)]) {
+    BOOL acceptsNegativeExpectation = resolution != nil ? resolution.acceptsNegativeExpectation : [self.matcher respondsToSelector:@selector(setWillEvaluateAgainstNegativeExpectation:)];
+
+    if (self.expectationType == KWExpectationTypeShouldNot && acceptsNegativeExpectation) {
         [self.matcher setWillEvaluateAgainstNegativeExpectation:YES];
     }
 
@@ -160,12 +205,15 @@
     [exception raise];
 #endif // #if KW_TARGET_HAS_INVOCATION_EXCEPTION_BUG
 
-    if ([self.matcher respondsToSelector:@selector(shouldBeEvaluatedAtEndOfExample)] && [self.matcher shouldBeEvaluatedAtEndOfExample]) {
+    BOOL mayEvaluateAtEndOfExample = resolution != nil ? resolution.mayEvaluateAtEndOfExample : [self.matcher respondsToSelector:@selector(shouldBeEvaluatedAtEndOfExample)];
+
+    if (mayEvaluateAtEndOfExample && [self.matcher shouldBeEvaluatedAtEndOfExample]) {
         self.endOfExampleMatcher = self.matcher;
         self.matcher = nil;
     }
     else {
         [self verifyWithMatcher:self.matcher];
+        [self.example removeVerifier:self];
     }
 
 #if KW_TARGET_HAS_INVOCATION_EXCEPTION_BUG
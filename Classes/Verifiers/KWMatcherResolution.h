@@ -0,0 +1,43 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KiwiConfiguration.h"
+
+@class KWMatcherFactory;
+
+// The matcher class a match verifier resolved for a matcher selector and a
+// subject class, along with what the verifier needs to know to use it.
+// Resolutions are immutable, and are kept at the call site of their
+// expectation, so that an expectation that runs many times only walks the
+// matcher class chain when its subject class changes, or once per example.
+@interface KWMatcherResolution : NSObject
+
+#pragma mark - Initializing
+
+// Returns nil if the matcher factory has no matcher class for the selector
+// and subject, such as when a user-defined matcher should be used instead.
++ (id)resolutionWithSelector:(SEL)aSelector subject:(id)aSubject matcherFactory:(KWMatcherFactory *)aMatcherFactory;
+
+#pragma mark - Properties
+
+@property (nonatomic, readonly) SEL selector;
+@property (nonatomic, readonly) Class matcherClass;
+@property (nonatomic, readonly) NSMethodSignature *methodSignature;
+
+// NO if instances of the matcher class cannot ask to be evaluated at the end
+// of the example, so the verifier can evaluate them right away.
+@property (nonatomic, readonly) BOOL mayEvaluateAtEndOfExample;
+@property (nonatomic, readonly) BOOL acceptsNegativeExpectation;
+
+// NO if the subject is of a class whose matcher compatibility cannot be
+// judged by its class alone, such as a mock or proxy.
+@property (nonatomic, readonly, getter=isCacheable) BOOL cacheable;
+
+#pragma mark - Matching Expectations
+
+- (BOOL)isResolutionOfSelector:(SEL)aSelector subject:(id)aSubject matcherFactory:(KWMatcherFactory *)aMatcherFactory;
+
+@end
@@ -0,0 +1,84 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import "KWMatcherResolution.h"
+#import <objc/runtime.h>
+#import "KWMatcherFactory.h"
+#import "KWMatching.h"
+
+#pragma mark - Getting Subject Classes
+
+// Matcher classes decide whether they can match a subject by asking it
+// -isKindOfClass:, so any subject that answers it the way NSObject does can
+// stand for all subjects of its class.
+static BOOL KWMatcherResolutionGetClassOfSubject(id aSubject, Class *aClass) {
+    static IMP instanceIsKindOfClass = NULL;
+    static IMP classIsKindOfClass = NULL;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        instanceIsKindOfClass = class_getMethodImplementation([NSObject class], @selector(isKindOfClass:));
+        classIsKindOfClass = class_getMethodImplementation(object_getClass([NSObject class]), @selector(isKindOfClass:));
+    });
+
+    Class subjectClass = object_getClass(aSubject);
+    *aClass = subjectClass;
+
+    if (subjectClass == Nil)
+        return YES;
+
+    IMP isKindOfClass = class_getMethodImplementation(subjectClass, @selector(isKindOfClass:));
+    return isKindOfClass == instanceIsKindOfClass || isKindOfClass == classIsKindOfClass;
+}
+
+@interface KWMatcherResolution()
+
+@property (nonatomic, readonly) Class subjectClass;
+@property (nonatomic, readonly) NSUInteger registrationGeneration;
+
+@end
+
+@implementation KWMatcherResolution
+
+#pragma mark - Initializing
+
+- (id)initWithSelector:(SEL)aSelector subjectClass:(Class)aSubjectClass cacheable:(BOOL)cacheable matcherFactory:(KWMatcherFactory *)aMatcherFactory matcherClass:(Class)aMatcherClass {
+    self = [super init];
+    if (self) {
+        _selector = aSelector;
+        _subjectClass = aSubjectClass;
+        _cacheable = cacheable;
+        _registrationGeneration = aMatcherFactory.registrationGeneration;
+        _matcherClass = aMatcherClass;
+        _methodSignature = [aMatcherFactory methodSignatureForMatcherSelector:aSelector];
+        _mayEvaluateAtEndOfExample = [aMatcherClass instancesRespondToSelector:@selector(shouldBeEvaluatedAtEndOfExample)];
+        _acceptsNegativeExpectation = [aMatcherClass instancesRespondToSelector:@selector(setWillEvaluateAgainstNegativeExpectation:)];
+    }
+
+    return self;
+}
+
++ (id)resolutionWithSelector:(SEL)aSelector subject:(id)aSubject matcherFactory:(KWMatcherFactory *)aMatcherFactory {
+    Class matcherClass = [aMatcherFactory matcherClassForSelector:aSelector subject:aSubject];
+
+    if (matcherClass == Nil)
+        return nil;
+
+    Class subjectClass = Nil;
+    BOOL cacheable = KWMatcherResolutionGetClassOfSubject(aSubject, &subjectClass);
+    return [[self alloc] initWithSelector:aSelector subjectClass:subjectClass cacheable:cacheable matcherFactory:aMatcherFactory matcherClass:matcherClass];
+}
+
+#pragma mark - Matching Expectations
+
+- (BOOL)isResolutionOfSelector:(SEL)aSelector subject:(id)aSubject matcherFactory:(KWMatcherFactory *)aMatcherFactory {
+    if (!self.cacheable || aSelector != self.selector || aMatcherFactory.registrationGeneration != self.registrationGeneration)
+        return NO;
+
+    Class subjectClass = Nil;
+    return KWMatcherResolutionGetClassOfSubject(aSubject, &subjectClass) && subjectClass == self.subjectClass;
+}
+
+@end
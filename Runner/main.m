@@ -0,0 +1,63 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+// Runs Kiwi specs without XCTest. Usage:
+//
+//   kiwi-run [--output <path>] [--jobs <count>] [--history <path>]
+//            <spec bundle or library> ...
+//
+// Loads every given bundle or library, then runs the examples of all loaded
+// KWSpec subclasses, in that many worker processes if --jobs is given. Exits
+// with status 1 if an example failed. With --history, example durations and
+// results are kept in a file and used to order later runs.
+//
+
+#import <Kiwi/Kiwi.h>
+#import <dlfcn.h>
+
+static BOOL KWLoadSpecs(NSString *aPath) {
+    NSBundle *bundle = [NSBundle bundleWithPath:aPath];
+
+    if (bundle != nil)
+        return [bundle loadAndReturnError:NULL];
+
+    return dlopen([aPath fileSystemRepresentation], RTLD_NOW | RTLD_GLOBAL) != NULL;
+}
+
+int main(int argc, const char *argv[]) {
+    @autoreleasepool {
+        NSFileHandle *output = [NSFileHandle fileHandleWithStandardOutput];
+        NSUInteger workerCount = 1;
+        NSString *historyPath = nil;
+
+        for (int i = 1; i < argc; ++i) {
+            NSString *argument = @(argv[i]);
+
+            if ([argument isEqualToString:@"--output"] && i + 1 < argc) {
+                NSString *path = @(argv[++i]);
+                [[NSFileManager defaultManager] createFileAtPath:path contents:nil attributes:nil];
+                output = [NSFileHandle fileHandleForWritingAtPath:path];
+
+                if (output == nil) {
+                    fprintf(stderr, "could not open %s\n", [path UTF8String]);
+                    return 2;
+                }
+            } else if ([argument isEqualToString:@"--jobs"] && i + 1 < argc) {
+                workerCount = (NSUInteger)MAX(atoi(argv[++i]), 1);
+            } else if ([argument isEqualToString:@"--history"] && i + 1 < argc) {
+                historyPath = @(argv[++i]);
+            } else if (!KWLoadSpecs(argument)) {
+                fprintf(stderr, "could not load %s: %s\n", [argument UTF8String], dlerror() ?: "not a loadable bundle");
+                return 2;
+            }
+        }
+
+        KWSpecRunner *runner = [[KWSpecRunner alloc] initWithOutput:output];
+        runner.historyPath = historyPath;
+        BOOL passed = [runner runSpecClasses:[KWSpecRunner specClasses] workerCount:workerCount];
+        [output synchronizeFile];
+        return passed ? 0 : 1;
+    }
+}
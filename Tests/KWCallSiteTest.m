@@ -0,0 +1,43 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import <Kiwi/Kiwi.h>
+#import "KiwiTestConfiguration.h"
+
+#if KW_TESTS_ENABLED
+
+@interface KWCallSiteTest : XCTestCase
+
+@end
+
+@implementation KWCallSiteTest
+
+- (void)testItShouldReuseTheCallSiteOfAnExpansion {
+    KWCallSite *callSites[3];
+
+    for (NSUInteger i = 0; i < 3; ++i)
+        callSites[i] = KW_THIS_CALLSITE;
+
+    XCTAssertTrue(callSites[0] == callSites[1] && callSites[1] == callSites[2], @"expected one call site per source location");
+    XCTAssertEqual(callSites[0].lineNumber, (NSUInteger)22, @"expected call site to carry its line number");
+}
+
+- (void)testItShouldInternCallSitesByContents {
+    char filename[] = "CruiserSpec.m";
+    KWCallSite *callSite = KWInternedCallSite("CruiserSpec.m", 42);
+    XCTAssertTrue(KWInternedCallSite(filename, 42) == callSite, @"expected equal locations to share a call site");
+    XCTAssertFalse(KWInternedCallSite(filename, 43) == callSite, @"expected other lines to get call sites of their own");
+}
+
+- (void)testItShouldCompareInternedCallSitesWithOthersByContents {
+    KWCallSite *callSite = [KWCallSite callSiteWithFilename:@"CruiserSpec.m" lineNumber:42];
+    XCTAssertEqualObjects(KWInternedCallSite("CruiserSpec.m", 42), callSite, @"expected call sites with equal contents to be equal");
+    XCTAssertEqual([KWInternedCallSite("CruiserSpec.m", 42) hash], [callSite hash], @"expected equal call sites to have equal hashes");
+}
+
+@end
+
+#endif // #if KW_TESTS_ENABLED
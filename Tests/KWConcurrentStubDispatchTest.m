@@ -0,0 +1,113 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import <Kiwi/Kiwi.h>
+#import "KiwiTestConfiguration.h"
+#import "TestClasses.h"
+#import "KWIntercept.h"
+
+#if KW_TESTS_ENABLED
+
+static const size_t KWConcurrentStubDispatchThreadCount = 8;
+static const NSUInteger KWConcurrentStubDispatchCallsPerThread = 10000;
+
+@interface KWConcurrentStubDispatchTest : XCTestCase
+
+@end
+
+@implementation KWConcurrentStubDispatchTest
+
+- (void)tearDown {
+    KWClearStubsAndSpies();
+}
+
+// Calls the block from KWConcurrentStubDispatchThreadCount threads at once and
+// returns the number of calls for which it returned NO.
+- (NSUInteger)failureCountCallingConcurrently:(BOOL (^)(size_t thread, NSUInteger call))aBlock {
+    __block volatile int32_t failureCount = 0;
+    dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+
+    dispatch_apply(KWConcurrentStubDispatchThreadCount, queue, ^(size_t thread) {
+        for (NSUInteger call = 0; call < KWConcurrentStubDispatchCallsPerThread; ++call) {
+            @autoreleasepool {
+                if (!aBlock(thread, call))
+                    __sync_fetch_and_add(&failureCount, 1);
+            }
+        }
+    });
+
+    return (NSUInteger)failureCount;
+}
+
+- (void)testItShouldReturnStubbedValuesToConcurrentCallersOfAnInterceptedObject {
+    Cruiser *cruiser = [Cruiser new];
+    [cruiser stub:@selector(crewComplement) andReturn:theValue(42)];
+    [cruiser stub:@selector(computeStarHashForKey:) andReturn:theValue(7)];
+
+    NSUInteger failureCount = [self failureCountCallingConcurrently:^BOOL(size_t thread, NSUInteger call) {
+        return [cruiser crewComplement] == 42 && [cruiser computeStarHashForKey:call] == 7;
+    }];
+
+    XCTAssertEqual(failureCount, (NSUInteger)0, @"expected every concurrent call to return the stubbed value");
+}
+
+- (void)testItShouldReturnStubbedValuesToConcurrentCallersOfAMock {
+    id cruiser = [Cruiser mock];
+    [cruiser stub:@selector(crewComplement) andReturn:theValue(42)];
+    [cruiser stub:@selector(callsign) andReturn:@"Red 5"];
+
+    NSUInteger failureCount = [self failureCountCallingConcurrently:^BOOL(size_t thread, NSUInteger call) {
+        return [cruiser crewComplement] == 42 && [[cruiser callsign] isEqualToString:@"Red 5"];
+    }];
+
+    XCTAssertEqual(failureCount, (NSUInteger)0, @"expected every concurrent call to return the stubbed value");
+}
+
+- (void)testItShouldCountMessagesReceivedFromConcurrentCallers {
+    Cruiser *cruiser = [Cruiser new];
+    KWReceiveMatcher *matcher = [KWReceiveMatcher matcherWithSubject:cruiser];
+    [matcher receive:@selector(raiseShields) withCount:KWConcurrentStubDispatchThreadCount * KWConcurrentStubDispatchCallsPerThread];
+
+    [self failureCountCallingConcurrently:^BOOL(size_t thread, NSUInteger call) {
+        [cruiser raiseShields];
+        return YES;
+    }];
+
+    XCTAssertTrue([matcher evaluate], @"expected every concurrent call to be counted");
+}
+
+- (void)testItShouldDispatchToStubsWhileOtherThreadsChangeThem {
+    Cruiser *cruiser = [Cruiser new];
+    [cruiser stub:@selector(crewComplement) andReturn:theValue(42)];
+
+    NSUInteger failureCount = [self failureCountCallingConcurrently:^BOOL(size_t thread, NSUInteger call) {
+        // One thread keeps restubbing an unrelated method while the others
+        // call the stubbed one.
+        if (thread == 0) {
+            [cruiser stub:@selector(hyperdriveFuelLevel) andReturn:theValue(call)];
+            return YES;
+        }
+
+        return [cruiser crewComplement] == 42;
+    }];
+
+    XCTAssertEqual(failureCount, (NSUInteger)0, @"expected concurrent calls to see the stub while other stubs change");
+}
+
+- (void)testPerformanceOfConcurrentCallsToAStubbedObject {
+    Cruiser *cruiser = [Cruiser new];
+    [cruiser stub:@selector(crewComplement) andReturn:theValue(42)];
+
+    [self measureBlock:^{
+        [self failureCountCallingConcurrently:^BOOL(size_t thread, NSUInteger call) {
+            return [cruiser crewComplement] == 42;
+        }];
+    }];
+}
+
+@end
+
+#endif // #if KW_TESTS_ENABLED
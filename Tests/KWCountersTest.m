@@ -0,0 +1,82 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import <Kiwi/Kiwi.h>
+#import "KiwiTestConfiguration.h"
+#import "TestClasses.h"
+#import "KWIntercept.h"
+
+#if KW_TESTS_ENABLED
+
+@interface KWCountersTest : XCTestCase
+
+@end
+
+@implementation KWCountersTest
+
+- (void)tearDown {
+    KWClearStubsAndSpies();
+}
+
+- (uint64_t)valueOfCounter:(KWCounter)counter {
+    uint64_t values[KWCounterCount];
+    KWCountersRead(values);
+    return values[counter];
+}
+
+- (void)testItShouldSumCountsFromAllThreads {
+    uint64_t before = [self valueOfCounter:KWCounterProbePolls];
+
+    dispatch_apply(8, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t iteration) {
+        for (NSUInteger i = 0; i < 1000; ++i)
+            KWCounterIncrement(KWCounterProbePolls);
+    });
+
+    XCTAssertEqual([self valueOfCounter:KWCounterProbePolls] - before, (uint64_t)8000, @"expected counts of every thread to be summed");
+}
+
+- (void)testItShouldCountMockInvocationsAndStubs {
+    uint64_t invocationsBefore = [self valueOfCounter:KWCounterMockInvocations];
+    uint64_t stubsBefore = [self valueOfCounter:KWCounterStubsInstalled];
+    id mock = [Cruiser mock];
+    [mock stub:@selector(crewComplement) andReturn:theValue(42)];
+    [mock crewComplement];
+    [mock crewComplement];
+    XCTAssertEqual([self valueOfCounter:KWCounterMockInvocations] - invocationsBefore, (uint64_t)2, @"expected mock invocations to be counted");
+    XCTAssertEqual([self valueOfCounter:KWCounterStubsInstalled] - stubsBefore, (uint64_t)1, @"expected installed stubs to be counted");
+}
+
+- (void)testItShouldCountInterceptedInvocations {
+    Cruiser *cruiser = [Cruiser new];
+    [cruiser stub:@selector(crewComplement) andReturn:theValue(42)];
+    uint64_t before = [self valueOfCounter:KWCounterInterceptedInvocations];
+    [cruiser crewComplement];
+    XCTAssertEqual([self valueOfCounter:KWCounterInterceptedInvocations] - before, (uint64_t)1, @"expected intercepted invocations to be counted");
+}
+
+- (void)testItShouldCountMessagePatternMatchAttemptsAndMatchesApart {
+    // Stubs of mocks are tried in the order they were added.
+    id cruiser = [Cruiser mock];
+    [cruiser stub:@selector(callsign) andReturn:@"Galactica"];
+    [cruiser stub:@selector(classification) andReturn:@"Battlestar"];
+    [cruiser stub:@selector(crewComplement) andReturn:theValue(42)];
+    uint64_t attemptsBefore = [self valueOfCounter:KWCounterMessagePatternMatchAttempts];
+    uint64_t matchesBefore = [self valueOfCounter:KWCounterMessagePatternMatches];
+    [cruiser crewComplement];
+    XCTAssertTrue([self valueOfCounter:KWCounterMessagePatternMatchAttempts] - attemptsBefore >= 3, @"expected every message pattern tried to be counted");
+    XCTAssertEqual([self valueOfCounter:KWCounterMessagePatternMatches] - matchesBefore, (uint64_t)1, @"expected only the matching message pattern to be counted as a match");
+}
+
+- (void)testItShouldNameEveryCounter {
+    uint64_t values[KWCounterCount] = { 0 };
+    NSDictionary *counters = KWCountersDictionary(values);
+    XCTAssertEqual([counters count], (NSUInteger)KWCounterCount, @"expected every counter to have a distinct name");
+    XCTAssertEqual([[KWSpec engineCounters] count], (NSUInteger)KWCounterCount, @"expected spec counters to include every counter");
+}
+
+@end
+
+#endif // #if KW_TESTS_ENABLED
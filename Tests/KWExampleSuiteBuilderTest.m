@@ -7,6 +7,8 @@
 #import <Kiwi/Kiwi.h>
 #import "KiwiTestConfiguration.h"
 #import "TestClasses.h"
+#import "KWExampleSuite.h"
+#import "KWFailedExamples.h"
 
 #if KW_TESTS_ENABLED
 
@@ -29,6 +31,27 @@
     XCTAssertFalse([[KWExampleSuiteBuilder sharedExampleSuiteBuilder] isBuildingExampleSuite], @"example suite builder must be clean for other tests to run cleanly");
 }
 
+- (void)testItShouldOnlyBuildExamplesThatAreRerun {
+    KWExampleSuiteBuilder *builder = [KWExampleSuiteBuilder sharedExampleSuiteBuilder];
+    NSSet *rerunExampleKeys = builder.rerunExampleKeys;
+    builder.rerunExampleKeys = [NSSet setWithObject:KWFailedExampleKey(@"CruiserSpec", @"ACruiser_Flies_2")];
+
+    void (^buildingBlock)(void) = ^{
+        [builder pushContextNodeWithCallSite:nil description:@"a cruiser"];
+        [builder addItNodeWithCallSite:nil description:@"flies" block:^{}];
+        [builder addPendingNodeWithCallSite:nil description:@"lands"];
+        [builder addItNodeWithCallSite:nil description:@"flies" block:^{}];
+        [builder popContextNode];
+    };
+    KWExampleSuite *exampleSuite = [builder buildExampleSuiteForSpecName:@"CruiserSpec" block:buildingBlock];
+    KWExampleSuite *otherExampleSuite = [builder buildExampleSuiteForSpecName:@"CarrierSpec" block:buildingBlock];
+    builder.rerunExampleKeys = rerunExampleKeys;
+
+    XCTAssertEqual([exampleSuite.examples count], (NSUInteger)1, @"expected only rerun examples to be built");
+    XCTAssertEqualObjects([exampleSuite.examples[0] selectorName], @"ACruiser_Flies_2", @"expected left out examples to keep their selector names");
+    XCTAssertEqual([otherExampleSuite.examples count], (NSUInteger)0, @"expected examples of other specs with the same names not to be rerun");
+}
+
 @end
 
 #endif // #if KW_TESTS_ENABLED
@@ -6,6 +6,7 @@
 
 #import <Kiwi/Kiwi.h>
 #import "KiwiTestConfiguration.h"
+#import "TestClasses.h"
 
 #if KW_TESTS_ENABLED
 
@@ -24,6 +25,31 @@
     XCTAssertNoThrow(itNodeImitation(), @"expected no exception");
 }
 
+- (void)testItShouldOnlyKeepVerifiersThatWaitForTheEndOfTheExample {
+    KWExample *example = [[KWExample alloc] initWithExampleNode:nil];
+    [example visitRegisterMatchersNode:[KWRegisterMatchersNode registerMatchersNodeWithCallSite:nil namespacePrefix:@"KW"]];
+
+    for (NSUInteger i = 0; i < 100; ++i)
+        [[@(i) attachToVerifier:[example addMatchVerifierWithExpectationType:KWExpectationTypeShould callSite:nil]] equal:@(i)];
+
+    XCTAssertEqual(example.verifierCount, (NSUInteger)0, @"expected evaluated verifiers to be removed");
+
+    [@"Enterprise" attachToVerifier:[example addExistVerifierWithExpectationType:KWExpectationTypeShould callSite:nil]];
+    XCTAssertEqual(example.verifierCount, (NSUInteger)1, @"expected end of example verifiers to be kept");
+    XCTAssertTrue([[example generateDescriptionForAnonymousItNode] hasPrefix:@"should equal"], @"expected the first verifier to describe the example");
+}
+
+- (void)testItShouldLetVerifiersReportToReportersThatAreNotExamples {
+    KWMatcherFactory *matcherFactory = [[KWMatcherFactory alloc] init];
+    [matcherFactory registerMatcherClassesWithNamespacePrefix:@"KW"];
+    TestReporter *reporter = [[TestReporter alloc] init];
+    KWMatchVerifier *verifier = [KWMatchVerifier matchVerifierWithExpectationType:KWExpectationTypeShould callSite:nil matcherFactory:matcherFactory reporter:reporter];
+    verifier.subject = @42;
+
+    XCTAssertNoThrow([(id)verifier equal:@43], @"expected no exception");
+    XCTAssertTrue([reporter hasOneFailure], @"expected the failure to be reported");
+}
+
 @end
 
 #endif // #if KW_TESTS_ENABLED
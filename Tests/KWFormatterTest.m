@@ -32,6 +32,28 @@
     XCTAssertEqualObjects([sampleDict description], [KWFormatter formatObject:sampleDict], @"Dictionaries should be not treated as NSEnumerable");
 }
 
+- (void)testBoundsDescriptionsOfLargeCollections {
+    NSMutableArray *sampleArray = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 100000; ++i)
+        [sampleArray addObject:@(i)];
+
+    NSString *description = [KWFormatter formatObject:sampleArray];
+    XCTAssertTrue([description length] < KWFormatterDefaultMaximumLength + 64, @"Descriptions should stop at the maximum length");
+    XCTAssertTrue([description hasSuffix:@"more)"], @"Descriptions should say how many objects were left out");
+}
+
+- (void)testMarksNestingBeyondTheMaximumDepth {
+    NSArray *sampleArray = @[@[@[@1, @2]]];
+    XCTAssertEqualObjects(@"((... 2 items))", [KWFormatter formatObject:sampleArray maximumLength:100 maximumDepth:2], @"Collections beyond the maximum depth should be elided");
+}
+
+- (void)testMarksCycles {
+    NSMutableArray *sampleArray = [NSMutableArray arrayWithObject:@1];
+    [sampleArray addObject:sampleArray];
+    XCTAssertEqualObjects(@"(1, (<cycle>))", [KWFormatter formatObject:sampleArray], @"Collections that contain themselves should not be formatted again");
+    [sampleArray removeLastObject];
+}
+
 @end
 
 #endif // #if KW_TESTS_ENABLED
@@ -273,6 +273,40 @@ describe(@"NSDate stubs", ^{
 
 SPEC_END
 
+SPEC_BEGIN(BeforeAllStubs)
+
+describe(@"Stubs created in beforeAll", ^{
+    __block Cruiser *cruiser = nil;
+
+    beforeAll(^{
+        cruiser = [Cruiser new];
+        [cruiser stub:@selector(crewComplement) andReturn:theValue(42)];
+    });
+
+    it(@"apply to the first example", ^{
+        [[theValue([cruiser crewComplement]) should] equal:theValue(42)];
+    });
+
+    it(@"outlive examples that override them", ^{
+        [cruiser stub:@selector(crewComplement) andReturn:theValue(7)];
+        [cruiser stub:@selector(raiseShields) andReturn:theValue(NO)];
+        [[theValue([cruiser crewComplement]) should] equal:theValue(7)];
+    });
+
+    it(@"give way to the latest stub of an example", ^{
+        [cruiser stub:@selector(crewComplement) andReturn:theValue(7)];
+        [cruiser stub:@selector(crewComplement) andReturn:theValue(9)];
+        [[theValue([cruiser crewComplement]) should] equal:theValue(9)];
+    });
+
+    it(@"apply to later examples without their stubs", ^{
+        [[theValue([cruiser crewComplement]) should] equal:theValue(42)];
+        [[theValue([cruiser raiseShields]) should] beYes];
+    });
+});
+
+SPEC_END
+
 #if KW_TESTS_ENABLED
 @interface KWFunctionalTests : XCTestCase
 @end
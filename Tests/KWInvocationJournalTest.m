@@ -0,0 +1,171 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import <Kiwi/Kiwi.h>
+#import "KiwiTestConfiguration.h"
+#import "TestClasses.h"
+#import "KWIntercept.h"
+#import "KWInvocationJournal.h"
+#import "KWMessageTracker.h"
+
+#if KW_TESTS_ENABLED
+
+@interface KWInvocationJournalTest : XCTestCase
+
+@end
+
+@implementation KWInvocationJournalTest
+
+- (void)tearDown {
+    KWClearStubsAndSpies();
+}
+
+- (void)testItShouldRecordMessagesInOrderAcrossMocks {
+    id cruiser = [Cruiser mock];
+    id carrier = [Carrier mock];
+    [cruiser stub:@selector(raiseShields)];
+    [carrier stub:@selector(raiseShields)];
+    KWInvocationJournal *cruiserJournal = [cruiser invocationJournalForMessagePattern:[KWMessagePattern messagePatternWithSelector:@selector(raiseShields)]];
+    KWInvocationJournal *carrierJournal = [carrier invocationJournalForMessagePattern:[KWMessagePattern messagePatternWithSelector:@selector(raiseShields)]];
+    [cruiserJournal beginWatching];
+    [carrierJournal beginWatching];
+
+    [carrier raiseShields];
+    [cruiser raiseShields];
+
+    XCTAssertTrue(carrierJournal.count == 1 && cruiserJournal.count == 1, @"expected both mocks to record the message");
+    XCTAssertTrue([carrierJournal entryAtIndex:0].sequenceNumber < [cruiserJournal entryAtIndex:0].sequenceNumber, @"expected sequence numbers to follow call order");
+}
+
+- (void)testItShouldRecordWordSizedArgumentsOfInterceptedObjects {
+    Cruiser *cruiser = [Cruiser new];
+    [cruiser stub:@selector(computeStarHashForKey:) andReturn:theValue(7)];
+    KWInvocationJournal *journal = [cruiser invocationJournalForMessagePattern:[KWMessagePattern messagePatternWithSelector:@selector(computeStarHashForKey:)]];
+    [journal beginWatching];
+
+    [cruiser computeStarHashForKey:42];
+
+    XCTAssertEqual(journal.count, (NSUInteger)1, @"expected one journal entry");
+    KWInvocationJournalEntry entry = [journal entryAtIndex:0];
+    XCTAssertTrue(entry.selector == @selector(computeStarHashForKey:), @"expected the selector to be recorded");
+    XCTAssertEqual(entry.argumentCount, (NSUInteger)1, @"expected the argument count to be recorded");
+    XCTAssertEqual(entry.arguments[0], (uintptr_t)42, @"expected the argument to be recorded inline");
+}
+
+- (void)testItShouldCountEntriesInASequenceRange {
+    id cruiser = [Cruiser mock];
+    [cruiser stub:@selector(raiseShields)];
+    KWInvocationJournal *journal = [cruiser invocationJournalForMessagePattern:[KWMessagePattern messagePatternWithSelector:@selector(raiseShields)]];
+    [journal beginWatching];
+
+    [cruiser raiseShields];
+    uint64_t first = KWInvocationJournalLatestSequenceNumber();
+    [cruiser raiseShields];
+    [cruiser raiseShields];
+    uint64_t last = KWInvocationJournalLatestSequenceNumber();
+    [cruiser raiseShields];
+
+    XCTAssertEqual([journal countOfEntriesWithSelector:@selector(raiseShields) afterSequenceNumber:first upToSequenceNumber:last], (NSUInteger)2,
+                   @"expected only entries in the range to be counted");
+}
+
+- (void)testItShouldOnlyRecordMessagesWhileWatched {
+    id cruiser = [Cruiser mock];
+    [cruiser stub:@selector(raiseShields)];
+    KWInvocationJournal *journal = [cruiser invocationJournalForMessagePattern:[KWMessagePattern messagePatternWithSelector:@selector(raiseShields)]];
+
+    [cruiser raiseShields];
+    XCTAssertEqual(journal.count, (NSUInteger)0, @"expected no entries before anything watches the journal");
+
+    uint64_t first = [journal beginWatching];
+    [cruiser raiseShields];
+    XCTAssertEqual(journal.count, (NSUInteger)1, @"expected entries while the journal is watched");
+
+    [journal endWatchingAfterSequenceNumber:first];
+    [cruiser raiseShields];
+    XCTAssertEqual(journal.count, (NSUInteger)0, @"expected entries to be dropped and not recorded once nothing watches the journal");
+}
+
+- (void)testItShouldDropEntriesThatNoWatcherCanCount {
+    id cruiser = [Cruiser mock];
+    [cruiser stub:@selector(raiseShields)];
+    KWInvocationJournal *journal = [cruiser invocationJournalForMessagePattern:[KWMessagePattern messagePatternWithSelector:@selector(raiseShields)]];
+
+    uint64_t first = [journal beginWatching];
+    [cruiser raiseShields];
+    [cruiser raiseShields];
+    uint64_t second = [journal beginWatching];
+    [cruiser raiseShields];
+
+    [journal endWatchingAfterSequenceNumber:first];
+    XCTAssertEqual(journal.count, (NSUInteger)1, @"expected only the entries the remaining watcher can count to be kept");
+    XCTAssertEqual([journal countOfEntriesWithSelector:@selector(raiseShields) afterSequenceNumber:second upToSequenceNumber:UINT64_MAX], (NSUInteger)1,
+                   @"expected the remaining watcher to keep its count");
+    [journal endWatchingAfterSequenceNumber:second];
+}
+
+- (void)testItShouldStopRecordingOnceReceiveExpectationsAreVerified {
+    id cruiser = [Cruiser nullMock];
+    KWMessageTracker *tracker = [KWMessageTracker messageTrackerWithSubject:cruiser
+                                                             messagePattern:[KWMessagePattern messagePatternWithSelector:@selector(raiseShields)]
+                                                                  countType:KWCountTypeExact
+                                                                      count:2];
+    [cruiser raiseShields];
+    [cruiser raiseShields];
+    [tracker stopTracking];
+
+    for (NSUInteger i = 0; i < 100; ++i)
+        [cruiser raiseShields];
+
+    XCTAssertTrue([tracker succeeded], @"expected the tracker to keep the count it verified");
+    XCTAssertEqual(KWInvocationJournalForObject(cruiser).count, (NSUInteger)0, @"expected no entries once no expectation is outstanding");
+}
+
+- (void)testItShouldForgetJournalsWhenStubsAndSpiesAreCleared {
+    Cruiser *cruiser = [Cruiser new];
+    KWInvocationJournal *journal = [cruiser invocationJournalForMessagePattern:[KWMessagePattern messagePatternWithSelector:@selector(raiseShields)]];
+    [cruiser raiseShields];
+    KWClearStubsAndSpies();
+
+    XCTAssertTrue(KWObjectInvocationJournal(cruiser) != journal, @"expected a new journal after clearing");
+    XCTAssertEqual(KWObjectInvocationJournal(cruiser).count, (NSUInteger)0, @"expected the new journal to be empty");
+}
+
+- (void)testItShouldOnlyJournalMessagesOfMocksWhenAskedTo {
+    id cruiser = [Cruiser nullMock];
+    [cruiser raiseShields];
+    XCTAssertNil(KWInvocationJournalForObject(cruiser), @"expected no journal to be kept");
+}
+
+- (void)testItShouldClearJournalsOfMocksWithTheirGeneration {
+    id cruiser = [Cruiser nullMock];
+    NSUInteger previousGeneration = KWCurrentInterceptGeneration();
+    NSUInteger generation = KWNewInterceptGeneration();
+    KWSetCurrentInterceptGeneration(generation);
+    [cruiser invocationJournalForMessagePattern:[KWMessagePattern messagePatternWithSelector:@selector(raiseShields)]];
+    [cruiser raiseShields];
+    KWSetCurrentInterceptGeneration(previousGeneration);
+    KWClearStubsAndSpiesOfGeneration(generation);
+
+    XCTAssertNil(KWInvocationJournalForObject(cruiser), @"expected the journal to be cleared with its generation");
+}
+
+- (void)testItShouldNotKeepJournaledMocksAlive {
+    __weak id weakCruiser = nil;
+
+    @autoreleasepool {
+        id cruiser = [Cruiser nullMock];
+        weakCruiser = cruiser;
+        [cruiser invocationJournalForMessagePattern:[KWMessagePattern messagePatternWithSelector:@selector(raiseShields)]];
+        [cruiser raiseShields];
+    }
+
+    XCTAssertNil(weakCruiser, @"expected journaled mocks to be deallocated when released");
+}
+
+@end
+
+#endif // #if KW_TESTS_ENABLED
@@ -0,0 +1,67 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import <Kiwi/Kiwi.h>
+#import "KiwiTestConfiguration.h"
+#import "TestClasses.h"
+#import "KWMatcherResolution.h"
+
+#if KW_TESTS_ENABLED
+
+@interface KWMatcherResolutionTest : XCTestCase
+
+@end
+
+@implementation KWMatcherResolutionTest
+
+- (KWMatcherFactory *)matcherFactory {
+    KWMatcherFactory *matcherFactory = [[KWMatcherFactory alloc] init];
+    [matcherFactory registerMatcherClass:[KWEqualMatcher class]];
+    return matcherFactory;
+}
+
+- (void)testItShouldResolveTheMatcherOfARepeatedExpectationOnce {
+    KWExample *example = [[KWExample alloc] initWithExampleNode:nil];
+    KWMatcherFactory *matcherFactory = [self matcherFactory];
+    KWMatcherResolution *resolutions[3];
+    KWCallSite *callSite = nil;
+
+    for (NSUInteger i = 0; i < 3; ++i) {
+        callSite = KW_THIS_CALLSITE;
+        id verifier = [KWMatchVerifier matchVerifierWithExpectationType:KWExpectationTypeShould callSite:callSite matcherFactory:matcherFactory reporter:(id<KWReporting>)example];
+        [[@(i) attachToVerifier:verifier] equal:@(i)];
+        resolutions[i] = callSite.matcherResolution;
+    }
+
+    XCTAssertEqual(resolutions[0].matcherClass, [KWEqualMatcher class], @"expected call site to keep the resolved matcher class");
+    XCTAssertTrue(resolutions[0] == resolutions[1] && resolutions[1] == resolutions[2], @"expected repeated expectations to reuse the resolution");
+}
+
+- (void)testItShouldNotMatchSubjectsOfOtherClasses {
+    KWMatcherFactory *matcherFactory = [self matcherFactory];
+    KWMatcherResolution *resolution = [KWMatcherResolution resolutionWithSelector:@selector(equal:) subject:@"Enterprise" matcherFactory:matcherFactory];
+    XCTAssertTrue([resolution isResolutionOfSelector:@selector(equal:) subject:@"Voyager" matcherFactory:matcherFactory], @"expected resolution to match subjects of the same class");
+    XCTAssertFalse([resolution isResolutionOfSelector:@selector(equal:) subject:@1701 matcherFactory:matcherFactory], @"expected resolution not to match subjects of other classes");
+    XCTAssertFalse([resolution isResolutionOfSelector:@selector(beIdenticalTo:) subject:@"Voyager" matcherFactory:matcherFactory], @"expected resolution not to match other selectors");
+}
+
+- (void)testItShouldNotMatchAfterMatcherClassesAreRegistered {
+    KWMatcherFactory *matcherFactory = [self matcherFactory];
+    KWMatcherResolution *resolution = [KWMatcherResolution resolutionWithSelector:@selector(equal:) subject:@"Enterprise" matcherFactory:matcherFactory];
+    XCTAssertFalse([resolution isResolutionOfSelector:@selector(equal:) subject:@"Enterprise" matcherFactory:[self matcherFactory]], @"expected resolution not to match other factories");
+    [matcherFactory registerMatcherClass:[KWContainMatcher class]];
+    XCTAssertFalse([resolution isResolutionOfSelector:@selector(equal:) subject:@"Enterprise" matcherFactory:matcherFactory], @"expected resolution not to match after registering matcher classes");
+}
+
+- (void)testItShouldNotBeCacheableForMockSubjects {
+    KWMatcherResolution *resolution = [KWMatcherResolution resolutionWithSelector:@selector(equal:) subject:[Cruiser mock] matcherFactory:[self matcherFactory]];
+    XCTAssertEqual(resolution.matcherClass, [KWEqualMatcher class], @"expected matcher class to be resolved");
+    XCTAssertFalse(resolution.cacheable, @"expected resolution for a mock not to be cacheable");
+}
+
+@end
+
+#endif // #if KW_TESTS_ENABLED
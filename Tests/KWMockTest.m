@@ -256,6 +256,17 @@
     XCTAssertTrue([mock conformsToProtocol:@protocol(OrbitCapable)], @"expected mock to conform to protocol");
 }
 
+- (void)testItShouldNotConformToUnrelatedProtocols {
+    id mock = [KWMock mockForProtocol:@protocol(OrbitCapable)];
+    XCTAssertFalse([mock conformsToProtocol:@protocol(JumpCapable)], @"expected mock not to conform to protocol");
+}
+
+- (void)testItShouldRespondToSelectorsOfIndirectConformedProtocols {
+    id mock = [KWMock mockForProtocol:@protocol(JumpCapable)];
+    XCTAssertTrue([mock respondsToSelector:@selector(orbitPeriodForMass:)], @"expected mock to respond to selector");
+    XCTAssertTrue([mock respondsToSelector:@selector(orbitPeriodForMass:)], @"expected mock to keep responding to selector");
+}
+
 - (void)testItShouldReturnMethodSignaturesForMethodsOfMockedProtocols {
     id mock = [KWMock mockForProtocol:@protocol(JumpCapable)];
     NSMethodSignature *signature = [mock methodSignatureForSelector:@selector(hyperdriveFuelLevel)];
@@ -263,6 +274,33 @@
     XCTAssertEqual([signature numberOfMessageArguments], (NSUInteger)0, @"expected number of arguments to match");
 }
 
+- (void)testItShouldShareMethodSignaturesBetweenMocksOfTheSameProtocol {
+    id firstMock = [KWMock mockForProtocol:@protocol(JumpCapable)];
+    id secondMock = [KWMock mockForProtocol:@protocol(JumpCapable)];
+    NSMethodSignature *firstSignature = [firstMock methodSignatureForSelector:@selector(hyperdriveFuelLevel)];
+    NSMethodSignature *secondSignature = [secondMock methodSignatureForSelector:@selector(hyperdriveFuelLevel)];
+    XCTAssertEqual(firstSignature, secondSignature, @"expected mocks of the same protocol to share signatures");
+}
+
+- (void)testItShouldNotShareMethodSignaturesBetweenMocksOfDifferentTypes {
+    id protocolMock = [KWMock mockForProtocol:@protocol(JumpCapable)];
+    id classMock = [KWMock mockForClass:[Cruiser class]];
+    NSMethodSignature *protocolSignature = [protocolMock methodSignatureForSelector:@selector(orbitPeriodForMass:)];
+    NSMethodSignature *classSignature = [classMock methodSignatureForSelector:@selector(callsign)];
+    XCTAssertTrue(KWObjCTypeEqualToObjCType([protocolSignature methodReturnType], @encode(float)), @"expected return types to match");
+    XCTAssertTrue(KWObjCTypeEqualToObjCType([classSignature methodReturnType], @encode(id)), @"expected return types to match");
+}
+
+- (void)testItShouldNotKeepDefaultSignaturesOfMethodsAddedLater {
+    id mock = [KWMock nullMockForClass:[Cruiser class]];
+    SEL selector = NSSelectorFromString(@"shieldStrengthAddedLater");
+    NSMethodSignature *defaultSignature = [mock methodSignatureForSelector:selector];
+    class_addMethod([Cruiser class], selector, imp_implementationWithBlock(^double(id cruiser) { return 1.0; }), "d@:");
+    NSMethodSignature *signature = [mock methodSignatureForSelector:selector];
+    XCTAssertFalse(KWObjCTypeEqualToObjCType([defaultSignature methodReturnType], @encode(double)), @"expected the default signature before the method is added");
+    XCTAssertTrue(KWObjCTypeEqualToObjCType([signature methodReturnType], @encode(double)), @"expected the signature of the added method");
+}
+
 - (void)testItShouldReturnResultsForMethodsOfMockedProtocols {
     id mock = [KWMock mockForProtocol:@protocol(JumpCapable)];
     [mock stub:@selector(hyperdriveFuelLevel)];
@@ -366,6 +404,14 @@
     XCTAssertTrue(called, @"expected setValue:forKey: to be stubbed");
 }
 
+- (void)testItShouldAllowStubbingWithTypedBlocks {
+    id mock = [Cruiser mock];
+    [mock stub:@selector(computeStarHashForKey:) withTypedBlock:^NSUInteger(id aMock, NSUInteger aKey) {
+        return aKey + 1;
+    }];
+    XCTAssertEqual([mock computeStarHashForKey:41], (NSUInteger)42, @"expected typed block to be called with native arguments");
+}
+
 - (void)testItShouldAllowStubbingSetValueForKeyPath {
     id mock = [Cruiser mock];
     __block BOOL called = NO;
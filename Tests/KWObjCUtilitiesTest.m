@@ -34,6 +34,37 @@
                   @"Did not expect int type to be evaluated as a boolean.");
 }
 
+#pragma mark KWObjCTypeDescriptorForObjCType
+
+- (void)testDescriptorsAreInternedByEncodingContents {
+    char encoding[] = "@";
+    const KWObjCTypeDescriptor *first = KWObjCTypeDescriptorForObjCType(@encode(id));
+    const KWObjCTypeDescriptor *second = KWObjCTypeDescriptorForObjCType(encoding);
+    XCTAssertTrue(first == second, @"Expected equal encodings to share one descriptor.");
+}
+
+- (void)testDescriptorDescribesSignedIntegral {
+    const KWObjCTypeDescriptor *descriptor = KWObjCTypeDescriptorForObjCType(@encode(short));
+    XCTAssertEqual(descriptor->kind, KWObjCTypeKindIntegral, @"Expected short to be integral.");
+    XCTAssertTrue(descriptor->traits & KWObjCTypeTraitSignedIntegral, @"Expected short to be signed.");
+    XCTAssertEqual(descriptor->size, sizeof(short), @"Expected descriptor size to match sizeof(short).");
+    XCTAssertEqual(descriptor->alignment, (NSUInteger)__alignof__(short), @"Expected descriptor alignment to match short.");
+}
+
+- (void)testDescriptorDescribesBlocksAsObjects {
+    const KWObjCTypeDescriptor *descriptor = KWObjCTypeDescriptorForObjCType("@?");
+    XCTAssertEqual(descriptor->kind, KWObjCTypeKindBlock, @"Expected @? to be a block.");
+    XCTAssertTrue(KWObjCTypeIsObject("@?"), @"Expected blocks to be evaluated as objects.");
+    XCTAssertTrue(KWObjCTypeIsPointerLike("@?"), @"Expected blocks to be evaluated as pointer-like.");
+}
+
+- (void)testDescriptorDescribesStructs {
+    const KWObjCTypeDescriptor *descriptor = KWObjCTypeDescriptorForObjCType(@encode(NSRange));
+    XCTAssertEqual(descriptor->kind, KWObjCTypeKindStruct, @"Expected NSRange to be a struct.");
+    XCTAssertEqual(KWObjCTypeLength(@encode(NSRange)), sizeof(NSRange), @"Expected struct length to match sizeof(NSRange).");
+    XCTAssertFalse(KWObjCTypeIsNumeric(@encode(NSRange)), @"Did not expect a struct to be evaluated as numeric.");
+}
+
 #pragma mark KWSelectorParameterCount
 
 - (void)testNumberOfParametersInMethodThatTakesNoParametersIsZero {
@@ -0,0 +1,162 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import <Kiwi/Kiwi.h>
+#import "KiwiTestConfiguration.h"
+#import "TestClasses.h"
+#import "NSInvocation+KiwiAdditions.h"
+
+#if KW_TESTS_ENABLED
+
+static NSThread *KWPassMatcherTestThread = nil;
+static NSUInteger KWPassMatcherTestComparisonCount = 0;
+static BOOL KWPassMatcherTestComparedOnOtherThreads = NO;
+
+// Counts its comparisons and notes those made off the test's thread.
+@interface KWPassMatcherTestElement : NSObject
+
+@property (nonatomic, assign) BOOL matches;
+
+@end
+
+@implementation KWPassMatcherTestElement
+
+- (BOOL)isEqual:(id)object {
+    ++KWPassMatcherTestComparisonCount;
+
+    if ([NSThread currentThread] != KWPassMatcherTestThread)
+        KWPassMatcherTestComparedOnOtherThreads = YES;
+
+    return self.matches;
+}
+
+- (NSUInteger)hash {
+    return 0;
+}
+
+@end
+
+@interface KWPassMatcherTest : XCTestCase
+
+@end
+
+@implementation KWPassMatcherTest
+
+- (KWMatcherFactory *)matcherFactory {
+    KWMatcherFactory *matcherFactory = [[KWMatcherFactory alloc] init];
+    [matcherFactory registerMatcherClassesWithNamespacePrefix:@"KW"];
+    return matcherFactory;
+}
+
+- (NSInvocation *)beKindOfClassInvocation:(Class)aClass {
+    Class targetClass = aClass;
+    return [NSInvocation invocationWithTarget:[KWBeKindOfClassMatcher matcherWithSubject:nil] selector:@selector(beKindOfClass:) messageArguments:&targetClass];
+}
+
+- (NSArray *)numbersWithCount:(NSUInteger)count {
+    NSMutableArray *numbers = [NSMutableArray arrayWithCapacity:count];
+
+    for (NSUInteger i = 0; i < count; ++i)
+        [numbers addObject:@(i)];
+
+    return numbers;
+}
+
+- (NSInvocation *)equalInvocation:(id)anObject {
+    id otherSubject = anObject;
+    return [NSInvocation invocationWithTarget:[KWEqualMatcher matcherWithSubject:nil] selector:@selector(equal:) messageArguments:&otherSubject];
+}
+
+- (NSArray *)elementsWithCount:(NSUInteger)count matchingAtIndex:(NSUInteger)anIndex {
+    NSMutableArray *elements = [NSMutableArray arrayWithCapacity:count];
+
+    for (NSUInteger i = 0; i < count; ++i) {
+        KWPassMatcherTestElement *element = [[KWPassMatcherTestElement alloc] init];
+        element.matches = i == anIndex;
+        [elements addObject:element];
+    }
+
+    KWPassMatcherTestThread = [NSThread currentThread];
+    KWPassMatcherTestComparisonCount = 0;
+    KWPassMatcherTestComparedOnOtherThreads = NO;
+    return elements;
+}
+
+- (void)testItShouldHaveTheRightMatcherStrings {
+    NSArray *matcherStrings = [KWPassMatcher matcherStrings];
+    NSArray *expectedStrings = @[@"allPass:matcherFactory:", @"anyPass:matcherFactory:"];
+    XCTAssertEqualObjects([matcherStrings sortedArrayUsingSelector:@selector(compare:)],
+                          [expectedStrings sortedArrayUsingSelector:@selector(compare:)],
+                          @"expected specific matcher strings");
+}
+
+- (void)testItShouldMatchWhenAllElementsPass {
+    KWPassMatcher *matcher = [KWPassMatcher matcherWithSubject:@[@"Enterprise", @"Voyager"]];
+    [matcher allPass:[self beKindOfClassInvocation:[NSString class]] matcherFactory:[self matcherFactory]];
+    XCTAssertTrue([matcher evaluate], @"expected positive match");
+}
+
+- (void)testItShouldReportTheElementsThatDidNotPass {
+    KWPassMatcher *matcher = [KWPassMatcher matcherWithSubject:@[@"Enterprise", @1701, @"Voyager"]];
+    [matcher allPass:[self beKindOfClassInvocation:[NSString class]] matcherFactory:[self matcherFactory]];
+    XCTAssertFalse([matcher evaluate], @"expected negative match");
+    XCTAssertTrue([[matcher failureMessageForShould] hasPrefix:@"expected all 3 elements to be kind of NSString, but 1 did not:\n  [1] expected subject to be kind of NSString"], @"expected failure message to name the failing element");
+}
+
+- (void)testItShouldMatchWhenAnyElementPasses {
+    KWPassMatcher *matcher = [KWPassMatcher matcherWithSubject:[NSSet setWithObjects:@1701, @"Voyager", nil]];
+    [matcher anyPass:[self beKindOfClassInvocation:[NSString class]] matcherFactory:[self matcherFactory]];
+    XCTAssertTrue([matcher evaluate], @"expected positive match");
+
+    matcher = [KWPassMatcher matcherWithSubject:@[@1701, @74656]];
+    [matcher anyPass:[self beKindOfClassInvocation:[NSString class]] matcherFactory:[self matcherFactory]];
+    XCTAssertFalse([matcher evaluate], @"expected negative match");
+}
+
+- (void)testItShouldEvaluateLargeCollectionsConcurrently {
+    NSMutableArray *subject = [[self numbersWithCount:10000] mutableCopy];
+    subject[5000] = @"Enterprise";
+    KWPassMatcher *matcher = [KWPassMatcher matcherWithSubject:subject];
+    [matcher allPass:[self beKindOfClassInvocation:[NSNumber class]] matcherFactory:[self matcherFactory]];
+    XCTAssertFalse([matcher evaluate], @"expected negative match");
+    XCTAssertTrue([[matcher failureMessageForShould] rangeOfString:@"[5000]"].location != NSNotFound, @"expected failure message to name the failing element");
+}
+
+- (void)testItShouldEvaluateMatchersThatCallElementsOnTheCallingThread {
+    NSArray *elements = [self elementsWithCount:1000 matchingAtIndex:NSNotFound];
+    KWPassMatcher *matcher = [KWPassMatcher matcherWithSubject:elements];
+    [matcher allPass:[self equalInvocation:@"Enterprise"] matcherFactory:[self matcherFactory]];
+    XCTAssertFalse([matcher evaluate], @"expected negative match");
+    XCTAssertEqual(KWPassMatcherTestComparisonCount, (NSUInteger)1000, @"expected every element to be compared");
+    XCTAssertFalse(KWPassMatcherTestComparedOnOtherThreads, @"expected elements to be compared on the calling thread only");
+}
+
+- (void)testItShouldStopAtTheFirstElementThatPasses {
+    NSArray *elements = [self elementsWithCount:1000 matchingAtIndex:2];
+    KWPassMatcher *matcher = [KWPassMatcher matcherWithSubject:elements];
+    [matcher anyPass:[self equalInvocation:@"Enterprise"] matcherFactory:[self matcherFactory]];
+    XCTAssertTrue([matcher evaluate], @"expected positive match");
+    XCTAssertEqual(KWPassMatcherTestComparisonCount, (NSUInteger)3, @"expected no elements to be compared after the first that passed");
+}
+
+- (void)testItShouldLimitTheElementsItDescribes {
+    KWPassMatcher *matcher = [KWPassMatcher matcherWithSubject:[self numbersWithCount:100]];
+    [matcher allPass:[self beKindOfClassInvocation:[NSString class]] matcherFactory:[self matcherFactory]];
+    XCTAssertFalse([matcher evaluate], @"expected negative match");
+    XCTAssertTrue([[matcher failureMessageForShould] hasSuffix:@"\n  ... and 90 more"], @"expected failure message to be limited");
+}
+
+- (void)testItShouldConfigureMatchersWithSideEffectsForEveryElement {
+    id element = @"Enterprise";
+    NSInvocation *invocation = [NSInvocation invocationWithTarget:[KWContainMatcher matcherWithSubject:nil] selector:@selector(contain:) messageArguments:&element];
+    KWPassMatcher *matcher = [KWPassMatcher matcherWithSubject:@[@[@"Enterprise"], @[@"Voyager", @"Enterprise"]]];
+    [matcher allPass:invocation matcherFactory:[self matcherFactory]];
+    XCTAssertTrue([matcher evaluate], @"expected positive match");
+}
+
+@end
+
+#endif // #if KW_TESTS_ENABLED
@@ -55,6 +55,27 @@
     XCTAssertTrue(spy2.wasNotified, @"expected object to notify spies");
 }
 
+- (void)testItShouldNotifySpiesOfMessagesToStubbedMethods {
+    Cruiser *cruiser = [Cruiser new];
+    TestSpy *spy = [TestSpy new];
+    KWMessagePattern *messagePattern = [KWMessagePattern messagePatternWithSelector:@selector(crewComplement)];
+    [cruiser stub:@selector(crewComplement) andReturn:theValue(42)];
+    [cruiser addMessageSpy:spy forMessagePattern:messagePattern];
+    XCTAssertEqual(cruiser.crewComplement, (NSUInteger)42, @"expected the stub to answer");
+    XCTAssertTrue(spy.wasNotified, @"expected spies added after stubs to be notified");
+}
+
+- (void)testItShouldAnswerStubbedMethodsDirectlyAgainOnceSpiesAreRemoved {
+    Cruiser *cruiser = [Cruiser new];
+    TestSpy *spy = [TestSpy new];
+    KWMessagePattern *messagePattern = [KWMessagePattern messagePatternWithSelector:@selector(crewComplement)];
+    [cruiser stub:@selector(crewComplement) andReturn:theValue(42)];
+    [cruiser addMessageSpy:spy forMessagePattern:messagePattern];
+    [cruiser removeMessageSpy:spy forMessagePattern:messagePattern];
+    XCTAssertEqual(cruiser.crewComplement, (NSUInteger)42, @"expected the stub to answer");
+    XCTAssertFalse(spy.wasNotified, @"expected removed spies not to be notified");
+}
+
 @end
 
 #endif // #if KW_TESTS_ENABLED
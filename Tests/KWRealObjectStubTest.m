@@ -11,6 +11,18 @@
 
 #if KW_TESTS_ENABLED
 
+@interface UnreferenceableCruiser : Cruiser
+
+@end
+
+@implementation UnreferenceableCruiser
+
+- (BOOL)allowsWeakReference {
+    return NO;
+}
+
+@end
+
 @interface KWRealObjectStubTest : XCTestCase
 
 @end
@@ -118,6 +130,65 @@
     XCTAssertEqual(shieldsRaised, YES, @"expected method implementation to be substituted");
 }
 
+- (void)testItShouldSubstituteMethodImplementationWithTypedBlock {
+    Cruiser *cruiser = [Cruiser new];
+    __block Cruiser *receiver = nil;
+    [cruiser stub:@selector(energyLevelInWarpCore:) withTypedBlock:^float(Cruiser *aCruiser, NSUInteger anIndex) {
+        receiver = aCruiser;
+        return anIndex * 2.0f;
+    }];
+    XCTAssertEqual([cruiser energyLevelInWarpCore:21], 42.0f, @"expected typed block to receive native arguments");
+    XCTAssertEqual(receiver, cruiser, @"expected typed block to receive the stubbed object");
+}
+
+- (void)testItShouldAnswerCommonSignaturesWithTypedBlocksWithoutForwarding {
+    Cruiser *cruiser = [Cruiser new];
+    __block NSUInteger calls = 0;
+    [cruiser stub:@selector(computeStarHashForKey:) withTypedBlock:^NSUInteger(Cruiser *aCruiser, NSUInteger aKey) {
+        ++calls;
+        return aKey == 0 ? 1 : 2 * [aCruiser computeStarHashForKey:aKey - 1];
+    }];
+    IMP implementation = class_getMethodImplementation(object_getClass(cruiser), @selector(computeStarHashForKey:));
+    XCTAssertTrue(implementation != KWRegularForwardingImplementation(), @"expected a direct implementation to be installed");
+    XCTAssertEqual([cruiser computeStarHashForKey:5], (NSUInteger)32, @"expected typed block to receive the stubbed object and native arguments");
+    XCTAssertEqual(calls, (NSUInteger)6, @"expected typed block to be called for every message");
+}
+
+- (void)testItShouldRaiseWhenStubbingWithAnIncompatibleTypedBlock {
+    Cruiser *cruiser = [Cruiser new];
+    XCTAssertThrows([cruiser stub:@selector(energyLevelInWarpCore:) withTypedBlock:^double(Cruiser *aCruiser, NSUInteger anIndex) {
+        return 0.0;
+    }], @"expected a block with a different return type to be rejected");
+    XCTAssertThrows([cruiser stub:@selector(energyLevelInWarpCore:) withTypedBlock:^float(Cruiser *aCruiser) {
+        return 0.0f;
+    }], @"expected a block with missing arguments to be rejected");
+}
+
+- (void)testItShouldAnswerCommonSignaturesWithoutForwarding {
+    Cruiser *cruiser = [Cruiser new];
+    [cruiser stub:@selector(computeStarHashForKey:) andReturn:theValue(42)];
+    IMP implementation = class_getMethodImplementation(object_getClass(cruiser), @selector(computeStarHashForKey:));
+    XCTAssertTrue(implementation != KWRegularForwardingImplementation(), @"expected a direct implementation to be installed");
+    XCTAssertEqual([cruiser computeStarHashForKey:7], (NSUInteger)42, @"expected method to be stubbed");
+    XCTAssertEqual([cruiser computeStarHashForKey:7], (NSUInteger)42, @"expected method to stay stubbed");
+}
+
+- (void)testItShouldForwardMethodsWithFloatingPointArguments {
+    Cruiser *cruiser = [Cruiser new];
+    [cruiser stub:@selector(orbitPeriodForMass:) andReturn:theValue(42.0f)];
+    IMP implementation = class_getMethodImplementation(object_getClass(cruiser), @selector(orbitPeriodForMass:));
+    XCTAssertTrue(implementation == KWRegularForwardingImplementation(), @"expected the forwarding implementation to be installed");
+    XCTAssertEqual([cruiser orbitPeriodForMass:1.0f], 42.0f, @"expected method to be stubbed");
+}
+
+- (void)testItShouldCallThroughDirectImplementationsWhenArgumentsDoNotMatch {
+    Cruiser *cruiser = [Cruiser new];
+    NSUInteger expectedHash = [cruiser computeStarHashForKey:8];
+    [cruiser stub:@selector(computeStarHashForKey:) andReturn:theValue(42) withArguments:theValue(7)];
+    XCTAssertEqual([cruiser computeStarHashForKey:7], (NSUInteger)42, @"expected matching call to be stubbed");
+    XCTAssertEqual([cruiser computeStarHashForKey:8], expectedHash, @"expected other calls to reach the original implementation");
+}
+
 - (void)testItShouldPreserveClassResultWhenInstanceMethodStubbed {
     id subject = [Cruiser new];
     Class originalClass = [subject class];
@@ -195,6 +266,61 @@
     XCTAssertEqual([cruiser classification], @"Enterprise", @"expected method to be stubbed with block");
 }
 
+- (void)testItShouldCallOriginalImplementationsOfUnstubbedMethodsWithoutRestoringTheClass {
+    Cruiser *cruiser = [Cruiser new];
+    KWMessagePattern *messagePattern = [KWMessagePattern messagePatternWithSelector:@selector(computeStarHashForKey:)];
+    KWInvocationJournal *journal = [cruiser invocationJournalForMessagePattern:messagePattern];
+    [journal beginWatching];
+
+    // The recursive calls are only recorded if the object stays intercepted
+    // while the original implementation runs.
+    XCTAssertEqual([cruiser computeStarHashForKey:8], (NSUInteger)15, @"expected the original implementation to be called");
+    XCTAssertEqual(journal.count, (NSUInteger)5, @"expected recursive calls to go through the intercept class");
+}
+
+- (void)testItShouldCallOriginalImplementationsWhenNoStubMatchesTheInvocation {
+    Cruiser *cruiser = [Cruiser new];
+    [cruiser stub:@selector(computeStarHashForKey:) andReturn:theValue(0) withArguments:theValue(100)];
+    KWMessagePattern *messagePattern = [KWMessagePattern messagePatternWithSelector:@selector(computeStarHashForKey:)];
+    KWInvocationJournal *journal = [cruiser invocationJournalForMessagePattern:messagePattern];
+    [journal beginWatching];
+
+    XCTAssertEqual([cruiser computeStarHashForKey:8], (NSUInteger)15, @"expected the original implementation to be called");
+    XCTAssertEqual(journal.count, (NSUInteger)5, @"expected recursive calls to go through the intercept class");
+    XCTAssertEqual([cruiser computeStarHashForKey:100], (NSUInteger)0, @"expected the stub to still match");
+}
+
+- (void)testItShouldFindStubsOfObjectsThatAreNotEqualToThemselves {
+    Cruiser *cruiser = [Cruiser new];
+    [cruiser stub:@selector(isEqual:) andReturn:theValue(NO)];
+    [cruiser stub:@selector(hash) andReturn:theValue(7)];
+    [cruiser stub:@selector(callsign) andReturn:@"Red 5"];
+    XCTAssertEqualObjects([cruiser callsign], @"Red 5", @"expected stubs to be found by object identity");
+}
+
+- (void)testItShouldCallOriginalImplementationsWithTheOriginalSelector {
+    Cruiser *cruiser = [Cruiser new];
+    [cruiser stub:@selector(nameOfSelectorForKey:) andReturn:@"stubbed" withArguments:theValue(100)];
+    XCTAssertEqualObjects([cruiser nameOfSelectorForKey:8], @"nameOfSelectorForKey:", @"expected the original implementation to see the original selector");
+}
+
+- (void)testItShouldStubObjectsThatDoNotAllowWeakReferences {
+    Cruiser *cruiser = [[[UnreferenceableCruiser alloc] init] autorelease];
+    [cruiser stub:@selector(callsign) andReturn:@"Red 5"];
+    XCTAssertEqualObjects([cruiser callsign], @"Red 5", @"expected objects that do not allow weak references to be stubbed");
+}
+
+- (void)testItShouldNotKeepStubbedObjectsAlive {
+    NSHashTable *cruisers = [NSHashTable weakObjectsHashTable];
+    Cruiser *cruiser = [[Cruiser alloc] init];
+    [cruisers addObject:cruiser];
+    [cruiser stub:@selector(callsign) andReturn:@"Red 5"];
+    [cruiser addMessageSpy:[[[TestSpy alloc] init] autorelease] forMessagePattern:[KWMessagePattern messagePatternWithSelector:@selector(raiseShields)]];
+    [cruiser invocationJournalForMessagePattern:[KWMessagePattern messagePatternWithSelector:@selector(raiseShields)]];
+    [cruiser release];
+    XCTAssertEqual([[cruisers allObjects] count], (NSUInteger)0, @"expected stubbed objects to be deallocated when released");
+}
+
 - (void)testStubSecureCodingOfDateClass {
     NSDate *date = [NSDate date];
     [NSDate stub:@selector(date) andReturn:date];
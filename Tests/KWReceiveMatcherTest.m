@@ -43,6 +43,16 @@
     XCTAssertTrue([matcher evaluate], @"expected positive match");
 }
 
+- (void)testItShouldNotCountMessagesReceivedBeforeTheExpectation {
+    id subject = [Cruiser new];
+    [subject stub:@selector(raiseShields)];
+    [subject raiseShields];
+    KWReceiveMatcher *matcher = [KWReceiveMatcher matcherWithSubject:subject];
+    [matcher receive:@selector(raiseShields) withCount:1];
+    [subject raiseShields];
+    XCTAssertTrue([matcher evaluate], @"expected positive match");
+}
+
 - (void)testItShouldMatchMultipleReceivedMessagesForReceiveWhenAttachedToNegativeVerifier {
     id subject = [Cruiser new];
     KWReceiveMatcher *matcher = [KWReceiveMatcher matcherWithSubject:subject];
@@ -0,0 +1,57 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import <Kiwi/Kiwi.h>
+#import "KiwiTestConfiguration.h"
+
+#if KW_TESTS_ENABLED
+
+@interface KWResultReporterTest : XCTestCase
+
+@end
+
+@implementation KWResultReporterTest
+
+- (NSString *)temporaryPath {
+    return [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+}
+
+- (NSString *)contentsOfReportAtPath:(NSString *)aPath reporterClass:(Class)aClass {
+    KWResultReporter *reporter = [KWResultReporter new];
+    [reporter addReporter:[[aClass alloc] initWithPath:aPath]];
+
+    KWCallSite *callSite = [KWCallSite callSiteWithFilename:@"CruiserSpec.m" lineNumber:42];
+    KWFailure *failure = [KWFailure failureWithCallSite:callSite message:@"expected <1010> & got <0>"];
+    [reporter reportResult:[[KWExampleResult alloc] initWithSpecName:@"CruiserSpec" selectorName:@"ACruiser_HasACrew" description:@"a cruiser, has a crew"
+                                                              status:KWExampleResultStatusFailed duration:0.5 failures:@[failure]]];
+    [reporter reportResult:[[KWExampleResult alloc] initWithSpecName:@"CruiserSpec" selectorName:@"ACruiser_Flies" description:@"a cruiser, flies"
+                                                              status:KWExampleResultStatusPassed duration:0.25 failures:nil]];
+    [reporter finishReporting];
+
+    NSString *contents = [NSString stringWithContentsOfFile:aPath encoding:NSUTF8StringEncoding error:NULL];
+    [[NSFileManager defaultManager] removeItemAtPath:aPath error:NULL];
+    return contents;
+}
+
+- (void)testItShouldWriteOneJSONObjectPerExample {
+    NSString *contents = [self contentsOfReportAtPath:[self temporaryPath] reporterClass:[KWJSONLinesReporter class]];
+    NSArray *lines = [[contents stringByTrimmingCharactersInSet:[NSCharacterSet newlineCharacterSet]] componentsSeparatedByString:@"\n"];
+    XCTAssertEqual([lines count], (NSUInteger)2, @"expected one line per example");
+
+    NSDictionary *object = [NSJSONSerialization JSONObjectWithData:[lines[0] dataUsingEncoding:NSUTF8StringEncoding] options:0 error:NULL];
+    XCTAssertEqualObjects(object[@"status"], @"failed", @"expected results in the order they were reported");
+    XCTAssertEqualObjects(object[@"failures"][0][@"line"], @42, @"expected failures to carry their call site");
+}
+
+- (void)testItShouldWriteJUnitSuitesPerSpec {
+    NSString *contents = [self contentsOfReportAtPath:[self temporaryPath] reporterClass:[KWJUnitReporter class]];
+    XCTAssertTrue([contents rangeOfString:@"<testsuite name=\"CruiserSpec\" tests=\"2\" failures=\"1\" skipped=\"0\""].location != NSNotFound, @"expected suite totals");
+    XCTAssertTrue([contents rangeOfString:@"&amp; got &lt;0&gt;"].location != NSNotFound, @"expected failure messages to be escaped");
+}
+
+@end
+
+#endif // #if KW_TESTS_ENABLED
@@ -0,0 +1,188 @@
+//
+// Licensed under the terms in License.txt
+//
+// Copyright 2010 Allen Ding. All rights reserved.
+//
+
+#import <Kiwi/Kiwi.h>
+#import "KiwiTestConfiguration.h"
+#import "TestClasses.h"
+
+#if KW_TESTS_ENABLED
+
+// Only fails while KWSpecRunnerTest runs it, so that XCTest sees it pass.
+static BOOL KWSpecRunnerTestShouldFail = NO;
+
+SPEC_BEGIN(KWSpecRunnerTestSpec)
+
+describe(@"a cruiser", ^{
+    it(@"has a crew", ^{
+        [[theValue([[Cruiser new] crewComplement]) should] equal:theValue(1010)];
+    });
+
+    it(@"fails when asked to", ^{
+        [[theValue(KWSpecRunnerTestShouldFail) should] beNo];
+    });
+});
+
+SPEC_END
+
+SPEC_BEGIN(KWSpecRunnerTestOtherSpec)
+
+describe(@"a carrier", ^{
+    it(@"is a ship", ^{
+        [[[Carrier new] should] beKindOfClass:[SpaceShip class]];
+    });
+});
+
+SPEC_END
+
+SPEC_BEGIN(KWSpecRunnerTestMultilineSpec)
+
+describe(@"a fighter", ^{
+    it(@"fails with a long story when asked to", ^{
+        if (KWSpecRunnerTestShouldFail)
+            fail(@"first line\nsecond line with a \\ backslash");
+    });
+});
+
+SPEC_END
+
+@interface KWSpecRunnerTest : XCTestCase
+
+@end
+
+@implementation KWSpecRunnerTest
+
+- (NSString *)runSpecClassesWithRunner:(KWSpecRunner **)aRunner {
+    return [self runSpecClasses:@[[KWSpecRunnerTestSpec class]] workerCount:1 runner:aRunner];
+}
+
+- (NSString *)runSpecClasses:(NSArray *)specClasses workerCount:(NSUInteger)workerCount runner:(KWSpecRunner **)aRunner {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    [[NSFileManager defaultManager] createFileAtPath:path contents:nil attributes:nil];
+    NSFileHandle *output = [NSFileHandle fileHandleForWritingAtPath:path];
+    KWSpecRunner *runner = [[KWSpecRunner alloc] initWithOutput:output];
+    [runner runSpecClasses:specClasses workerCount:workerCount];
+    [output closeFile];
+    *aRunner = runner;
+
+    NSString *contents = [NSString stringWithContentsOfFile:path encoding:NSUTF8StringEncoding error:NULL];
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+    return contents;
+}
+
+- (void)testItShouldFindSpecClasses {
+    XCTAssertTrue([[KWSpecRunner specClasses] containsObject:[KWSpecRunnerTestSpec class]], @"expected runner to find spec classes");
+    XCTAssertFalse([[KWSpecRunner specClasses] containsObject:[KWSpec class]], @"expected runner to skip KWSpec");
+}
+
+- (void)testItShouldRunExamplesWithoutXCTest {
+    KWSpecRunner *runner = nil;
+    NSString *output = [self runSpecClassesWithRunner:&runner];
+    XCTAssertEqual(runner.exampleCount, (NSUInteger)2, @"expected runner to run every example");
+    XCTAssertEqual(runner.failureCount, (NSUInteger)0, @"expected examples to pass");
+    XCTAssertTrue([output rangeOfString:@"PASS -[KWSpecRunnerTestSpec "].location != NSNotFound, @"expected runner to report passing examples");
+}
+
+- (void)testItShouldReportFailures {
+    KWSpecRunnerTestShouldFail = YES;
+    KWSpecRunner *runner = nil;
+    NSString *output = [self runSpecClassesWithRunner:&runner];
+    KWSpecRunnerTestShouldFail = NO;
+
+    XCTAssertEqual(runner.failureCount, (NSUInteger)1, @"expected one example to fail");
+    XCTAssertTrue([output rangeOfString:@"KWSpecRunnerTest.m:"].location != NSNotFound, @"expected failures to carry their call site");
+    XCTAssertTrue([output rangeOfString:@"2 examples, 1 failures"].location != NSNotFound, @"expected runner to summarize results");
+}
+
+- (void)testItShouldRunSpecClassesInWorkerProcesses {
+    KWSpecRunner *runner = nil;
+    NSArray *specClasses = @[[KWSpecRunnerTestSpec class], [KWSpecRunnerTestOtherSpec class]];
+    NSString *output = [self runSpecClasses:specClasses workerCount:2 runner:&runner];
+    XCTAssertEqual(runner.exampleCount, (NSUInteger)3, @"expected workers to run every example once");
+    XCTAssertEqual(runner.failureCount, (NSUInteger)0, @"expected examples to pass");
+    XCTAssertTrue([output rangeOfString:@"PASS -[KWSpecRunnerTestOtherSpec "].location != NSNotFound, @"expected worker results to be forwarded");
+}
+
+- (void)testItShouldReportEveryExampleRunInWorkerProcessesOnce {
+    NSString *reportPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    KWJSONLinesReporter *reporter = [[KWJSONLinesReporter alloc] initWithPath:reportPath];
+    [[KWResultReporter sharedReporter] addReporter:reporter];
+
+    KWSpecRunner *runner = nil;
+    NSArray *specClasses = @[[KWSpecRunnerTestSpec class], [KWSpecRunnerTestOtherSpec class]];
+    [self runSpecClasses:specClasses workerCount:2 runner:&runner];
+    [[KWResultReporter sharedReporter] removeReporter:reporter];
+
+    NSString *contents = [NSString stringWithContentsOfFile:reportPath encoding:NSUTF8StringEncoding error:NULL];
+    [[NSFileManager defaultManager] removeItemAtPath:reportPath error:NULL];
+    NSMutableArray *examples = [NSMutableArray array];
+
+    for (NSString *line in [contents componentsSeparatedByString:@"\n"]) {
+        if ([line length] == 0)
+            continue;
+
+        NSDictionary *object = [NSJSONSerialization JSONObjectWithData:[line dataUsingEncoding:NSUTF8StringEncoding] options:0 error:NULL];
+        [examples addObject:[NSString stringWithFormat:@"%@/%@", object[@"spec"], object[@"example"]]];
+    }
+
+    XCTAssertEqual([examples count], (NSUInteger)3, @"expected one record per example");
+    XCTAssertEqual([[NSSet setWithArray:examples] count], (NSUInteger)3, @"expected no example to be recorded twice");
+}
+
+- (void)testItShouldReportMultilineFailuresFromWorkerProcessesWhole {
+    NSString *reportPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    KWJSONLinesReporter *reporter = [[KWJSONLinesReporter alloc] initWithPath:reportPath];
+    [[KWResultReporter sharedReporter] addReporter:reporter];
+
+    KWSpecRunnerTestShouldFail = YES;
+    KWSpecRunner *runner = nil;
+    NSString *output = [self runSpecClasses:@[[KWSpecRunnerTestMultilineSpec class], [KWSpecRunnerTestOtherSpec class]] workerCount:2 runner:&runner];
+    KWSpecRunnerTestShouldFail = NO;
+    [[KWResultReporter sharedReporter] removeReporter:reporter];
+
+    NSString *contents = [NSString stringWithContentsOfFile:reportPath encoding:NSUTF8StringEncoding error:NULL];
+    [[NSFileManager defaultManager] removeItemAtPath:reportPath error:NULL];
+    NSString *message = nil;
+
+    for (NSString *line in [contents componentsSeparatedByString:@"\n"]) {
+        if ([line length] == 0)
+            continue;
+
+        NSDictionary *object = [NSJSONSerialization JSONObjectWithData:[line dataUsingEncoding:NSUTF8StringEncoding] options:0 error:NULL];
+        if ([object[@"failures"] count] > 0)
+            message = object[@"failures"][0][@"message"];
+    }
+
+    XCTAssertEqual(runner.failureCount, (NSUInteger)1, @"expected one example to fail");
+    XCTAssertEqualObjects(message, @"first line\nsecond line with a \\ backslash", @"expected the whole failure message to be reported");
+    XCTAssertTrue([output rangeOfString:@"error: first line\nsecond line"].location != NSNotFound, @"expected the failure message to be shown as it is");
+}
+
+- (void)testItShouldStartWithSpecClassesThatFailedLastRun {
+    NSString *historyPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    [@"9.0 PASS KWSpecRunnerTestSpec/Slow\n0.1 FAIL KWSpecRunnerTestOtherSpec/ACarrier_IsAShip\n" writeToFile:historyPath atomically:YES encoding:NSUTF8StringEncoding error:NULL];
+
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    [[NSFileManager defaultManager] createFileAtPath:path contents:nil attributes:nil];
+    NSFileHandle *output = [NSFileHandle fileHandleForWritingAtPath:path];
+    KWSpecRunner *runner = [[KWSpecRunner alloc] initWithOutput:output];
+    runner.historyPath = historyPath;
+    [runner runSpecClasses:@[[KWSpecRunnerTestSpec class], [KWSpecRunnerTestOtherSpec class]]];
+    [output closeFile];
+
+    NSString *contents = [NSString stringWithContentsOfFile:path encoding:NSUTF8StringEncoding error:NULL];
+    NSString *history = [NSString stringWithContentsOfFile:historyPath encoding:NSUTF8StringEncoding error:NULL];
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+    [[NSFileManager defaultManager] removeItemAtPath:historyPath error:NULL];
+
+    NSRange other = [contents rangeOfString:@"-[KWSpecRunnerTestOtherSpec "];
+    NSRange spec = [contents rangeOfString:@"-[KWSpecRunnerTestSpec "];
+    XCTAssertTrue(other.location < spec.location, @"expected spec classes that failed last run to go first");
+    XCTAssertTrue([history rangeOfString:@" PASS KWSpecRunnerTestOtherSpec/"].location != NSNotFound, @"expected runner to record example results");
+}
+
+@end
+
+#endif // #if KW_TESTS_ENABLED
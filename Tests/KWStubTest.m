@@ -51,6 +51,56 @@
     XCTAssertEqual(crewComplement, (NSUInteger)42, @"expected stub to write return value");
 }
 
+- (void)testItShouldWriteWrappedInvocationReturnValuesOnRepeatedInvocations {
+    id subject = [Cruiser new];
+    KWMessagePattern *messagePattern = [KWMessagePattern messagePatternWithSelector:@selector(crewComplement)];
+    id stub = [KWStub stubWithMessagePattern:messagePattern value:[KWValue valueWithUnsignedInt:42]];
+
+    for (NSUInteger i = 0; i < 3; ++i) {
+        id invocation = [NSInvocation invocationWithTarget:subject selector:@selector(crewComplement)];
+        [stub processInvocation:invocation];
+        NSUInteger crewComplement = 0;
+        [invocation getReturnValue:&crewComplement];
+        XCTAssertEqual(crewComplement, (NSUInteger)42, @"expected stub to write return value on every invocation");
+    }
+}
+
+- (void)testItShouldConvertTheSecondWrappedValueAfterTheGivenTimes {
+    id subject = [Cruiser new];
+    KWMessagePattern *messagePattern = [KWMessagePattern messagePatternWithSelector:@selector(crewComplement)];
+    id stub = [KWStub stubWithMessagePattern:messagePattern
+                                       value:[KWValue valueWithInt:42]
+                                       times:@1
+                             afterThatReturn:[KWValue valueWithInt:7]];
+    NSUInteger crewComplements[2] = { 0, 0 };
+
+    for (NSUInteger i = 0; i < 2; ++i) {
+        id invocation = [NSInvocation invocationWithTarget:subject selector:@selector(crewComplement)];
+        [stub processInvocation:invocation];
+        [invocation getReturnValue:&crewComplements[i]];
+    }
+
+    XCTAssertEqual(crewComplements[0], (NSUInteger)42, @"expected stub to write the first value");
+    XCTAssertEqual(crewComplements[1], (NSUInteger)7, @"expected stub to write the converted second value");
+}
+
+- (void)testItShouldWriteTheLatestBlockResultForWrappedReturnValues {
+    id subject = [Cruiser new];
+    __block unsigned int nextCrewComplement = 1;
+    KWMessagePattern *messagePattern = [KWMessagePattern messagePatternWithSelector:@selector(crewComplement)];
+    id stub = [KWStub stubWithMessagePattern:messagePattern block:^id(NSArray *params) {
+        return [KWValue valueWithUnsignedInt:nextCrewComplement++];
+    }];
+
+    for (NSUInteger i = 1; i <= 2; ++i) {
+        id invocation = [NSInvocation invocationWithTarget:subject selector:@selector(crewComplement)];
+        [stub processInvocation:invocation];
+        NSUInteger crewComplement = 0;
+        [invocation getReturnValue:&crewComplement];
+        XCTAssertEqual(crewComplement, i, @"expected stub to write the value returned by the block");
+    }
+}
+
 - (void)testItShouldWriteObjectInvocationReturnValues {
     id subject = [Cruiser new];
     KWMessagePattern *messagePattern = [KWMessagePattern messagePatternWithSelector:@selector(callsign)];
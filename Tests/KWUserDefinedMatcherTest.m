@@ -60,6 +60,27 @@
     XCTAssertTrue([matcher evaluate], @"expected subject to match yielded argument");
 }
 
+- (void)testShouldYieldMessageArgumentsOfAnyTypeToTheBlock
+{
+    __block double blockValue = 0.0;
+    __block id blockOther = nil;
+
+    KWUserDefinedMatcher *matcher = [KWUserDefinedMatcher matcherWithSubject:@"string" block:^BOOL(id subject, double value, id other) {
+        blockValue = value;
+        blockOther = other;
+        return value > 1.0 && [other isEqualToString:subject];
+    }];
+    matcher.selector = NSSelectorFromString(@"haveValue:andString:");
+
+    IMP imp = [matcher methodForSelector:matcher.selector];
+    void (*func)(id, SEL, double, id) = (void *)imp;
+    func(matcher, matcher.selector, 1.5, @"string");
+
+    XCTAssertTrue([matcher evaluate], @"expected typed arguments to be yielded");
+    XCTAssertEqual(blockValue, 1.5, @"expected double argument to be yielded as is");
+    XCTAssertEqualObjects(blockOther, @"string", @"expected object argument to be yielded");
+}
+
 @end
 
 #pragma mark -
@@ -113,6 +134,52 @@
     XCTAssertEqualObjects(@"failure message containing subject foo", [matcher failureMessageForShouldNot], @"should set failure message for should");
 }
 
+- (void)testShouldBuildANewMatcherForEverySubject
+{
+    KWUserDefinedMatcherBuilder *builder = [KWUserDefinedMatcherBuilder builderForSelector:NSSelectorFromString(@"equalTheString:")];
+
+    [builder match:^BOOL(id subject, id object) {
+        return [subject isEqual:object];
+    }];
+
+    KWUserDefinedMatcher *matcher = [builder buildMatcherWithSubject:@"foo"];
+    KWUserDefinedMatcher *otherMatcher = [builder buildMatcherWithSubject:@"bar"];
+    XCTAssertTrue(matcher != otherMatcher, @"expected a new matcher for every subject");
+
+    void (*func)(id, SEL, id) = (void *)[matcher methodForSelector:matcher.selector];
+    func(matcher, matcher.selector, @"foo");
+    func(otherMatcher, otherMatcher.selector, @"foo");
+
+    XCTAssertTrue([matcher evaluate], @"expected positive match");
+    XCTAssertFalse([otherMatcher evaluate], @"expected matchers not to share arguments");
+}
+
+- (void)testShouldCompileTheMessageSignatureFromTheMatchBlock
+{
+    KWUserDefinedMatcherBuilder *builder = [KWUserDefinedMatcherBuilder builderForSelector:NSSelectorFromString(@"haveValue:withinRange:andName:")];
+
+    [builder match:^BOOL(id subject, double value, NSRange range) {
+        return YES;
+    }];
+
+    NSMethodSignature *signature = [[builder descriptor] methodSignature];
+    XCTAssertEqual([signature numberOfArguments], (NSUInteger)5, @"expected an argument for every selector parameter");
+    XCTAssertEqual(strcmp([signature getArgumentTypeAtIndex:2], @encode(double)), 0, @"expected argument type from the block");
+    XCTAssertEqual(strcmp([signature getArgumentTypeAtIndex:3], @encode(NSRange)), 0, @"expected argument type from the block");
+    XCTAssertEqual(strcmp([signature getArgumentTypeAtIndex:4], @encode(id)), 0, @"expected object for arguments the block does not take");
+}
+
+- (void)testShouldRaiseWhenTheMatchBlockTakesMoreArgumentsThanTheMessage
+{
+    KWUserDefinedMatcherBuilder *builder = [KWUserDefinedMatcherBuilder builderForSelector:NSSelectorFromString(@"beFoo")];
+
+    [builder match:^BOOL(id subject, id object) {
+        return YES;
+    }];
+
+    XCTAssertThrowsSpecificNamed([builder descriptor], NSException, @"KWMatcherException", @"expected extra block arguments to raise");
+}
+
 @end
 
 #endif
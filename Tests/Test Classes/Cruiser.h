@@ -52,6 +52,7 @@
 
 // starHash => key/2 + key/4 + key/8 + ... 1
 - (NSUInteger)computeStarHashForKey:(NSUInteger)aKey;
+- (NSString *)nameOfSelectorForKey:(NSUInteger)aKey;
 
 #pragma mark -
 #pragma mark Orbiting
@@ -99,6 +99,10 @@
     return aKey + [self computeStarHashForKey:aKey/2];
 }
 
+- (NSString *)nameOfSelectorForKey:(NSUInteger)aKey {
+    return NSStringFromSelector(_cmd);
+}
+
 #pragma mark -
 #pragma mark Orbiting
 